@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "artifact_cache.h"
+#include "file_utils.h"
+#include "net_utils.h"
+
+namespace {
+
+// Time after which an unresponsive remote cache is given up on.
+constexpr uint32_t REMOTE_TIMEOUT_MS = 10000u;
+
+}
+
+artifact_cache::artifact_cache(const std::string &local_dir,
+                               const std::string &remote_url)
+    : local_dir_(local_dir),
+      remote_url_(remote_url) {
+  while (!remote_url_.empty() && remote_url_.back() == '/') {
+    remote_url_.pop_back();
+  }
+}
+
+std::string artifact_cache::local_path(const std::string &key) const {
+  // Spread the artifacts over subfolders to keep folder sizes manageable.
+  return local_dir_ + PATH_SEPARATOR + key.substr(0, 2) + PATH_SEPARATOR + key;
+}
+
+bool artifact_cache::get(const std::string &key, std::string &data) {
+  if (keep_in_memory_) {
+    auto it = memory_.find(key);
+    if (it != memory_.end()) {
+      data = it->second;
+      used_in_memory_.insert(key);
+      ++memory_hits_;
+      return true;
+    }
+  }
+  if (!local_dir_.empty() && try_read_file(local_path(key).c_str(), data)) {
+    ++local_hits_;
+    if (keep_in_memory_) {
+      memory_[key] = data;
+      used_in_memory_.insert(key);
+    }
+    return true;
+  }
+  if (!remote_url_.empty() && !remote_failed_) {
+    const int status = http_request("GET", remote_url_ + "/" + key, "",
+                                    REMOTE_TIMEOUT_MS, data);
+    if (status == 200) {
+      ++remote_hits_;
+      bytes_fetched_ += data.size();
+      if (keep_in_memory_) {
+        memory_[key] = data;
+        used_in_memory_.insert(key);
+      }
+      if (!local_dir_.empty()) {
+        write_file_atomically(local_path(key).c_str(), data);
+      }
+      return true;
+    } else if (status != 404) {
+      // Don't keep retrying an unreachable or misbehaving server, just build
+      // everything locally.
+      fprintf(stderr, "Remote cache at %s is unavailable (status %d)\n",
+              remote_url_.c_str(), status);
+      remote_failed_ = true;
+    }
+  }
+  ++misses_;
+  return false;
+}
+
+void artifact_cache::put(const std::string &key, const std::string &data) {
+  if (keep_in_memory_) {
+    memory_[key] = data;
+    used_in_memory_.insert(key);
+  }
+  if (!local_dir_.empty() &&
+      !write_file_atomically(local_path(key).c_str(), data)) {
+    fprintf(stderr, "Failed to write to cache folder %s\n", local_dir_.c_str());
+  }
+  if (!remote_url_.empty() && !remote_failed_) {
+    std::string response;
+    const int status = http_request("PUT", remote_url_ + "/" + key, data,
+                                    REMOTE_TIMEOUT_MS, response);
+    if (status < 200 || status >= 300) {
+      fprintf(stderr, "Failed to upload to remote cache at %s (status %d)\n",
+              remote_url_.c_str(), status);
+      remote_failed_ = true;
+    } else {
+      ++uploads_;
+      bytes_uploaded_ += data.size();
+    }
+  }
+}
+
+void artifact_cache::evict_unused() {
+  for (auto it = memory_.begin(); it != memory_.end();) {
+    if (used_in_memory_.count(it->first) == 0u) {
+      it = memory_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  used_in_memory_.clear();
+}
+
+void artifact_cache::print_stats(FILE *f) const {
+  const uint32_t hits = memory_hits_ + local_hits_ + remote_hits_;
+  const uint32_t lookups = hits + misses_;
+  if (keep_in_memory_) fprintf(f, "Cache: %u memory hits\n", memory_hits_);
+  fprintf(f,
+          "Cache: %u lookups, %u local hits, %u remote hits, %u misses "
+          "(%.1f%% hit rate); %llu bytes fetched, %u uploads, "
+          "%llu bytes uploaded\n",
+          lookups, local_hits_, remote_hits_, misses_,
+          lookups > 0u ? 100.0 * hits / lookups : 0.0,
+          (unsigned long long)bytes_fetched_, uploads_,
+          (unsigned long long)bytes_uploaded_);
+}
+
+void artifact_cache::reset_stats() {
+  memory_hits_ = local_hits_ = remote_hits_ = misses_ = uploads_ = 0u;
+  bytes_fetched_ = bytes_uploaded_ = 0u;
+}
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// A content-addressed store for intermediate and final build artifacts.
+// Artifacts are looked up in a local directory first (if one is configured),
+// then on a remote HTTP server (if one is configured). Artifacts fetched from
+// the server are saved to the local directory, and newly built artifacts are
+// uploaded to both.
+//
+// The remote protocol is plain HTTP: `GET <url>/<key>' returns the artifact
+// with status 200, or status 404 if it's not in the cache; `PUT <url>/<key>'
+// stores the request body as the artifact.
+//
+// Long-running processes may additionally keep artifacts in memory, which is
+// checked before any other storage.
+class artifact_cache {
+public:
+  artifact_cache(const std::string &local_dir, const std::string &remote_url);
+
+  // Returns true if the cache has any storage configured.
+  bool enabled() const {
+    return keep_in_memory_ || !local_dir_.empty() || !remote_url_.empty();
+  }
+
+  // Enables keeping artifacts in memory for the lifetime of the cache.
+  void keep_in_memory() { keep_in_memory_ = true; }
+
+  // Drops the artifacts kept in memory that haven't been looked up or stored
+  // since the previous call, so that memory use stays bounded by what a
+  // single build needs.
+  void evict_unused();
+
+  // Looks up an artifact. Returns true and fills in `data' on a hit.
+  bool get(const std::string &key, std::string &data);
+
+  // Stores an artifact.
+  void put(const std::string &key, const std::string &data);
+
+  // Prints hit and miss statistics.
+  void print_stats(FILE *f) const;
+
+  // Resets the statistics, e.g. before starting another build.
+  void reset_stats();
+
+private:
+  std::string local_path(const std::string &key) const;
+
+  std::string local_dir_;
+  std::string remote_url_;
+  bool remote_failed_ = false;
+  bool keep_in_memory_ = false;
+  std::unordered_map<std::string, std::string> memory_;
+  std::unordered_set<std::string> used_in_memory_;
+  uint32_t memory_hits_ = 0u;
+  uint32_t local_hits_ = 0u;
+  uint32_t remote_hits_ = 0u;
+  uint32_t misses_ = 0u;
+  uint32_t uploads_ = 0u;
+  uint64_t bytes_fetched_ = 0u;
+  uint64_t bytes_uploaded_ = 0u;
+};
+
+// Version of the cache key scheme. Bump this whenever a change to the compiler
+// would change its outputs for the same inputs.
+constexpr uint32_t ARTIFACT_CACHE_VERSION = 1u;
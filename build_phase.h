@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Phases of a build that resource usage is attributed to.
+enum class build_phase : uint32_t {
+  other,
+  parse,          // Reading the input and parsing techniques.
+  dxc,            // Preprocessing and HLSL-to-SPIR-V compilation.
+  reflection,     // Reflecting SPIR-V and building pipeline layouts.
+  cross_compile,  // Generating code for the targets.
+  write,          // Assembling metadata and writing out files.
+  count
+};
+
+// Returns the name used for the phase in reports.
+inline const char* build_phase_name(build_phase phase) {
+  static const char *NAMES[(uint32_t)build_phase::count] = {
+    "other", "parse", "dxc", "reflection", "cross_compile", "write"
+  };
+  return NAMES[(uint32_t)phase];
+}
@@ -0,0 +1,356 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define SPV_ENABLE_UTILITY_CODE
+#include "cbuffer_layout.h"
+#include "spirv_cross.hpp"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+namespace {
+
+// Name prefix that DXC gives to the types of cbuffers.
+const char CBUFFER_TYPE_PREFIX[] = "type.";
+
+uint32_t round_up(uint32_t value, uint32_t alignment) {
+  return (value + alignment - 1u) / alignment * alignment;
+}
+
+// Computes where a member of the given type may be placed. Arrays, matrices
+// and structures are aligned to 16 bytes and may not be followed by other
+// members within the same 16 bytes, as in std140.
+void placement_rules(const spirv_cross::SPIRType &type,
+                     uint32_t size,
+                     uint32_t &alignment,
+                     uint32_t &footprint) {
+  const uint32_t component_size = std::max(type.width / 8u, 1u);
+  const uint32_t vector_alignment =
+      component_size * (type.vecsize == 3u ? 4u : type.vecsize);
+  const bool is_aggregate = !type.array.empty() || type.columns > 1u ||
+                            type.basetype == spirv_cross::SPIRType::Struct;
+  if (is_aggregate) {
+    alignment = std::max(vector_alignment, 16u);
+    footprint = round_up(size, alignment);
+  } else {
+    alignment = vector_alignment;
+    footprint = size;
+  }
+}
+
+}
+
+uint32_t cbuffer_layout::padding() const {
+  uint32_t used = 0u;
+  for (const cbuffer_member &m : members) used += m.size;
+  return size > used ? size - used : 0u;
+}
+
+bool cbuffer_layout::same_as(const cbuffer_layout &other) const {
+  if (size != other.size || members.size() != other.members.size()) {
+    return false;
+  }
+  for (size_t m = 0u; m < members.size(); ++m) {
+    if (members[m].name != other.members[m].name ||
+        members[m].offset != other.members[m].offset ||
+        members[m].size != other.members[m].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<cbuffer_layout> reflect_cbuffer_layouts(
+    const std::vector<uint32_t> &spirv_code) {
+  spirv_cross::Compiler compiler(spirv_code);
+  std::vector<cbuffer_layout> layouts;
+  for (const spirv_cross::Resource &r :
+       compiler.get_shader_resources().uniform_buffers) {
+    const spirv_cross::SPIRType &type = compiler.get_type(r.base_type_id);
+    cbuffer_layout layout;
+    layout.name = r.name;
+    if (layout.name.compare(0u, sizeof(CBUFFER_TYPE_PREFIX) - 1u,
+                            CBUFFER_TYPE_PREFIX) == 0) {
+      layout.name = layout.name.substr(sizeof(CBUFFER_TYPE_PREFIX) - 1u);
+    }
+    layout.set = compiler.get_decoration(r.id, spv::DecorationDescriptorSet);
+    layout.binding = compiler.get_decoration(r.id, spv::DecorationBinding);
+    layout.type_id = type.self;
+    for (uint32_t m = 0u; m < (uint32_t)type.member_types.size(); ++m) {
+      cbuffer_member member;
+      member.name = compiler.get_member_name(type.self, m);
+      member.index = m;
+      member.offset =
+          compiler.get_member_decoration(type.self, m, spv::DecorationOffset);
+      member.size =
+          (uint32_t)compiler.get_declared_struct_member_size(type, m);
+      placement_rules(compiler.get_type(type.member_types[m]),
+                      member.size, member.alignment, member.footprint);
+      layout.size = std::max(layout.size, member.offset + member.size);
+      layout.members.emplace_back(std::move(member));
+    }
+    std::sort(layout.members.begin(), layout.members.end(),
+              [](const cbuffer_member &a, const cbuffer_member &b) {
+                return a.offset < b.offset;
+              });
+    layouts.emplace_back(std::move(layout));
+  }
+  return layouts;
+}
+
+cbuffer_layout pack_cbuffer_layout(const cbuffer_layout &layout) {
+  // Place the members with the strictest alignment first, then fill the gaps
+  // between them with the smaller ones, always taking the lowest free offset.
+  // Ties are broken by declaration order, so that identical declarations are
+  // always packed identically.
+  std::vector<cbuffer_member> members = layout.members;
+  std::sort(members.begin(), members.end(),
+            [](const cbuffer_member &a, const cbuffer_member &b) {
+              if (a.alignment != b.alignment) return a.alignment > b.alignment;
+              if (a.footprint != b.footprint) return a.footprint > b.footprint;
+              return a.index < b.index;
+            });
+  std::vector<const cbuffer_member*> placed;
+  cbuffer_layout packed = layout;
+  packed.size = 0u;
+  for (cbuffer_member &m : members) {
+    uint32_t offset = 0u;
+    for (bool moved = true; moved;) {
+      moved = false;
+      offset = round_up(offset, m.alignment);
+      for (const cbuffer_member *p : placed) {
+        if (offset < p->offset + p->footprint &&
+            p->offset < offset + std::max(m.footprint, 1u)) {
+          offset = p->offset + p->footprint;
+          moved = true;
+        }
+      }
+    }
+    m.offset = offset;
+    packed.size = std::max(packed.size, m.offset + m.size);
+    placed.push_back(&m);
+  }
+  if (packed.size >= layout.size) return layout;
+  std::sort(members.begin(), members.end(),
+            [](const cbuffer_member &a, const cbuffer_member &b) {
+              return a.offset < b.offset;
+            });
+  packed.members = std::move(members);
+  return packed;
+}
+
+bool apply_cbuffer_layout(std::vector<uint32_t> &spirv_code,
+                          const cbuffer_layout &layout) {
+  constexpr size_t HEADER_SIZE = 5u;
+  if (spirv_code.size() < HEADER_SIZE || spirv_code[0] != spv::MagicNumber) {
+    return false;
+  }
+  const uint32_t target = layout.type_id;
+  const uint32_t nmembers = (uint32_t)layout.members.size();
+  std::vector<uint32_t> new_indices(nmembers), new_offsets(nmembers);
+  for (uint32_t m = 0u; m < nmembers; ++m) {
+    if (layout.members[m].index >= nmembers) return false;
+    new_indices[layout.members[m].index] = m;
+    new_offsets[layout.members[m].index] = layout.members[m].offset;
+  }
+
+  // Collect the types of all values, the types that composite types are made
+  // of, and the values of all 32-bit constants.
+  std::unordered_map<uint32_t, uint32_t> value_types;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> struct_members;
+  std::unordered_map<uint32_t, uint32_t> element_types;
+  std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> constants;
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> constant_ids;
+  size_t first_function_pos = 0u;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (word_count == 0u || pos + word_count > spirv_code.size()) return false;
+    const uint32_t *operands = &spirv_code[pos + 1u];
+    switch (op) {
+    case spv::OpTypeStruct:
+      struct_members[operands[0]].assign(operands + 1u,
+                                         operands + word_count - 1u);
+      break;
+    case spv::OpTypePointer:
+      element_types[operands[0]] = operands[2];
+      break;
+    case spv::OpTypeArray:
+    case spv::OpTypeRuntimeArray:
+    case spv::OpTypeVector:
+    case spv::OpTypeMatrix:
+      element_types[operands[0]] = operands[1];
+      break;
+    case spv::OpConstant:
+      if (word_count == 4u) {
+        constants[operands[1]] = std::make_pair(operands[0], operands[2]);
+        constant_ids.emplace(std::make_pair(operands[0], operands[2]),
+                             operands[1]);
+      }
+      break;
+    case spv::OpFunction:
+      if (first_function_pos == 0u) first_function_pos = pos;
+      break;
+    default:
+      break;
+    }
+    bool has_result = false, has_result_type = false;
+    spv::HasResultAndType(op, &has_result, &has_result_type);
+    if (has_result && has_result_type) value_types[operands[1]] = operands[0];
+    pos += word_count;
+  }
+  auto target_members = struct_members.find(target);
+  if (target_members == struct_members.end() ||
+      target_members->second.size() != nmembers) {
+    return false;
+  }
+  if (first_function_pos == 0u) first_function_pos = spirv_code.size();
+
+  // Constants that need to be added for the new member indices.
+  std::vector<uint32_t> new_constants;
+  uint32_t &id_bound = spirv_code[3];
+  auto get_constant = [&](uint32_t type, uint32_t value) {
+    auto it = constant_ids.find(std::make_pair(type, value));
+    if (it != constant_ids.end()) return it->second;
+    const uint32_t id = id_bound++;
+    new_constants.insert(new_constants.end(), {
+      (4u << 16u) | spv::OpConstant, type, id, value
+    });
+    constant_ids.emplace(std::make_pair(type, value), id);
+    return id;
+  };
+
+  // Follows a chain of indices into a composite type, remapping the indices
+  // that select members of the target. Indices are either literals or the
+  // ids of constants. Returns false if a member index can't be determined.
+  auto remap_indices = [&](uint32_t type, uint32_t *indices, uint32_t count,
+                           bool literal_indices) {
+    for (uint32_t i = 0u; i < count; ++i) {
+      auto members = struct_members.find(type);
+      if (members == struct_members.end()) {
+        auto element = element_types.find(type);
+        if (element == element_types.end()) return false;
+        type = element->second;
+        continue;
+      }
+      uint32_t member = indices[i];
+      uint32_t constant_type = 0u;
+      if (!literal_indices) {
+        auto constant = constants.find(indices[i]);
+        if (constant == constants.end()) return false;
+        constant_type = constant->second.first;
+        member = constant->second.second;
+      }
+      if (member >= members->second.size()) return false;
+      if (type == target) {
+        indices[i] = literal_indices
+            ? new_indices[member]
+            : get_constant(constant_type, new_indices[member]);
+      }
+      type = members->second[member];
+    }
+    return true;
+  };
+
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    uint32_t *operands = &spirv_code[pos + 1u];
+    const uint32_t noperands = word_count - 1u;
+    switch (op) {
+    case spv::OpTypeStruct:
+      if (operands[0] == target) {
+        for (uint32_t m = 0u; m < nmembers; ++m) {
+          operands[1u + m] =
+              target_members->second[layout.members[m].index];
+        }
+      }
+      break;
+    case spv::OpMemberName:
+    case spv::OpMemberDecorate:
+    case spv::OpMemberDecorateString:
+      if (operands[0] == target) {
+        const uint32_t member = operands[1];
+        if (member >= nmembers) return false;
+        operands[1] = new_indices[member];
+        if (op == spv::OpMemberDecorate &&
+            operands[2] == spv::DecorationOffset) {
+          operands[3] = new_offsets[member];
+        }
+      }
+      break;
+    case spv::OpAccessChain:
+    case spv::OpInBoundsAccessChain:
+    case spv::OpPtrAccessChain:
+    case spv::OpInBoundsPtrAccessChain: {
+      auto base_type = value_types.find(operands[2]);
+      if (base_type == value_types.end()) return false;
+      auto pointee = element_types.find(base_type->second);
+      if (pointee == element_types.end()) return false;
+      // The first index of a pointer access chain selects an element of the
+      // array that the base points into, not a member.
+      const uint32_t first_index =
+          (op == spv::OpPtrAccessChain || op == spv::OpInBoundsPtrAccessChain)
+              ? 4u : 3u;
+      if (noperands > first_index &&
+          !remap_indices(pointee->second, operands + first_index,
+                         noperands - first_index, false)) {
+        return false;
+      }
+      break;
+    }
+    case spv::OpCompositeExtract:
+    case spv::OpCompositeInsert: {
+      const uint32_t composite = op == spv::OpCompositeExtract ? 2u : 3u;
+      auto composite_type = value_types.find(operands[composite]);
+      if (composite_type == value_types.end()) return false;
+      if (!remap_indices(composite_type->second, operands + composite + 1u,
+                         noperands - composite - 1u, true)) {
+        return false;
+      }
+      break;
+    }
+    case spv::OpCompositeConstruct:
+    case spv::OpConstantComposite:
+    case spv::OpSpecConstantComposite:
+      if (operands[0] == target) {
+        if (noperands != 2u + nmembers) return false;
+        const std::vector<uint32_t> constituents(operands + 2u,
+                                                 operands + noperands);
+        for (uint32_t m = 0u; m < nmembers; ++m) {
+          operands[2u + m] = constituents[layout.members[m].index];
+        }
+      }
+      break;
+    default:
+      break;
+    }
+    pos += word_count;
+  }
+
+  // Function bodies follow all global declarations, so new constants can be
+  // declared right before the first function.
+  spirv_code.insert(spirv_code.begin() + first_function_pos,
+                    new_constants.begin(), new_constants.end());
+  return true;
+}
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A member of a uniform buffer block.
+struct cbuffer_member {
+  std::string name;
+  uint32_t index;     // Position of the member in the original declaration.
+  uint32_t offset;    // Offset from the start of the block, in bytes.
+  uint32_t size;      // Size of the member, in bytes.
+  uint32_t alignment; // Alignment the member may be moved to.
+  uint32_t footprint; // Bytes the member occupies, including trailing padding
+                      // that other members may not be placed into.
+};
+
+// Memory layout of a uniform buffer (HLSL cbuffer) declared by a shader.
+struct cbuffer_layout {
+  std::string name;
+  uint32_t set = 0u;
+  uint32_t binding = 0u;
+  uint32_t type_id = 0u; // Id of the block's type in the SPIR-V module.
+  uint32_t size = 0u;    // End of the last member, in bytes.
+  std::vector<cbuffer_member> members; // Ordered by offset.
+
+  // Returns the number of bytes between members that aren't used by any of
+  // them.
+  uint32_t padding() const;
+
+  // Returns true if both layouts have the same members at the same offsets.
+  bool same_as(const cbuffer_layout &other) const;
+};
+
+// Returns the layouts of all uniform buffers declared in a SPIR-V module.
+std::vector<cbuffer_layout> reflect_cbuffer_layouts(
+    const std::vector<uint32_t> &spirv_code);
+
+// Returns the layout with the members reordered to minimize padding, while
+// keeping every member at an offset that is valid under the std140 rules
+// (which are stricter than the ones DXC may use). If that doesn't make the
+// buffer any smaller, the layout is returned unchanged.
+cbuffer_layout pack_cbuffer_layout(const cbuffer_layout &layout);
+
+// Rewrites a SPIR-V module so that the uniform buffer block with the given
+// type has the given layout, reordering the members of the block's type and
+// updating the indices of all instructions accessing them. Returns false if
+// the module accesses the block in a way that can't be rewritten.
+bool apply_cbuffer_layout(std::vector<uint32_t> &spirv_code,
+                          const cbuffer_layout &layout);
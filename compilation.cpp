@@ -1,15 +1,21 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "compilation.h"
+#include "artifact_cache.h"
+#include "hash_utils.h"
 
 #include "spirv_glsl.hpp"
 #include "spirv_msl.hpp"
 
+#include <stdlib.h>
+
 compilation::compilation(shader_kind kind,
                          const std::vector<uint32_t>& spirv_code,
-                         const target_info& target_info) : target_info_(target_info),
-                                                           kind_(kind),
-                                                           original_spirv_(spirv_code) {
+                         const target_info& target_info,
+                         bool ios_base_vertex) : target_info_(target_info),
+                                                 kind_(kind),
+                                                 ios_base_vertex_(ios_base_vertex),
+                                                 original_spirv_(spirv_code) {
   switch (target_info_.api) {
   case target_api::GL: {
     auto gl_compiler = std::make_unique<spirv_cross::CompilerGLSL>(
@@ -24,7 +30,8 @@ compilation::compilation(shader_kind kind,
     spv_cross_compiler_ = std::move(gl_compiler);
     break;
   }
-  case target_api::VULKAN: {
+  case target_api::VULKAN:
+  case target_api::D3D12: {
     spv_cross_compiler_ =
       std::make_unique<spirv_cross::CompilerReflection>(spirv_code.data(),
         spirv_code.size());
@@ -38,6 +45,7 @@ compilation::compilation(shader_kind kind,
     const bool ios = target_info.platform == target_platform_class::MOBILE;
     opts.platform = ios ? spirv_cross::CompilerMSL::Options::iOS
       : spirv_cross::CompilerMSL::Options::macOS;
+    opts.ios_support_base_vertex_instance = ios_base_vertex;
     opts.enable_decoration_binding = true;
     msl_compiler->set_msl_options(opts);
     spv_cross_compiler_ = std::move(msl_compiler);
@@ -101,31 +109,106 @@ void compilation::add_resources_to_pipeline_layout(pipeline_layout& layout) cons
     descriptor_type::TEXTURE);
 }
 
-void compilation::run(const std::string &out_file_path, const pipeline_layout& layout) {
-  const std::string full_out_file_path =
-    out_file_path + 
-    (kind_ == shader_kind::vertex ? ".vs." : ".ps.") +
-    target_info_.file_ext;
+std::string compilation::output_file_path(const std::string &out_file_path) const {
+  return out_file_path + 
+         (kind_ == shader_kind::vertex ? ".vs." : ".ps.") +
+         target_info_.file_ext;
+}
 
-  FILE* out_file =
-      fopen(full_out_file_path.c_str(), "wb");
+std::string compilation::cache_key(const pipeline_layout& layout) const {
+  return cache_key("output", layout);
+}
 
-  if (out_file == nullptr) {
-    fprintf(stderr,
-            "Failed to open output file %s\n",
-            out_file_path.c_str());
-    exit(1);
-  }
+std::string compilation::binding_fixups_cache_key(
+    const pipeline_layout& layout) const {
+  return cache_key("binding_fixups", layout);
+}
 
+std::string compilation::cache_key(const char *artifact,
+                                   const pipeline_layout& layout) const {
+  sha256 h;
+  h.update_string(artifact);
+  h.update_field(ARTIFACT_CACHE_VERSION);
+  h.update_field((uint32_t)kind_);
+  h.update_field((uint32_t)target_info_.api);
+  h.update_field(target_info_.version_maj);
+  h.update_field(target_info_.version_min);
+  h.update_field((uint32_t)target_info_.platform);
+  h.update_string(target_info_.file_ext);
+  h.update_field((uint32_t)ios_base_vertex_);
+  h.update_string(layout.native_binding_map());
+  h.update(original_spirv_.data(), original_spirv_.size() * sizeof(uint32_t));
+  return h.hex_digest();
+}
+
+std::string compilation::generate(const pipeline_layout& layout) {
   std::string result;
   if (target_info_.api != target_api::VULKAN) {
     result = spv_cross_compiler_->compile();
-    fwrite(&result[0], sizeof(uint8_t), result.length(), out_file);
-    layout.dump_native_binding_map(out_file);
+    result += layout.native_binding_map();
+    if (needs_binding_fixups()) collect_binding_fixups();
   } else {
-    fwrite(original_spirv_.data(), sizeof(uint32_t),
-           original_spirv_.size(), out_file);
+    result.assign((const char*)original_spirv_.data(),
+                  original_spirv_.size() * sizeof(uint32_t));
+  }
+  return result;
+}
+
+bool compilation::needs_binding_fixups() const {
+  return target_info_.api == target_api::GL &&
+         target_info_.platform == target_platform_class::MOBILE &&
+         target_info_.version_maj == 3u && target_info_.version_min == 0u;
+}
+
+void compilation::collect_binding_fixups() {
+  // Names are only final once the code has been generated, since SPIRV-Cross
+  // may rename blocks and variables to avoid collisions.
+  binding_fixups_.clear();
+  const spirv_cross::ShaderResources resources =
+      spv_cross_compiler_->get_shader_resources(
+          spv_cross_compiler_->get_active_interface_variables());
+  for (const spirv_cross::Resource &r : resources.uniform_buffers) {
+    binding_fixups_.push_back(binding_fixup {
+      descriptor_type::UNIFORM_BUFFER,
+      spv_cross_compiler_->get_remapped_declared_block_name(r.id),
+      spv_cross_compiler_->get_decoration(r.id, spv::DecorationBinding) });
+  }
+  for (const spirv_cross::CombinedImageSampler &cis :
+       spv_cross_compiler_->get_combined_image_samplers()) {
+    binding_fixups_.push_back(binding_fixup {
+      descriptor_type::TEXTURE_AND_SAMPLER,
+      spv_cross_compiler_->get_name(cis.combined_id),
+      spv_cross_compiler_->get_decoration(cis.combined_id,
+                                          spv::DecorationBinding) });
+  }
+}
+
+std::string compilation::save_binding_fixups() const {
+  // One "<type> <native binding> <name>" line per fixup.
+  std::string result;
+  for (const binding_fixup &f : binding_fixups_) {
+    result += std::to_string((uint32_t)f.type) + " " +
+              std::to_string(f.native_binding) + " " + f.name + "\n";
   }
-  fclose(out_file);
+  return result;
 }
 
+void compilation::load_binding_fixups(const std::string &data) {
+  binding_fixups_.clear();
+  size_t line_start = 0u;
+  while (line_start < data.size()) {
+    size_t line_end = data.find('\n', line_start);
+    if (line_end == std::string::npos) line_end = data.size();
+    const std::string line = data.substr(line_start, line_end - line_start);
+    const size_t first_space = line.find(' ');
+    const size_t second_space = line.find(' ', first_space + 1u);
+    if (first_space != std::string::npos &&
+        second_space != std::string::npos) {
+      binding_fixups_.push_back(binding_fixup {
+        (descriptor_type)strtoul(line.c_str(), nullptr, 10),
+        line.substr(second_space + 1u),
+        (uint32_t)strtoul(line.c_str() + first_space + 1u, nullptr, 10) });
+    }
+    line_start = line_end + 1u;
+  }
+}
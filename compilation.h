@@ -33,21 +33,69 @@
 #include <stdint.h>
 #include <string>
 
+// A uniform block or combined image sampler in the code generated for a target
+// that can't declare bindings in the shader code (GLES 3.0), along with the
+// native binding that the application has to assign to it at runtime.
+struct binding_fixup {
+  descriptor_type type; // UNIFORM_BUFFER or TEXTURE_AND_SAMPLER.
+  std::string name; // Name of the block or sampler in the generated code.
+  uint32_t native_binding;
+};
+
 class compilation {
 public:
+  // `ios_base_vertex' allows Metal code for iOS to use the [[base_vertex]]
+  // and [[base_instance]] attributes, which require Apple A9 or later GPUs.
   compilation(shader_kind kind,
               const std::vector<uint32_t> &spirv_code,
-              const target_info &target_info);
+              const target_info &target_info,
+              bool ios_base_vertex = false);
 
   void add_resources_to_pipeline_layout(pipeline_layout &layout) const;
   void add_cis_to_map(separate_to_combined_map &image_map,
                       separate_to_combined_map &sampler_map) const;
-  void run(const std::string &out_file_path, const pipeline_layout& pipeline_layout);
+
+  // Produces the contents of the output file for the target. D3D12 targets
+  // only contribute to the pipeline layout; their code is produced by DXC.
+  std::string generate(const pipeline_layout& pipeline_layout);
+
+  // Returns a key identifying the output in an artifact cache. The key covers
+  // the input SPIR-V, the target options and the native binding assignments.
+  std::string cache_key(const pipeline_layout& pipeline_layout) const;
+
+  // Returns true if the application has to assign the bindings of the
+  // generated code at runtime.
+  bool needs_binding_fixups() const;
+
+  // Returns the bindings to assign at runtime. Filled in by `generate', or
+  // by `load_binding_fixups' when the output comes from an artifact cache.
+  const std::vector<binding_fixup>& binding_fixups() const {
+    return binding_fixups_;
+  }
+
+  // Returns a key identifying the binding fixups in an artifact cache, and
+  // converts them to and from the cached representation.
+  std::string
+  binding_fixups_cache_key(const pipeline_layout& pipeline_layout) const;
+  std::string save_binding_fixups() const;
+  void load_binding_fixups(const std::string &data);
+
+  // Returns the full path of the output file, given the path to the output
+  // folder and the technique name.
+  std::string output_file_path(const std::string &out_file_path) const;
+
   shader_kind kind() const { return kind_; }
+  const target_info& target() const { return target_info_; }
 
 private:
+  std::string cache_key(const char *artifact,
+                        const pipeline_layout& pipeline_layout) const;
+  void collect_binding_fixups();
+
   target_info target_info_;
   shader_kind kind_;
+  bool ios_base_vertex_;
   std::unique_ptr<spirv_cross::Compiler> spv_cross_compiler_;
   const std::vector<uint32_t> &original_spirv_;
+  std::vector<binding_fixup> binding_fixups_;
 };
\ No newline at end of file
@@ -0,0 +1,389 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "compile_processes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+
+compile_process_pool::compile_process_pool(uint32_t, uint32_t,
+                                           const std::string&) {
+  fprintf(stderr, "Compiling in worker processes is not supported on "
+                  "this platform\n");
+  exit(1);
+}
+
+compile_process_pool::~compile_process_pool() {}
+
+std::vector<dxc_wrapper::result> compile_process_pool::compile(
+    const std::vector<compile_job> &jobs) {
+  return std::vector<dxc_wrapper::result>(jobs.size());
+}
+
+void run_compile_process(const char *const[3], const std::string&) {
+  exit(1);
+}
+
+#else
+
+#include <atomic>
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#endif
+
+namespace {
+
+// Size of the memory shared with each worker. It holds a job on the way to
+// the worker, and the result on the way back, each preceded by its size.
+// Pages are only committed when touched, so the size is just a limit.
+constexpr size_t SHARED_MEMORY_SIZE = 64u << 20;
+constexpr size_t MAX_PAYLOAD_SIZE = SHARED_MEMORY_SIZE - sizeof(uint32_t);
+
+// How often a busy worker is checked on while waiting for its result.
+constexpr int POLL_INTERVAL_MS = 100;
+
+bool write_byte(int fd) {
+  const char b = 0;
+  ssize_t n;
+  do { n = write(fd, &b, 1u); } while (n < 0 && errno == EINTR);
+  return n == 1;
+}
+
+bool read_byte(int fd) {
+  char b;
+  ssize_t n;
+  do { n = read(fd, &b, 1u); } while (n < 0 && errno == EINTR);
+  return n == 1;
+}
+
+void write_payload(char *shared_memory, const std::string &payload) {
+  const uint32_t size = (uint32_t)payload.size();
+  memcpy(shared_memory, &size, sizeof(size));
+  memcpy(shared_memory + sizeof(size), payload.data(), payload.size());
+}
+
+bool read_payload(const char *shared_memory, std::string &payload) {
+  uint32_t size = 0u;
+  memcpy(&size, shared_memory, sizeof(size));
+  if (size > MAX_PAYLOAD_SIZE) return false;
+  payload.assign(shared_memory + sizeof(size), size);
+  return true;
+}
+
+bool set_close_on_exec(int fd) {
+  return fcntl(fd, F_SETFD, FD_CLOEXEC) == 0;
+}
+
+// Returns the path of the executable file of this process, falling back to
+// the path it was invoked with.
+std::string executable_path(const std::string &exe_path) {
+#if defined(__APPLE__)
+  char path[PATH_MAX];
+  uint32_t size = sizeof(path);
+  if (_NSGetExecutablePath(path, &size) == 0) return path;
+#elif defined(__linux__)
+  char path[PATH_MAX];
+  const ssize_t size = readlink("/proc/self/exe", path, sizeof(path) - 1u);
+  if (size > 0) return std::string(path, (size_t)size);
+#endif
+  return exe_path;
+}
+
+// Creates anonymous shared memory that can be passed on to another
+// executable by file descriptor.
+int create_shared_memory() {
+  static std::atomic<uint32_t> counter { 0u };
+  const std::string name = "/ngf-shaderc-" + std::to_string(getpid()) + "-" +
+                           std::to_string(counter++);
+  const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) return -1;
+  shm_unlink(name.c_str());
+  if (!set_close_on_exec(fd) ||
+      ftruncate(fd, (off_t)SHARED_MEMORY_SIZE) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+}
+
+[[noreturn]] void run_compile_process(const char *const fds[3],
+                                      const std::string &exe_dir) {
+  const int request_fd = atoi(fds[0]);
+  const int response_fd = atoi(fds[1]);
+  void *shared_memory = mmap(nullptr, SHARED_MEMORY_SIZE,
+                             PROT_READ | PROT_WRITE, MAP_SHARED,
+                             atoi(fds[2]), 0);
+  if (shared_memory == MAP_FAILED) exit(1);
+  job_compiler compiler(exe_dir);
+  while (read_byte(request_fd)) {
+    std::string request;
+    compile_job job;
+    dxc_wrapper::result result;
+    if (!read_payload((const char*)shared_memory, request) ||
+        !job.deserialize(request)) {
+      result.diag_message = "malformed compile job received by worker "
+                            "process\n";
+    } else {
+      result = compiler.compile(job);
+    }
+    std::string response = serialize_compile_result(result);
+    if (response.size() > MAX_PAYLOAD_SIZE) {
+      result.spirv_code.clear();
+      result.diag_message = job.source_name + ": result of compiling " +
+                            job.entry_point.name + " is too large\n";
+      response = serialize_compile_result(result);
+    }
+    write_payload((char*)shared_memory, response);
+    if (!write_byte(response_fd)) break;
+  }
+  exit(0);
+}
+
+compile_process_pool::compile_process_pool(uint32_t nprocesses,
+                                           uint32_t timeout_ms,
+                                           const std::string &exe_path) :
+    workers_(nprocesses),
+    timeout_ms_(timeout_ms),
+    exe_path_(exe_path),
+    executable_(executable_path(exe_path)) {
+  // Writing to a worker that has just crashed must fail instead of killing
+  // this process.
+  signal(SIGPIPE, SIG_IGN);
+  for (worker &w : workers_) {
+    w.shared_memory_fd = create_shared_memory();
+    void *shared_memory =
+        w.shared_memory_fd < 0
+            ? MAP_FAILED
+            : mmap(nullptr, SHARED_MEMORY_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, w.shared_memory_fd, 0);
+    if (shared_memory == MAP_FAILED) {
+      fprintf(stderr, "Failed to allocate memory shared with worker "
+                      "processes\n");
+      exit(1);
+    }
+    w.shared_memory = (char*)shared_memory;
+  }
+  for (worker &w : workers_) start_worker(w);
+}
+
+compile_process_pool::~compile_process_pool() {
+  // Workers exit once their request pipe is closed.
+  for (worker &w : workers_) {
+    const int pid = detach_worker(w);
+    if (pid > 0) waitpid((pid_t)pid, nullptr, 0);
+    munmap(w.shared_memory, SHARED_MEMORY_SIZE);
+    close(w.shared_memory_fd);
+  }
+}
+
+void compile_process_pool::start_worker(worker &w) {
+  // The pool's descriptors are all closed on exec, and only the new worker
+  // reopens its own ones. Pipes are created inheritable, so workers are
+  // started one at a time to keep them from leaking into each other.
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  int request_pipe[2], response_pipe[2];
+  if (pipe(request_pipe) != 0) return;
+  if (pipe(response_pipe) != 0) {
+    close(request_pipe[0]);
+    close(request_pipe[1]);
+    return;
+  }
+  const int fds[] = { request_pipe[0], response_pipe[1], w.shared_memory_fd };
+  bool fds_ok = set_close_on_exec(request_pipe[1]) &&
+                set_close_on_exec(response_pipe[0]);
+  // Everything the worker gets is prepared up front: between fork() and
+  // exec(), the new process may only make async-signal-safe calls, since
+  // other threads of this process may have held locks at the time of fork().
+  std::string fd_args[3];
+  for (size_t i = 0u; i < 3u; ++i) {
+    fds_ok = fds_ok && set_close_on_exec(fds[i]);
+    fd_args[i] = std::to_string(fds[i]);
+  }
+  const char *argv[] = {
+    exe_path_.c_str(), COMPILE_PROCESS_OPTION,
+    fd_args[0].c_str(), fd_args[1].c_str(), fd_args[2].c_str(), nullptr
+  };
+  // Don't let the worker inherit buffered output, it would be printed twice.
+  fflush(stdout);
+  fflush(stderr);
+  const pid_t pid = fds_ok ? fork() : -1;
+  if (pid == 0) {
+    for (const int fd : fds) fcntl(fd, F_SETFD, 0);
+    execv(executable_.c_str(), (char* const*)argv);
+    _exit(127);
+  }
+  close(request_pipe[0]);
+  close(response_pipe[1]);
+  if (pid < 0) {
+    close(request_pipe[1]);
+    close(response_pipe[0]);
+    return;
+  }
+  w.pid = (int)pid;
+  w.request_fd = request_pipe[1];
+  w.response_fd = response_pipe[0];
+}
+
+int compile_process_pool::detach_worker(worker &w) {
+  std::lock_guard<std::mutex> lock(workers_mutex_);
+  const int pid = w.pid;
+  if (pid > 0) {
+    close(w.request_fd);
+    close(w.response_fd);
+    w.pid = -1;
+  }
+  return pid;
+}
+
+dxc_wrapper::result compile_process_pool::run_job(worker &w,
+                                                  const compile_job &job,
+                                                  bool retry,
+                                                  bool &worker_lost) {
+  dxc_wrapper::result result;
+  worker_lost = false;
+  const std::string job_description =
+      job.source_name + ": " + job.entry_point.name;
+  const std::string request = job.serialize();
+  if (request.size() > MAX_PAYLOAD_SIZE) {
+    result.diag_message = job_description + ": compile job is too large\n";
+    return result;
+  }
+  // Quietly replace a worker that exited while it was idle.
+  if (w.pid > 0 && waitpid((pid_t)w.pid, nullptr, WNOHANG) == (pid_t)w.pid) {
+    detach_worker(w);
+  }
+  if (w.pid <= 0) start_worker(w);
+  if (w.pid <= 0) {
+    result.diag_message = job_description + ": failed to start a worker "
+                                            "process\n";
+    return result;
+  }
+
+  write_payload(w.shared_memory, request);
+  const pid_t pid = (pid_t)w.pid;
+  int status = 0;
+  bool reaped = false;
+  bool timed_out = false;
+  if (write_byte(w.request_fd)) {
+    const auto start_time = std::chrono::steady_clock::now();
+    for (;;) {
+      pollfd pfd { w.response_fd, POLLIN, 0 };
+      const int nready = poll(&pfd, 1u, POLL_INTERVAL_MS);
+      if (nready > 0) {
+        // Either the result is ready, or the worker is gone.
+        std::string response;
+        if (read_byte(w.response_fd) &&
+            read_payload(w.shared_memory, response) &&
+            deserialize_compile_result(response, result)) {
+          return result;
+        }
+        break;
+      }
+      if (nready < 0 && errno != EINTR) break;
+      if (waitpid(pid, &status, WNOHANG) == pid) {
+        reaped = true;
+        break;
+      }
+      if (std::chrono::steady_clock::now() - start_time >=
+          std::chrono::milliseconds(timeout_ms_)) {
+        timed_out = true;
+        break;
+      }
+    }
+  }
+
+  // The worker crashed or hung. Make sure it's gone, and have it replaced
+  // before its next job. Killing a worker that has crashed but hasn't been
+  // reaped yet does nothing, and leaves its exit status intact.
+  worker_lost = true;
+  detach_worker(w);
+  if (!reaped) {
+    kill(pid, SIGKILL);
+    reaped = waitpid(pid, &status, 0) == pid;
+  }
+  result.spirv_code.clear();
+  if (timed_out) {
+    result.diag_message = job_description + ": the DirectX Shader Compiler "
+                          "didn't finish within " +
+                          std::to_string(timeout_ms_) + " ms, restarting "
+                          "its worker process";
+  } else {
+    result.diag_message = job_description + ": the worker process running "
+                          "the DirectX Shader Compiler ";
+    if (reaped && WIFSIGNALED(status)) {
+      result.diag_message += "was killed by signal " +
+                             std::to_string(WTERMSIG(status));
+    } else if (reaped && WIFEXITED(status)) {
+      result.diag_message += "exited with code " +
+                             std::to_string(WEXITSTATUS(status));
+    } else {
+      result.diag_message += "crashed";
+    }
+    result.diag_message += ", restarting it";
+  }
+  result.diag_message += retry ? " and retrying the job\n" : "\n";
+  return result;
+}
+
+std::vector<dxc_wrapper::result> compile_process_pool::compile(
+    const std::vector<compile_job> &jobs) {
+  std::vector<dxc_wrapper::result> results(jobs.size());
+  std::atomic<size_t> next_job { 0u };
+
+  // Each worker is driven by a separate thread, which pulls jobs off the
+  // shared list.
+  std::vector<std::thread> threads;
+  for (size_t w = 0u; w < workers_.size() && w < jobs.size(); ++w) {
+    threads.emplace_back([&, w]() {
+      for (size_t job_idx = next_job++; job_idx < jobs.size();
+           job_idx = next_job++) {
+        bool worker_lost = false;
+        dxc_wrapper::result &result = results[job_idx];
+        result = run_job(workers_[w], jobs[job_idx], true, worker_lost);
+        if (worker_lost) {
+          const std::string first_failure = std::move(result.diag_message);
+          result = run_job(workers_[w], jobs[job_idx], false, worker_lost);
+          result.diag_message = first_failure + result.diag_message;
+        }
+      }
+    });
+  }
+  for (std::thread &t : threads) t.join();
+  return results;
+}
+
+#endif
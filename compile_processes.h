@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "dxc_wrapper.h"
+#include "remote_compile.h"
+
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A pool of worker processes, each with its own instance of the DirectX
+// Shader Compiler, so that a compiler crash or hang only takes down a worker
+// instead of the whole build. Workers are started by running this executable
+// again (see run_compile_process), so they start from a clean state no matter
+// which threads the pool's process is running at the time. Jobs are handed to
+// the workers and results read back through memory shared with each of them.
+// Workers that crash or exceed the timeout are killed, and replaced before
+// their next job. Not supported on Windows.
+class compile_process_pool {
+public:
+  // Starts `nprocesses' workers from the executable this process was started
+  // as, `exe_path' being the path it was invoked with. A job that takes
+  // longer than `timeout_ms' milliseconds fails, and its worker is restarted.
+  compile_process_pool(uint32_t nprocesses,
+                       uint32_t timeout_ms,
+                       const std::string &exe_path);
+  ~compile_process_pool();
+  compile_process_pool(const compile_process_pool&) = delete;
+  compile_process_pool& operator=(const compile_process_pool&) = delete;
+
+  // Compiles the given jobs on the workers and returns the results, in the
+  // same order as the jobs. A job whose worker crashes or times out is
+  // retried once on the worker's replacement, in case the failure wasn't
+  // caused by the job itself. If that fails too, the result of the job has
+  // no data, and a diagnostic message saying what happened.
+  std::vector<dxc_wrapper::result> compile(
+      const std::vector<compile_job> &jobs);
+
+private:
+  struct worker {
+    int pid = -1;
+    int request_fd = -1;  // Written to when a job is ready.
+    int response_fd = -1; // Read from when waiting for the result.
+    int shared_memory_fd = -1; // Passed on to the worker process.
+    char *shared_memory = nullptr;
+  };
+
+  void start_worker(worker &w);
+  // Closes the pool's ends of the worker's pipes, and returns the worker's
+  // pid, which is left for the caller to reap.
+  int detach_worker(worker &w);
+  // Runs the job on the worker. Sets `worker_lost' if the worker crashed or
+  // timed out and has to be replaced.
+  dxc_wrapper::result run_job(worker &w,
+                              const compile_job &job,
+                              bool retry,
+                              bool &worker_lost);
+
+  std::vector<worker> workers_;
+  uint32_t timeout_ms_;
+  std::string exe_path_;   // Path this executable was invoked with.
+  std::string executable_; // Path of the executable file to run.
+  // Guards the pids and file descriptors of the workers, and serializes
+  // starting them, so that no worker inherits another's pipes.
+  std::mutex workers_mutex_;
+};
+
+// Name of the option that starts this executable as a worker process of a
+// compile_process_pool. It's followed by the worker's request pipe, response
+// pipe and shared memory file descriptors.
+constexpr char COMPILE_PROCESS_OPTION[] = "--compile-process";
+
+// Body of a worker process started by a compile_process_pool: compiles jobs
+// until the pool goes away, then exits. `fds' holds the three file
+// descriptors that follow COMPILE_PROCESS_OPTION on the command line.
+[[noreturn]] void run_compile_process(const char *const fds[3],
+                                      const std::string &exe_dir);
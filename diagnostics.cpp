@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "diagnostics.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+namespace {
+
+// Severities as spelled by DXC, most specific first.
+const char *const DXC_SEVERITIES[] = {
+  "fatal error", "error", "warning", "note"
+};
+
+bool all_digits(const std::string &s) {
+  if (s.empty()) return false;
+  for (char c : s) {
+    if (!isdigit((unsigned char)c)) return false;
+  }
+  return true;
+}
+
+// Splits a `file:line:column' location. Paths may contain colons (drive
+// letters), so the numbers are taken from the end.
+void parse_location(const std::string &location, diagnostic &d) {
+  d.file = location;
+  const size_t column_colon = location.rfind(':');
+  if (column_colon == std::string::npos || column_colon == 0u) return;
+  const size_t line_colon = location.rfind(':', column_colon - 1u);
+  if (line_colon == std::string::npos) return;
+  const std::string line =
+      location.substr(line_colon + 1u, column_colon - line_colon - 1u);
+  const std::string column = location.substr(column_colon + 1u);
+  if (!all_digits(line) || !all_digits(column)) return;
+  d.file = location.substr(0u, line_colon);
+  d.line = (uint32_t)strtoul(line.c_str(), nullptr, 10);
+  d.column = (uint32_t)strtoul(column.c_str(), nullptr, 10);
+}
+
+}
+
+std::vector<diagnostic> parse_dxc_diagnostics(
+    const std::string &text,
+    const std::string &default_file) {
+  std::vector<diagnostic> diagnostics;
+  size_t line_start = 0u;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string::npos) line_end = text.size();
+    std::string line = text.substr(line_start, line_end - line_start);
+    line_start = line_end + 1u;
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\0')) {
+      line.pop_back();
+    }
+    for (const char *severity : DXC_SEVERITIES) {
+      const std::string marker = std::string(severity) + ": ";
+      diagnostic d;
+      size_t message_start;
+      if (line.compare(0u, marker.size(), marker) == 0) {
+        d.file = default_file;
+        message_start = marker.size();
+      } else {
+        const size_t pos = line.find(": " + marker);
+        if (pos == std::string::npos) continue;
+        parse_location(line.substr(0u, pos), d);
+        message_start = pos + 2u + marker.size();
+      }
+      d.severity = severity == DXC_SEVERITIES[0] ? "error" : severity;
+      d.message = line.substr(message_start);
+      diagnostics.emplace_back(std::move(d));
+      break;
+    }
+  }
+  return diagnostics;
+}
+
+std::string json_string(const std::string &s) {
+  std::string json = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      json.push_back('\\');
+      json.push_back(c);
+    } else if ((unsigned char)c < 0x20u) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+      json += buf;
+    } else {
+      json.push_back(c);
+    }
+  }
+  json.push_back('"');
+  return json;
+}
+
+void print_diagnostic_json(FILE *f,
+                           const diagnostic &d,
+                           const std::string &technique,
+                           const std::string &entry_point) {
+  std::string json = "{\"file\": " + json_string(d.file) +
+                     ", \"line\": " + std::to_string(d.line) +
+                     ", \"column\": " + std::to_string(d.column) +
+                     ", \"severity\": " + json_string(d.severity) +
+                     ", \"message\": " + json_string(d.message);
+  if (!technique.empty()) {
+    json += ", \"technique\": " + json_string(technique);
+  }
+  if (!entry_point.empty()) {
+    json += ", \"entry_point\": " + json_string(entry_point);
+  }
+  json += "}";
+  fprintf(f, "%s\n", json.c_str());
+}
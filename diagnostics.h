@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// A single compiler diagnostic, in a form that tools can consume.
+struct diagnostic {
+  std::string file;
+  uint32_t line = 0u;   // 1-based, or 0 if unknown.
+  uint32_t column = 0u; // 1-based, or 0 if unknown.
+  std::string severity; // "error", "warning" or "note".
+  std::string message;
+};
+
+// Splits the diagnostic output of DXC into individual diagnostics. Lines that
+// don't start a diagnostic, such as source excerpts and carets, are dropped.
+// Diagnostics without a location are attributed to `default_file'.
+std::vector<diagnostic> parse_dxc_diagnostics(const std::string &text,
+                                              const std::string &default_file);
+
+// Returns a string as a quoted JSON string, with special characters escaped.
+std::string json_string(const std::string &s);
+
+// Prints a diagnostic as a JSON object on a single line. `technique' and
+// `entry_point' tell which compilation the diagnostic came from, and are left
+// out if empty.
+void print_diagnostic_json(FILE *f,
+                           const diagnostic &d,
+                           const std::string &technique,
+                           const std::string &entry_point);
@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "draw_parameters.h"
+
+#include "spirv.hpp"
+
+namespace {
+
+const struct {
+  spv::BuiltIn builtin;
+  draw_parameter_bit parameter;
+  const char *name;
+} DRAW_PARAMETER_BUILTINS[] = {
+  { spv::BuiltInBaseVertex, DRAW_PARAMETER_BASE_VERTEX, "BaseVertex" },
+  { spv::BuiltInBaseInstance, DRAW_PARAMETER_BASE_INSTANCE, "BaseInstance" },
+  { spv::BuiltInDrawIndex, DRAW_PARAMETER_DRAW_INDEX, "DrawIndex" }
+};
+
+}
+
+uint32_t used_draw_parameters(const std::vector<uint32_t> &spirv_code) {
+  constexpr size_t HEADER_SIZE = 5u;
+  uint32_t parameters = 0u;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (word_count == 0u || pos + word_count > spirv_code.size()) break;
+    // Decorations always precede function definitions.
+    if (op == spv::OpFunction) break;
+    if (op == spv::OpDecorate && word_count >= 4u &&
+        spirv_code[pos + 2u] == spv::DecorationBuiltIn) {
+      for (const auto &b : DRAW_PARAMETER_BUILTINS) {
+        if (b.builtin == (spv::BuiltIn)spirv_code[pos + 3u]) {
+          parameters |= b.parameter;
+        }
+      }
+    }
+    pos += word_count;
+  }
+  return parameters;
+}
+
+uint32_t supported_draw_parameters(const target_info &target,
+                                   bool ios_base_vertex) {
+  const bool mobile = target.platform == target_platform_class::MOBILE;
+  const uint32_t version = target.version_maj * 10u + target.version_min;
+  switch (target.api) {
+  case target_api::GL:
+    // Through GL_ARB_shader_draw_parameters, which has no ES counterpart.
+    return mobile ? 0u
+                  : DRAW_PARAMETER_BASE_VERTEX | DRAW_PARAMETER_BASE_INSTANCE |
+                    DRAW_PARAMETER_DRAW_INDEX;
+  case target_api::METAL:
+    // Through the [[base_vertex]] and [[base_instance]] attributes, which iOS
+    // only supports on Apple A9 and later GPUs. Metal has no draw index.
+    return version >= 11u && (!mobile || ios_base_vertex)
+               ? DRAW_PARAMETER_BASE_VERTEX | DRAW_PARAMETER_BASE_INSTANCE
+               : 0u;
+  case target_api::D3D12:
+    // Needs SV_StartVertexLocation and SV_StartInstanceLocation from shader
+    // model 6.8, which the bundled DirectX Shader Compiler doesn't support.
+    return 0u;
+  case target_api::VULKAN:
+  default:
+    return DRAW_PARAMETER_BASE_VERTEX | DRAW_PARAMETER_BASE_INSTANCE |
+           DRAW_PARAMETER_DRAW_INDEX;
+  }
+}
+
+std::string draw_parameter_names(uint32_t draw_parameters) {
+  std::string result;
+  for (const auto &b : DRAW_PARAMETER_BUILTINS) {
+    if ((draw_parameters & b.parameter) == 0u) continue;
+    if (!result.empty()) result += ", ";
+    result += b.name;
+  }
+  return result;
+}
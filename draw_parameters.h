@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser/metadata_parser.h"
+#include "target.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Draw parameters that vertex shaders may read, declared in HLSL with
+// `[[vk::builtin("BaseVertex")]]', `[[vk::builtin("BaseInstance")]]' and
+// `[[vk::builtin("DrawIndex")]]'.
+enum draw_parameter_bit {
+  DRAW_PARAMETER_BASE_VERTEX = NGF_PLMD_DRAW_PARAMETER_BASE_VERTEX_BIT,
+  DRAW_PARAMETER_BASE_INSTANCE = NGF_PLMD_DRAW_PARAMETER_BASE_INSTANCE_BIT,
+  DRAW_PARAMETER_DRAW_INDEX = NGF_PLMD_DRAW_PARAMETER_DRAW_INDEX_BIT
+};
+
+// Returns the draw parameters used by a SPIR-V module.
+uint32_t used_draw_parameters(const std::vector<uint32_t> &spirv_code);
+
+// Returns the draw parameters available on the given target.
+// `ios_base_vertex' indicates whether iOS devices are assumed to support
+// base vertex and base instance attributes.
+uint32_t supported_draw_parameters(const target_info &target,
+                                   bool ios_base_vertex);
+
+// Returns a comma-separated list of names of the draw parameters in the mask.
+std::string draw_parameter_names(uint32_t draw_parameters);
@@ -49,6 +49,42 @@ namespace {
     std::mbstowcs(ws.data(), src, len);
     return ws;
   }
+
+  // Converts preprocessor definitions into the form expected by DXC.
+  class wide_defines {
+  public:
+    explicit wide_defines(const define_container &defines) {
+      wdefines_.reserve(defines.size());
+      dxc_defines_.reserve(defines.size());
+      for (const std::pair<std::string, std::string>& define : defines) {
+        wdefines_.emplace_back(towstring(define.first.c_str(), define.first.size()),
+                               towstring(define.second.c_str(), define.second.size()));
+        const auto &wdefine = wdefines_.back();
+        dxc_defines_.emplace_back(DxcDefine { 
+                                     wdefine.first.c_str(),
+                                     wdefine.second.empty()
+                                         ? NULL
+                                         : wdefine.second.c_str() });
+      }
+    }
+    const DxcDefine* data() const { return dxc_defines_.data(); }
+    uint32_t size() const { return (uint32_t)dxc_defines_.size(); }
+
+  private:
+    std::vector<std::pair<std::wstring, std::wstring>> wdefines_;
+    std::vector<DxcDefine> dxc_defines_;
+  };
+
+  // Copies the contents of a blob into a string.
+  std::string blob_to_string(IDxcBlob *blob) {
+    std::string s;
+    if (blob != nullptr && blob->GetBufferSize() > 0) {
+      s.assign((const char*)blob->GetBufferPointer(), blob->GetBufferSize());
+      // Text blobs may include the terminating null.
+      while (!s.empty() && s.back() == '\0') s.pop_back();
+    }
+    return s;
+  }
 }
 
 
@@ -116,21 +152,7 @@ dxc_wrapper::result dxc_wrapper::compile_hlsl2spv(
       towstring(input_file_name, strlen(input_file_name));
   const std::wstring wentry_point_name =
       towstring(entry_point.name.c_str(), entry_point.name.size());
-
-  std::vector<std::pair<std::wstring, std::wstring>> wdefines;
-  std::vector<DxcDefine> dxc_defines;
-  wdefines.reserve(defines.size());
-  dxc_defines.reserve(defines.size());
-  for (const std::pair<std::string, std::string>& define : defines) {
-    wdefines.emplace_back(towstring(define.first.c_str(), define.first.size()),
-                          towstring(define.second.c_str(), define.second.size()));
-    const auto &wdefine = wdefines.back();
-    dxc_defines.emplace_back(DxcDefine { 
-                                 wdefine.first.c_str(),
-                                 wdefine.second.empty()
-                                     ? NULL
-                                     : wdefine.second.c_str() });
-  }
+  const wide_defines wdefines(defines);
 
   const std::wstring target_profile = [&entry_point]() {
     switch (entry_point.kind) {
@@ -151,8 +173,8 @@ dxc_wrapper::result dxc_wrapper::compile_hlsl2spv(
             target_profile.c_str(),
             dxc_params_.data(),
             (uint32_t)dxc_params_.size(),
-            dxc_defines.data(),
-            (uint32_t)dxc_defines.size(),
+            wdefines.data(),
+            wdefines.size(),
             include_handler_.get(),
             ptr);
       });
@@ -162,9 +184,16 @@ dxc_wrapper::result dxc_wrapper::compile_hlsl2spv(
   auto spirv_blob =
       com_ptr<IDxcBlob>([&](auto ptr) { return dxc_result->GetResult(ptr); });
 
-  if (spirv_blob.get() != nullptr && spirv_blob->GetBufferSize() > 0) {
+  // Validation errors leave the output in place, so check the status too.
+  HRESULT status = S_OK;
+  dxc_result->GetStatus(&status);
+  if (SUCCEEDED(status) && spirv_blob.get() != nullptr &&
+      spirv_blob->GetBufferSize() > 0) {
+    // DXIL containers aren't necessarily a multiple of 4 bytes long, the
+    // last word is zero-padded in that case.
     result.spirv_code =
-        std::vector<uint32_t>(spirv_blob->GetBufferSize() / sizeof(uint32_t),
+        std::vector<uint32_t>((spirv_blob->GetBufferSize() +
+                               sizeof(uint32_t) - 1u) / sizeof(uint32_t),
                               0u);
     memcpy(result.spirv_code.data(),
            spirv_blob->GetBufferPointer(),
@@ -186,3 +215,52 @@ dxc_wrapper::result dxc_wrapper::compile_hlsl2spv(
 
   return result;
  }
+
+dxc_wrapper::preprocess_result dxc_wrapper::preprocess_hlsl(
+    const char* source,
+    size_t source_size,
+    const char* input_file_name,
+    const define_container& defines) {
+  auto input_blob = com_ptr<IDxcBlobEncoding>([&](auto ptr) {
+    return library_instance_->CreateBlobWithEncodingFromPinned(
+        source,
+        (uint32_t)source_size,
+        0,
+        ptr);
+  });
+
+  const std::wstring winput_file_name =
+      towstring(input_file_name, strlen(input_file_name));
+  const wide_defines wdefines(defines);
+
+  auto dxc_result =
+      com_ptr<IDxcOperationResult>([&, this](auto ptr) {
+        return compiler_instance_->Preprocess(
+            input_blob.get(),
+            winput_file_name.c_str(),
+            dxc_params_.data(),
+            (uint32_t)dxc_params_.size(),
+            wdefines.data(),
+            wdefines.size(),
+            include_handler_.get(),
+            ptr);
+      });
+
+  HRESULT status = S_OK;
+  dxc_result->GetStatus(&status);
+
+  preprocess_result result;
+  auto text_blob =
+      com_ptr<IDxcBlob>([&](auto ptr) { return dxc_result->GetResult(ptr); });
+  if (SUCCEEDED(status)) {
+    result.source = blob_to_string(text_blob.get());
+  }
+
+  auto errmsg_blob =
+      com_ptr<IDxcBlobEncoding>([&](auto ptr) {
+        return dxc_result->GetErrorBuffer(ptr);
+      });
+  result.diag_message = blob_to_string(errmsg_blob.get());
+
+  return result;
+}
@@ -111,16 +111,32 @@ public:
     bool HasDiagMessage() const { return diag_message.size() > 0; }
   };
 
+  struct preprocess_result {
+    std::string source;
+    std::string diag_message;
+    bool HasData() const { return source.size() > 0; }
+    bool HasDiagMessage() const { return diag_message.size() > 0; }
+  };
+
   dxc_wrapper(const std::string &sm, 
               const std::vector<std::string> &dxc_params,
               const std::string& exe_dir);
 
+  // Compiles an entry point. The output is SPIR-V, or DXIL if the compiler
+  // was created without the `-spirv' option.
   result compile_hlsl2spv(const char *source,
                           size_t source_size,
                           const char *input_file_name,
                           const technique::entry_point &entry_point,
                           const define_container &defines);
 
+  // Runs only the preprocessor on the given source, producing a
+  // self-contained translation unit with all includes resolved.
+  preprocess_result preprocess_hlsl(const char *source,
+                                    size_t source_size,
+                                    const char *input_file_name,
+                                    const define_container &defines);
+
 private:
   std::wstring shader_model_;
   dynamic_lib dxcompiler_dll_;
@@ -18,11 +18,17 @@ SOFTWARE.
 */
 #define _CRT_SECURE_NO_WARNINGS
 #include "file_utils.h"
+#include "build_error.h"
 
+#include <atomic>
+#include <filesystem>
 #include <stdlib.h>
 #include <stdio.h>
 #if defined(_WIN32) || defined(_WIN64)
+  #include <fcntl.h>
   #include <io.h>
+  #include <process.h>
+  #define getpid _getpid
   #if defined(_WIN64)
   #define filelen(f) _filelengthi64(_fileno(f))
   #elif defined(_WIN32)
@@ -30,6 +36,7 @@ SOFTWARE.
   #endif
 #else
   #include <sys/stat.h>
+  #include <unistd.h>
   size_t filelen(FILE *f) {
     struct stat statbuf;
     fstat(fileno(f), &statbuf);
@@ -56,3 +63,77 @@ std::string read_file(const char *path) {
   fclose(input_file);
   return contents;
 }
+
+bool try_read_file(const char *path, std::string &contents) {
+  FILE *input_file = fopen(path, "rb");
+  if (input_file == nullptr) {
+    return false;
+  }
+  size_t len = filelen(input_file);
+  contents.clear();
+  contents.reserve(len + 1u);
+  contents.resize(len);
+  size_t read_bytes = len > 0u ? fread(&contents[0], 1u, len, input_file) : 0u;
+  fclose(input_file);
+  return read_bytes == len;
+}
+
+bool try_read_stdin(std::string &contents) {
+#if defined(_WIN32) || defined(_WIN64)
+  _setmode(_fileno(stdin), _O_BINARY);
+#endif
+  contents.clear();
+  char buf[65536];
+  size_t read_bytes;
+  while ((read_bytes = fread(buf, 1u, sizeof(buf), stdin)) > 0u) {
+    contents.append(buf, read_bytes);
+  }
+  return !ferror(stdin);
+}
+
+void write_file(const char *path, const std::string &data) {
+  FILE *out_file = fopen(path, "wb");
+  if (out_file == nullptr) {
+    fprintf(stderr, "Failed to open output file %s\n", path);
+    abort_build();
+  }
+  const bool written =
+      fwrite(data.data(), 1u, data.size(), out_file) == data.size();
+  fclose(out_file);
+  if (!written) {
+    fprintf(stderr, "Failed to write output file %s\n", path);
+    abort_build();
+  }
+}
+
+bool write_file_atomically(const char *path, const std::string &data) {
+  std::error_code ec;
+  const std::filesystem::path fs_path(path);
+  if (fs_path.has_parent_path()) {
+    std::filesystem::create_directories(fs_path.parent_path(), ec);
+  }
+  // Other threads and processes may be writing the same file (e.g. when
+  // sharing a cache folder), so each writer needs a temporary file of its own.
+  static std::atomic<uint32_t> tmp_counter { 0u };
+  const std::string tmp_path = std::string(path) + ".tmp." +
+                               std::to_string(getpid()) + "." +
+                               std::to_string(tmp_counter++);
+  FILE *out_file = fopen(tmp_path.c_str(), "wb");
+  if (out_file == nullptr) {
+    return false;
+  }
+  bool written =
+      fwrite(data.data(), 1u, data.size(), out_file) == data.size();
+  // Buffered data is only flushed on close, which can fail too.
+  written = fclose(out_file) == 0 && written;
+  if (!written) {
+    remove(tmp_path.c_str());
+    return false;
+  }
+  std::filesystem::rename(tmp_path, fs_path, ec);
+  if (ec) {
+    remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
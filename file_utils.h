@@ -26,6 +26,22 @@
 
 std::string read_file(const char *path);
 
+// Reads the contents of a file into an std::string. Returns false instead of
+// exiting if the file can't be read.
+bool try_read_file(const char *path, std::string &contents);
+
+// Reads everything from the standard input until end of file.
+bool try_read_stdin(std::string &contents);
+
+// Writes the given data to a file, replacing its previous contents. Aborts
+// the build if the file can't be written.
+void write_file(const char *path, const std::string &data);
+
+// Writes the given data to a temporary file next to `path', then renames it
+// to `path', so that readers never observe a partially written file. Creates
+// missing parent directories. Returns false on failure.
+bool write_file_atomically(const char *path, const std::string &data);
+
 #if defined(_WIN32) || defined(_WIN64)
 #define PATH_SEPARATOR  "\\"
 #else
@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <stdio.h>
+#include <thread>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Gives editors a moment to finish saving before the change is acted upon,
+// so that a burst of events results in a single rebuild.
+constexpr auto SETTLE_TIME = std::chrono::milliseconds(50);
+
+std::string normalized_path(const std::string &path) {
+  std::error_code ec;
+  fs::path p = fs::absolute(fs::path(path), ec);
+  return ec ? path : p.lexically_normal().string();
+}
+
+fs::file_time_type modification_time(const std::string &path) {
+  std::error_code ec;
+  const fs::file_time_type t = fs::last_write_time(path, ec);
+  return ec ? fs::file_time_type::min() : t;
+}
+
+bool any_changed_since(const std::vector<std::string> &paths,
+                       const file_snapshot &snapshot) {
+  return std::any_of(paths.begin(), paths.end(),
+                     [&snapshot](const std::string &path) {
+                       return snapshot.changed_since(path);
+                     });
+}
+
+// Waits for changes by polling modification times. Used where inotify isn't
+// available, or has failed.
+void poll_for_file_changes(const std::vector<std::string> &paths,
+                           const file_snapshot &snapshot) {
+  std::vector<fs::file_time_type> initial_times;
+  for (const std::string &path : paths) {
+    initial_times.push_back(modification_time(path));
+  }
+  if (any_changed_since(paths, snapshot)) {
+    std::this_thread::sleep_for(SETTLE_TIME);
+    return;
+  }
+  for (;;) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (size_t i = 0u; i < paths.size(); ++i) {
+      if (modification_time(paths[i]) != initial_times[i]) {
+        std::this_thread::sleep_for(SETTLE_TIME);
+        return;
+      }
+    }
+  }
+}
+
+}
+
+file_snapshot::file_snapshot(const std::vector<std::string> &paths)
+    : time_(fs::file_time_type::clock::now()) {
+  for (const std::string &path : paths) {
+    modification_times_[normalized_path(path)] = modification_time(path);
+  }
+}
+
+bool file_snapshot::changed_since(const std::string &path) const {
+  const fs::file_time_type t = modification_time(path);
+  const auto it = modification_times_.find(normalized_path(path));
+  return it != modification_times_.end() ? t != it->second : t > time_;
+}
+
+#if defined(__linux__)
+
+void wait_for_file_changes(const std::vector<std::string> &paths,
+                           const file_snapshot &snapshot) {
+  const int fd = inotify_init1(IN_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to initialize inotify, polling for changes "
+                    "instead\n");
+    poll_for_file_changes(paths, snapshot);
+    return;
+  }
+
+  // Watch each folder once, and remember which file names in it are of
+  // interest.
+  std::map<int, std::set<std::string>> watched_names;
+  std::map<std::string, int> folder_watches;
+  for (const std::string &path : paths) {
+    const fs::path p(normalized_path(path));
+    const std::string folder = p.parent_path().string();
+    auto it = folder_watches.find(folder);
+    if (it == folder_watches.end()) {
+      const int wd = inotify_add_watch(
+          fd, folder.c_str(),
+          IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MODIFY);
+      if (wd < 0) {
+        fprintf(stderr, "Failed to watch folder %s\n", folder.c_str());
+        continue;
+      }
+      it = folder_watches.emplace(folder, wd).first;
+    }
+    watched_names[it->second].insert(p.filename().string());
+  }
+  if (folder_watches.empty()) {
+    close(fd);
+    poll_for_file_changes(paths, snapshot);
+    return;
+  }
+
+  // Changes made after the snapshot but before the folders were watched
+  // wouldn't produce any events.
+  bool changed = any_changed_since(paths, snapshot);
+  alignas(inotify_event) char buf[4096];
+  while (!changed) {
+    const ssize_t len = read(fd, buf, sizeof(buf));
+    if (len < 0 && errno == EINTR) continue;
+    if (len <= 0) {
+      fprintf(stderr, "Failed to read inotify events, polling for changes "
+                      "instead\n");
+      close(fd);
+      poll_for_file_changes(paths, snapshot);
+      return;
+    }
+    for (ssize_t offset = 0; offset < len;) {
+      const inotify_event *e = (const inotify_event*)(buf + offset);
+      if (e->len > 0u && watched_names[e->wd].count(e->name) > 0u) {
+        changed = true;
+      }
+      offset += (ssize_t)sizeof(inotify_event) + e->len;
+    }
+  }
+
+  // Drain the events that arrive while the editor finishes saving.
+  std::this_thread::sleep_for(SETTLE_TIME);
+  pollfd pfd { fd, POLLIN, 0 };
+  while (poll(&pfd, 1, 0) > 0 && read(fd, buf, sizeof(buf)) > 0) {}
+  close(fd);
+}
+
+#else
+
+void wait_for_file_changes(const std::vector<std::string> &paths,
+                           const file_snapshot &snapshot) {
+  poll_for_file_changes(paths, snapshot);
+}
+
+#endif
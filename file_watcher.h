@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+// Modification times of a set of files, recorded when a build starts, so that
+// changes saved while the build runs aren't missed.
+class file_snapshot {
+public:
+  explicit file_snapshot(const std::vector<std::string> &paths);
+
+  // Returns true if the file was modified since the snapshot was taken. Files
+  // that weren't part of the snapshot count as modified if they were written
+  // after it was taken.
+  bool changed_since(const std::string &path) const;
+
+private:
+  std::filesystem::file_time_type time_;
+  std::map<std::string, std::filesystem::file_time_type> modification_times_;
+};
+
+// Blocks until any of the given files is modified, created, deleted or
+// replaced, returning right away if one of them has changed since `snapshot'
+// was taken. Uses inotify on Linux, and polls modification times elsewhere
+// or if inotify fails.
+// Parent folders are watched rather than the files themselves, because
+// editors often save by writing a new file and renaming it over the old one.
+void wait_for_file_changes(const std::vector<std::string> &paths,
+                           const file_snapshot &snapshot);
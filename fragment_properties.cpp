@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fragment_properties.h"
+
+#include "spirv.hpp"
+
+#include <set>
+
+namespace {
+
+// OpTerminateInvocation (SPIR-V 1.6) is missing from the bundled headers.
+constexpr uint32_t OP_TERMINATE_INVOCATION = 4416u;
+
+// Returns true for atomic instructions that modify memory.
+bool is_atomic_write(uint32_t opcode) {
+  return (opcode >= spv::OpAtomicStore && opcode <= spv::OpAtomicXor) ||
+         opcode == spv::OpAtomicFlagTestAndSet ||
+         opcode == spv::OpAtomicFlagClear;
+}
+
+}
+
+uint32_t fragment_properties(const std::vector<uint32_t> &spirv_code) {
+  constexpr size_t HEADER_SIZE = 5u;
+  uint32_t properties = 0u;
+  std::set<uint32_t> depth_vars, sample_mask_vars;
+  // Storage buffers are either in the StorageBuffer storage class, or, with
+  // SPIR-V 1.0, in the Uniform storage class with a BufferBlock struct type.
+  // Pointers into them are tracked through access chains, so that stores
+  // through them can be told apart from stores to private variables.
+  std::set<uint32_t> buffer_block_types, storage_buffer_pointer_types,
+                     storage_buffer_pointers;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const uint32_t opcode = spirv_code[pos] & 0xffffu;
+    if (word_count == 0u || pos + word_count > spirv_code.size()) break;
+    const uint32_t *operands = &spirv_code[pos + 1u];
+    if (opcode == OP_TERMINATE_INVOCATION) {
+      properties |= FRAGMENT_DISCARD;
+    } else if (opcode == spv::OpImageWrite || is_atomic_write(opcode)) {
+      properties |= FRAGMENT_SIDE_EFFECTS;
+    }
+    switch (opcode) {
+    case spv::OpExecutionMode:
+      if (word_count < 3u) break;
+      switch ((spv::ExecutionMode)operands[1]) {
+      case spv::ExecutionModeEarlyFragmentTests:
+        properties |= FRAGMENT_EARLY_TESTS;
+        break;
+      case spv::ExecutionModeDepthReplacing:
+        properties |= FRAGMENT_DEPTH_WRITE;
+        break;
+      case spv::ExecutionModeDepthGreater:
+        properties |= FRAGMENT_DEPTH_GREATER;
+        break;
+      case spv::ExecutionModeDepthLess:
+        properties |= FRAGMENT_DEPTH_LESS;
+        break;
+      default:
+        break;
+      }
+      break;
+    case spv::OpDecorate:
+      if (word_count < 3u) break;
+      if (operands[1] == spv::DecorationBufferBlock) {
+        buffer_block_types.insert(operands[0]);
+      }
+      if (word_count < 4u || operands[1] != spv::DecorationBuiltIn) break;
+      if (operands[2] == spv::BuiltInFragDepth) {
+        depth_vars.insert(operands[0]);
+      } else if (operands[2] == spv::BuiltInSampleMask) {
+        sample_mask_vars.insert(operands[0]);
+      }
+      break;
+    case spv::OpTypePointer:
+      if (word_count < 4u) break;
+      if (operands[1] == spv::StorageClassStorageBuffer ||
+          (operands[1] == spv::StorageClassUniform &&
+           buffer_block_types.count(operands[2]) > 0u)) {
+        storage_buffer_pointer_types.insert(operands[0]);
+      }
+      break;
+    case spv::OpVariable:
+      if (word_count < 4u) break;
+      if (storage_buffer_pointer_types.count(operands[0]) > 0u) {
+        storage_buffer_pointers.insert(operands[1]);
+      }
+      // SampleMask is also used for the coverage input, only outputs count.
+      if (operands[2] != spv::StorageClassOutput) break;
+      if (depth_vars.count(operands[1]) > 0u) {
+        properties |= FRAGMENT_DEPTH_WRITE;
+      } else if (sample_mask_vars.count(operands[1]) > 0u) {
+        properties |= FRAGMENT_SAMPLE_MASK_WRITE;
+      }
+      break;
+    case spv::OpAccessChain:
+    case spv::OpInBoundsAccessChain:
+    case spv::OpPtrAccessChain:
+      if (word_count >= 4u && storage_buffer_pointers.count(operands[2]) > 0u) {
+        storage_buffer_pointers.insert(operands[1]);
+      }
+      break;
+    case spv::OpStore:
+    case spv::OpCopyMemory:
+      if (word_count >= 3u && storage_buffer_pointers.count(operands[0]) > 0u) {
+        properties |= FRAGMENT_SIDE_EFFECTS;
+      }
+      break;
+    case spv::OpKill:
+    case spv::OpDemoteToHelperInvocationEXT:
+      properties |= FRAGMENT_DISCARD;
+      break;
+    default:
+      break;
+    }
+    pos += word_count;
+  }
+  // Depth and stencil tests may run before the shader if it is forced to, or
+  // if nothing it does can change their outcome or be observed when they
+  // fail.
+  if ((properties & FRAGMENT_EARLY_TESTS) != 0u ||
+      (properties & (FRAGMENT_DISCARD | FRAGMENT_DEPTH_WRITE |
+                     FRAGMENT_SAMPLE_MASK_WRITE |
+                     FRAGMENT_SIDE_EFFECTS)) == 0u) {
+    properties |= FRAGMENT_EARLY_Z_ELIGIBLE;
+  }
+  return properties;
+}
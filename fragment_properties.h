@@ -0,0 +1,45 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser/metadata_parser.h"
+
+#include <stdint.h>
+#include <vector>
+
+// Properties of a fragment shader that affect how the fixed-function depth
+// and stencil tests can be scheduled.
+enum fragment_property_bit {
+  FRAGMENT_DISCARD = NGF_PLMD_FRAGMENT_DISCARD_BIT,
+  FRAGMENT_DEPTH_WRITE = NGF_PLMD_FRAGMENT_DEPTH_WRITE_BIT,
+  FRAGMENT_DEPTH_GREATER = NGF_PLMD_FRAGMENT_DEPTH_GREATER_BIT,
+  FRAGMENT_DEPTH_LESS = NGF_PLMD_FRAGMENT_DEPTH_LESS_BIT,
+  FRAGMENT_SAMPLE_MASK_WRITE = NGF_PLMD_FRAGMENT_SAMPLE_MASK_WRITE_BIT,
+  FRAGMENT_EARLY_TESTS = NGF_PLMD_FRAGMENT_EARLY_TESTS_BIT,
+  FRAGMENT_EARLY_Z_ELIGIBLE = NGF_PLMD_FRAGMENT_EARLY_Z_ELIGIBLE_BIT,
+  FRAGMENT_SIDE_EFFECTS = NGF_PLMD_FRAGMENT_SIDE_EFFECTS_BIT
+};
+
+// Returns the properties of a fragment shader, derived from the execution
+// modes, builtin outputs and instructions of its SPIR-V module.
+uint32_t fragment_properties(const std::vector<uint32_t> &spirv_code);
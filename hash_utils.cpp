@@ -0,0 +1,140 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "hash_utils.h"
+
+#include <string.h>
+
+namespace {
+
+const uint32_t SHA256_K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rotr(uint32_t x, uint32_t n) { return (x >> n) | (x << (32u - n)); }
+
+}
+
+sha256::sha256() {
+  static const uint32_t initial_state[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+  memcpy(state_, initial_state, sizeof(state_));
+}
+
+void sha256::process_block(const uint8_t *block) {
+  uint32_t w[64];
+  for (uint32_t i = 0u; i < 16u; ++i) {
+    w[i] = ((uint32_t)block[i * 4u] << 24u) |
+           ((uint32_t)block[i * 4u + 1u] << 16u) |
+           ((uint32_t)block[i * 4u + 2u] << 8u) |
+           ((uint32_t)block[i * 4u + 3u]);
+  }
+  for (uint32_t i = 16u; i < 64u; ++i) {
+    const uint32_t s0 = rotr(w[i - 15u], 7u) ^ rotr(w[i - 15u], 18u) ^ (w[i - 15u] >> 3u);
+    const uint32_t s1 = rotr(w[i - 2u], 17u) ^ rotr(w[i - 2u], 19u) ^ (w[i - 2u] >> 10u);
+    w[i] = w[i - 16u] + s0 + w[i - 7u] + s1;
+  }
+  uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3],
+           e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+  for (uint32_t i = 0u; i < 64u; ++i) {
+    const uint32_t s1 = rotr(e, 6u) ^ rotr(e, 11u) ^ rotr(e, 25u);
+    const uint32_t ch = (e & f) ^ (~e & g);
+    const uint32_t t1 = h + s1 + ch + SHA256_K[i] + w[i];
+    const uint32_t s0 = rotr(a, 2u) ^ rotr(a, 13u) ^ rotr(a, 22u);
+    const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    const uint32_t t2 = s0 + maj;
+    h = g; g = f; f = e; e = d + t1;
+    d = c; c = b; b = a; a = t1 + t2;
+  }
+  state_[0] += a; state_[1] += b; state_[2] += c; state_[3] += d;
+  state_[4] += e; state_[5] += f; state_[6] += g; state_[7] += h;
+}
+
+void sha256::update(const void *data, size_t size) {
+  const uint8_t *bytes = (const uint8_t*)data;
+  total_size_ += size;
+  while (size > 0u) {
+    const size_t chunk = 64u - buffer_size_ < size ? 64u - buffer_size_ : size;
+    memcpy(buffer_ + buffer_size_, bytes, chunk);
+    buffer_size_ += chunk;
+    bytes += chunk;
+    size -= chunk;
+    if (buffer_size_ == 64u) {
+      process_block(buffer_);
+      buffer_size_ = 0u;
+    }
+  }
+}
+
+void sha256::update_string(const std::string &s) {
+  update_field((uint32_t)s.size());
+  update(s.data(), s.size());
+}
+
+void sha256::update_field(uint32_t value) {
+  const uint8_t bytes[4] = {
+    (uint8_t)(value >> 24u), (uint8_t)(value >> 16u),
+    (uint8_t)(value >> 8u), (uint8_t)value
+  };
+  update(bytes, sizeof(bytes));
+}
+
+std::string sha256::hex_digest() {
+  const uint64_t total_bits = total_size_ * 8u;
+  const uint8_t padding_start = 0x80;
+  update(&padding_start, 1u);
+  const uint8_t zero = 0u;
+  while (buffer_size_ != 56u) update(&zero, 1u);
+  uint8_t length_bytes[8];
+  for (uint32_t i = 0u; i < 8u; ++i) {
+    length_bytes[i] = (uint8_t)(total_bits >> (56u - i * 8u));
+  }
+  update(length_bytes, sizeof(length_bytes));
+
+  static const char hex_chars[] = "0123456789abcdef";
+  std::string result;
+  result.reserve(64u);
+  for (uint32_t i = 0u; i < 8u; ++i) {
+    for (int32_t shift = 28; shift >= 0; shift -= 4) {
+      result.push_back(hex_chars[(state_[i] >> shift) & 0xfu]);
+    }
+  }
+  return result;
+}
+
+std::string sha256_hex(const void *data, size_t size) {
+  sha256 h;
+  h.update(data, size);
+  return h.hex_digest();
+}
@@ -0,0 +1,56 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+// Incremental SHA-256 hasher.
+class sha256 {
+public:
+  sha256();
+
+  // Appends bytes to the hashed message.
+  void update(const void *data, size_t size);
+
+  // Appends a length-prefixed string to the hashed message. Hashing strings
+  // this way prevents ambiguities like ("ab", "c") vs ("a", "bc").
+  void update_string(const std::string &s);
+
+  // Appends a 32-bit value to the hashed message.
+  void update_field(uint32_t value);
+
+  // Finishes hashing and returns the digest as a lowercase hex string.
+  std::string hex_digest();
+
+private:
+  void process_block(const uint8_t *block);
+
+  uint32_t state_[8];
+  uint8_t buffer_[64];
+  size_t buffer_size_ = 0u;
+  uint64_t total_size_ = 0u;
+};
+
+// Returns the hex SHA-256 digest of the given data.
+std::string sha256_hex(const void *data, size_t size);
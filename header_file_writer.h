@@ -22,69 +22,72 @@
 
 #pragma once
 
+#include <algorithm>
 #include <stdio.h>
 #include <string>
-#include "file_utils.h"
+#include "cbuffer_layout.h"
 #include "pipeline_layout.h"
 
+// Generates a C++ header with named constants for descriptor bindings and
+// sets used by each technique, for the layouts of its uniform buffers and for
+// the properties of its fragment shader.
 class header_file_writer {
 public:
-  header_file_writer(const std::string &f,
-                     const std::string &p,
-                     const std::string &n)
-                     : path_(f + PATH_SEPARATOR + p),
-                       has_namespace_(!n.empty()),
-                       file_(p.empty()
-                               ? NULL
-                               : fopen(path_.c_str(), "wb")) {
-    if (file_) {
-      fprintf(file_, "/*auto-generated, do not edit*/\n"
-                     "#pragma once\n");
-      if (has_namespace_) fprintf(file_, "namespace %s {\n", n.c_str());
-    }
-  
+  explicit header_file_writer(const std::string &n) : namespace_(n) {
+    contents_ = "/*auto-generated, do not edit*/\n"
+                "#pragma once\n";
+    if (!namespace_.empty()) contents_ += "namespace " + namespace_ + " {\n";
   }
-  ~header_file_writer() {
-    if(file_) {
-      if (has_namespace_) fprintf(file_, "}\n");
-      fclose(file_);
-    }
-   }
 
   void begin_technique(const std::string &name) {
     std::string ident = name;
     std::replace_if(ident.begin(), ident.end(),
                     [](char c) { return c == '-'; }, '_');
-    if(file_) fprintf(file_, "namespace %s {\n", ident.c_str());
+    contents_ += "namespace " + ident + " {\n";
   }
 
   void end_technique() {
-    if(file_) fprintf(file_, "}\n");
+    contents_ += "}\n";
   }
 
   void write_descriptor(const descriptor &d, uint32_t set_id) {
-    if(file_) {
-      // HACK remove `type.` prefix inserted by DXC from uniform buffer
-      // names.
-      const bool is_ubo = 
-        d.type == descriptor_type::UNIFORM_BUFFER;
-      const char *descriptor_name =
-          is_ubo && d.name.substr(0, 5) == "type." ? &d.name[5] : d.name.c_str();
+    // HACK remove `type.` prefix inserted by DXC from uniform buffer
+    // names.
+    const bool is_ubo = 
+      d.type == descriptor_type::UNIFORM_BUFFER;
+    const char *descriptor_name =
+        is_ubo && d.name.substr(0, 5) == "type." ? &d.name[5] : d.name.c_str();
+
+    contents_ += std::string("  static constexpr int ") + descriptor_name +
+                 "_Binding = " + std::to_string(d.slot) + ";\n" +
+                 "  static constexpr int " + descriptor_name +
+                 "_Set = " + std::to_string(set_id) + ";\n";
+  }
 
-      fprintf(file_,
-              "  static constexpr int %s_Binding = %d;\n"
-              "  static constexpr int %s_Set = %d;\n",
-              descriptor_name, d.slot,
-              descriptor_name, set_id);
+  void write_cbuffer_layout(const cbuffer_layout &layout) {
+    contents_ += "  static constexpr int " + layout.name + "_Size = " +
+                 std::to_string(layout.size) + ";\n";
+    for (const cbuffer_member &m : layout.members) {
+      contents_ += "  static constexpr int " + layout.name + "_" + m.name +
+                   "_Offset = " + std::to_string(m.offset) + ";\n";
     }
   }
-  
-  bool is_open() const { return file_ != NULL; }
 
-  const char* path() const { return path_.c_str(); }
+  void write_fragment_properties(uint32_t properties) {
+    char value[16];
+    snprintf(value, sizeof(value), "0x%02x", properties);
+    contents_ += std::string("  static constexpr int FragmentProperties = ") +
+                 value + ";\n";
+  }
+
+  // Finishes the header. Nothing may be added afterwards.
+  void finalize() {
+    if (!namespace_.empty()) contents_ += "}\n";
+  }
+
+  const std::string& contents() const { return contents_; }
 
 private:
-  std::string path_;
-  bool has_namespace_;
-  FILE *file_ = NULL;
+  std::string namespace_;
+  std::string contents_;
 };
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "hot_reload.h"
+#include "hash_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+namespace {
+
+// Subscribers that can't take a frame within this time are dropped, so that
+// a stalled application doesn't hold up rebuilds.
+constexpr uint32_t SUBSCRIBER_SEND_TIMEOUT_MS = 1000u;
+
+}
+
+hot_reload_publisher::hot_reload_publisher(const std::string &host_port) {
+  listener_ = tcp_socket::listen_on(host_port);
+  if (!listener_.is_valid()) {
+    fprintf(stderr, "Failed to listen on %s\n", host_port.c_str());
+    exit(1);
+  }
+  // The publisher lives for as long as the process does, so the thread is
+  // never joined.
+  std::thread([this] { accept_subscribers(); }).detach();
+}
+
+void hot_reload_publisher::accept_subscribers() {
+  for (;;) {
+    tcp_socket subscriber = listener_.accept_connection();
+    if (!subscriber.is_valid() ||
+        !subscriber.set_timeout(SUBSCRIBER_SEND_TIMEOUT_MS)) {
+      continue;
+    }
+    // Bring the new subscriber up to date. The backlog is sent without
+    // holding the lock, so that a slow subscriber doesn't hold up publishing;
+    // techniques published in the meantime are sent in another round, until
+    // the subscriber has everything and can be added.
+    std::map<std::string, std::string> sent_messages;
+    bool ok = true;
+    while (ok) {
+      std::vector<std::string> backlog;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &message : latest_messages_) {
+          std::string &sent_message = sent_messages[message.first];
+          if (sent_message != message.second) {
+            sent_message = message.second;
+            backlog.push_back(message.second);
+          }
+        }
+        if (backlog.empty()) {
+          subscribers_.emplace_back(std::move(subscriber));
+          break;
+        }
+      }
+      for (const std::string &message : backlog) {
+        if (!(ok = subscriber.send_frame(message))) break;
+      }
+    }
+  }
+}
+
+void hot_reload_publisher::publish(const std::string &technique_name,
+                                   const std::vector<published_file> &files,
+                                   const std::string &pipeline_metadata) {
+  wire_writer w;
+  w.write_field(HOT_RELOAD_PROTOCOL_VERSION);
+  w.write_string(technique_name);
+  w.write_field((uint32_t)files.size());
+  for (const published_file &f : files) {
+    w.write_string(f.name);
+    w.write_string(sha256_hex(f.data.data(), f.data.size()));
+    w.write_string(f.data);
+  }
+  w.write_string(sha256_hex(pipeline_metadata.data(),
+                            pipeline_metadata.size()));
+  w.write_string(pipeline_metadata);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string &latest_message = latest_messages_[technique_name];
+  if (latest_message == w.data()) return;
+  latest_message = w.data();
+  for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+    if (it->send_frame(latest_message)) {
+      ++it;
+    } else {
+      it = subscribers_.erase(it);
+    }
+  }
+}
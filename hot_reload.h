@@ -0,0 +1,70 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "net_utils.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Version of the hot-reload message layout. Must match
+// NGF_PLHR_PROTOCOL_VERSION in metadata_parser/hot_reload_client.h.
+constexpr uint32_t HOT_RELOAD_PROTOCOL_VERSION = 1u;
+
+// An output file generated for a technique.
+struct published_file {
+  std::string name; // File name, relative to the output folder.
+  std::string data;
+};
+
+// Pushes rebuilt techniques to subscribed applications over TCP, so that they
+// can swap pipelines without scanning the output folder.
+//
+// Each technique is sent as a single frame (see `tcp_socket::send_frame')
+// containing the technique name, the generated files and the pipeline
+// metadata, along with the SHA-256 hash of each. Subscribers receive the
+// latest version of every technique upon connecting, and after that only
+// the techniques whose outputs change.
+class hot_reload_publisher {
+public:
+  // Starts accepting subscribers on the given `host:port' address in the
+  // background. Exits if the address can't be listened on.
+  explicit hot_reload_publisher(const std::string &host_port);
+
+  // Publishes a technique, unless it is unchanged since it was last
+  // published. Subscribers that can't be reached, or don't keep up with the
+  // updates, are dropped.
+  void publish(const std::string &technique_name,
+               const std::vector<published_file> &files,
+               const std::string &pipeline_metadata);
+
+private:
+  void accept_subscribers();
+
+  tcp_socket listener_;
+  std::mutex mutex_;
+  std::vector<tcp_socket> subscribers_;
+  std::map<std::string, std::string> latest_messages_;
+};
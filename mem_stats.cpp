@@ -0,0 +1,214 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "mem_stats.h"
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr uint32_t PHASE_COUNT = (uint32_t)build_phase::count;
+
+struct phase_counters {
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> bytes_allocated;
+  std::atomic<int64_t> peak_live_bytes;
+};
+
+// These are constant-initialized, so they are usable from allocations that
+// happen before main.
+std::atomic<bool> enabled { false };
+std::atomic<uint32_t> current_phase { (uint32_t)build_phase::other };
+std::atomic<int64_t> live_bytes { 0 };
+phase_counters counters[PHASE_COUNT];
+
+// Every block is preceded by a header holding the number of bytes it was
+// counted as, which is zero for blocks allocated before counting started, so
+// that freeing those doesn't subtract what was never added.
+constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+void count_allocation(int64_t size) {
+  phase_counters &c = counters[current_phase.load(std::memory_order_relaxed)];
+  c.allocations.fetch_add(1u, std::memory_order_relaxed);
+  c.bytes_allocated.fetch_add((uint64_t)size, std::memory_order_relaxed);
+  const int64_t live =
+      live_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  int64_t peak = c.peak_live_bytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !c.peak_live_bytes.compare_exchange_weak(peak, live,
+                                                  std::memory_order_relaxed)) {
+  }
+}
+
+void count_deallocation(int64_t size) {
+  live_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+uint64_t peak_rss_bytes() {
+#if defined(_WIN32) || defined(_WIN64)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0u;
+  return pmc.PeakWorkingSetSize;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0u;
+#if defined(__APPLE__)
+  return (uint64_t)usage.ru_maxrss; // Reported in bytes on macOS.
+#else
+  return (uint64_t)usage.ru_maxrss * 1024u; // Reported in kilobytes.
+#endif
+#endif
+}
+
+}
+
+void* operator new(size_t size) {
+  if (size > SIZE_MAX - HEADER_SIZE) throw std::bad_alloc();
+  char *block = (char*)malloc(HEADER_SIZE + size);
+  if (block == nullptr) throw std::bad_alloc();
+  int64_t counted_size = 0;
+  if (enabled.load(std::memory_order_relaxed)) {
+    counted_size = (int64_t)size;
+    count_allocation(counted_size);
+  }
+  memcpy(block, &counted_size, sizeof(counted_size));
+  return block + HEADER_SIZE;
+}
+
+void operator delete(void *p) noexcept {
+  if (p == nullptr) return;
+  char *block = (char*)p - HEADER_SIZE;
+  int64_t counted_size = 0;
+  memcpy(&counted_size, block, sizeof(counted_size));
+  if (counted_size > 0) count_deallocation(counted_size);
+  free(block);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+// The remaining forms are replaced as well, since the standard library
+// doesn't necessarily implement them in terms of the ones above, and all
+// blocks need the header.
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept {
+  operator delete(p);
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete[](void *p) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept {
+  operator delete(p);
+}
+
+void enable_mem_stats() {
+  enabled = true;
+}
+
+void reset_mem_stats() {
+  for (phase_counters &c : counters) {
+    c.allocations = 0u;
+    c.bytes_allocated = 0u;
+    c.peak_live_bytes = live_bytes.load();
+  }
+}
+
+void set_build_phase(build_phase phase) {
+  current_phase = (uint32_t)phase;
+  // The high-water mark of a phase is at least what's live when it begins.
+  phase_counters &c = counters[(uint32_t)phase];
+  const int64_t live = live_bytes.load(std::memory_order_relaxed);
+  int64_t peak = c.peak_live_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !c.peak_live_bytes.compare_exchange_weak(peak, live)) {
+  }
+}
+
+std::string mem_stats_json() {
+  std::string json = "{\n  \"phases\": {\n";
+  uint64_t total_allocations = 0u, total_bytes = 0u;
+  int64_t peak_live_bytes = 0;
+  char buf[256];
+  for (uint32_t p = 0u; p < PHASE_COUNT; ++p) {
+    const uint64_t allocations = counters[p].allocations.load();
+    const uint64_t bytes = counters[p].bytes_allocated.load();
+    const int64_t peak = counters[p].peak_live_bytes.load();
+    total_allocations += allocations;
+    total_bytes += bytes;
+    if (peak > peak_live_bytes) peak_live_bytes = peak;
+    snprintf(buf, sizeof(buf),
+             "    \"%s\": { \"allocations\": %llu, \"bytes_allocated\": %llu, "
+             "\"peak_live_bytes\": %lld }%s\n",
+             build_phase_name((build_phase)p), (unsigned long long)allocations,
+             (unsigned long long)bytes, (long long)peak,
+             p + 1u < PHASE_COUNT ? "," : "");
+    json += buf;
+  }
+  snprintf(buf, sizeof(buf),
+           "  },\n"
+           "  \"total\": { \"allocations\": %llu, \"bytes_allocated\": %llu, "
+           "\"peak_live_bytes\": %lld },\n"
+           "  \"peak_rss_bytes\": %llu\n"
+           "}\n",
+           (unsigned long long)total_allocations,
+           (unsigned long long)total_bytes, (long long)peak_live_bytes,
+           (unsigned long long)peak_rss_bytes());
+  json += buf;
+  return json;
+}
@@ -0,0 +1,587 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#if defined(__linux__)
+#define _GNU_SOURCE // for syscall and O_CLOEXEC.
+#endif
+#include "batch_loader.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+  #include <windows.h>
+  typedef HANDLE _plbl_thread;
+  typedef CRITICAL_SECTION _plbl_mutex;
+  typedef CONDITION_VARIABLE _plbl_cond;
+  #define _PLBL_THREAD_LOCAL __declspec(thread)
+  #define _PLBL_THREAD_PROC DWORD WINAPI
+  #define _plbl_mutex_init(m) InitializeCriticalSection(m)
+  #define _plbl_mutex_destroy(m) DeleteCriticalSection(m)
+  #define _plbl_lock(m) EnterCriticalSection(m)
+  #define _plbl_unlock(m) LeaveCriticalSection(m)
+  #define _plbl_cond_init(c) InitializeConditionVariable(c)
+  #define _plbl_cond_destroy(c)
+  #define _plbl_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+  #define _plbl_broadcast(c) WakeAllConditionVariable(c)
+#else
+  #include <pthread.h>
+  #include <unistd.h>
+  typedef pthread_t _plbl_thread;
+  typedef pthread_mutex_t _plbl_mutex;
+  typedef pthread_cond_t _plbl_cond;
+  #define _PLBL_THREAD_LOCAL __thread
+  #define _PLBL_THREAD_PROC void*
+  #define _plbl_mutex_init(m) pthread_mutex_init(m, NULL)
+  #define _plbl_mutex_destroy(m) pthread_mutex_destroy(m)
+  #define _plbl_lock(m) pthread_mutex_lock(m)
+  #define _plbl_unlock(m) pthread_mutex_unlock(m)
+  #define _plbl_cond_init(c) pthread_cond_init(c, NULL)
+  #define _plbl_cond_destroy(c) pthread_cond_destroy(c)
+  #define _plbl_wait(c, m) pthread_cond_wait(c, m)
+  #define _plbl_broadcast(c) pthread_cond_broadcast(c)
+#endif
+#if defined(NGF_PLBL_HAVE_IO_URING)
+  #include <fcntl.h>
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/syscall.h>
+#endif
+
+// Arena chunks are at least this large. Bigger allocations get a chunk of
+// their own.
+#define _PLBL_CHUNK_SIZE (256u * 1024u)
+#define _PLBL_ALIGNMENT (16u)
+#define _PLBL_DEFAULT_QUEUE_DEPTH (64u)
+
+typedef struct _plbl_chunk {
+  struct _plbl_chunk *next;
+  size_t size;
+  size_t used;
+} _plbl_chunk;
+
+// State of a single file as it moves through the batch.
+typedef struct _plbl_file {
+  struct _plbl_file *next; // Next file in the queue of files to parse.
+  uint8_t *data;
+  size_t size;
+  size_t nread;
+  int fd;
+} _plbl_file;
+
+typedef struct _plbl_worker {
+  ngf_plbl_batch *batch;
+  _plbl_chunk *chunk; // Chunk that allocations are currently served from.
+  _plbl_thread thread;
+} _plbl_worker;
+
+struct ngf_plbl_batch {
+  uint32_t npaths;
+  const char *const *paths; // Only valid while loading.
+  ngf_plmd **metadata;
+  ngf_plbl_file_status *status;
+  _plbl_file *files;
+  ngf_plbl_io_backend backend;
+  bool trusted;
+  _plbl_mutex lock; // Guards everything below.
+  _plbl_cond cond; // Signaled when files are ready to parse or I/O is done.
+  _plbl_chunk *chunks; // All chunks of the arena.
+  _plbl_file *ready_head; // Files that have been read, but not parsed yet.
+  _plbl_file *ready_tail;
+  uint32_t next_unread; // Next file for the worker threads to read.
+  bool io_done; // Set once no more files will be added to the ready queue.
+};
+
+// ngf_plmd_alloc_callbacks don't carry a user pointer, so the worker that
+// the arena allocations are made on behalf of is kept in a thread local.
+static _PLBL_THREAD_LOCAL _plbl_worker *_current_worker = NULL;
+
+static void* _arena_alloc(size_t size) {
+  _plbl_worker *w = _current_worker;
+  assert(w);
+  size = (size + _PLBL_ALIGNMENT - 1u) & ~(size_t)(_PLBL_ALIGNMENT - 1u);
+  const size_t header_size =
+      (sizeof(_plbl_chunk) + _PLBL_ALIGNMENT - 1u) &
+      ~(size_t)(_PLBL_ALIGNMENT - 1u);
+  if (w->chunk == NULL || w->chunk->size - w->chunk->used < size) {
+    const bool dedicated = size > _PLBL_CHUNK_SIZE / 4u;
+    const size_t chunk_size = dedicated ? size : _PLBL_CHUNK_SIZE;
+    _plbl_chunk *chunk = malloc(header_size + chunk_size);
+    if (chunk == NULL) return NULL;
+    chunk->size = chunk_size;
+    chunk->used = 0u;
+    _plbl_lock(&w->batch->lock);
+    chunk->next = w->batch->chunks;
+    w->batch->chunks = chunk;
+    _plbl_unlock(&w->batch->lock);
+    if (dedicated) {
+      chunk->used = size;
+      return (uint8_t*)chunk + header_size;
+    }
+    w->chunk = chunk;
+  }
+  void *result = (uint8_t*)w->chunk + header_size + w->chunk->used;
+  w->chunk->used += size;
+  return result;
+}
+
+// Arena memory is released all at once when the batch is destroyed.
+static void _arena_free(void *ptr) {
+  (void)ptr;
+}
+
+#ifdef _MSC_VER
+#pragma warning(push)
+ // address of dllimport is not static, identity not guaranteed
+#pragma warning(disable:4232)
+#endif
+
+static const ngf_plmd_alloc_callbacks arena_alloc = {
+  .alloc = _arena_alloc,
+  .free = _arena_free
+};
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
+
+static void _parse_file(ngf_plbl_batch *b, _plbl_file *f) {
+  const uint32_t idx = (uint32_t)(f - b->files);
+  ngf_plmd_error (*load)(const void*, size_t, const ngf_plmd_alloc_callbacks*,
+                         ngf_plmd**) =
+      b->trusted ? ngf_plmd_load_trusted : ngf_plmd_load;
+  ngf_plmd *m = NULL;
+  b->status[idx].parse_error = load(f->data, f->size, &arena_alloc, &m);
+  b->metadata[idx] =
+      b->status[idx].parse_error == NGF_PLMD_ERROR_OK ? m : NULL;
+  free(f->data);
+  f->data = NULL;
+}
+
+// Reads a file with plain blocking I/O. Used by the thread pool.
+static void _read_file(ngf_plbl_batch *b, _plbl_file *f) {
+  const uint32_t idx = (uint32_t)(f - b->files);
+  FILE *file = fopen(b->paths[idx], "rb");
+  long size = -1;
+  if (file != NULL && fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+  if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+    b->status[idx].io_error = errno != 0 ? errno : EIO;
+  } else if ((f->data = malloc(size > 0 ? (size_t)size : 1u)) == NULL) {
+    b->status[idx].io_error = ENOMEM;
+  } else {
+    f->size = fread(f->data, 1u, (size_t)size, file);
+    if (f->size != (size_t)size) {
+      b->status[idx].io_error = EIO;
+      free(f->data);
+      f->data = NULL;
+    }
+  }
+  if (file != NULL) fclose(file);
+}
+
+static _PLBL_THREAD_PROC _worker_proc(void *arg) {
+  _plbl_worker *w = arg;
+  ngf_plbl_batch *b = w->batch;
+  _current_worker = w;
+  _plbl_lock(&b->lock);
+  for (;;) {
+    _plbl_file *f = NULL;
+    bool needs_read = false;
+    if (b->ready_head != NULL) {
+      f = b->ready_head;
+      b->ready_head = f->next;
+      if (b->ready_head == NULL) b->ready_tail = NULL;
+    } else if (b->next_unread < b->npaths) {
+      f = &b->files[b->next_unread++];
+      needs_read = true;
+    } else if (b->io_done) {
+      break;
+    } else {
+      _plbl_wait(&b->cond, &b->lock);
+      continue;
+    }
+    _plbl_unlock(&b->lock);
+    if (needs_read) _read_file(b, f);
+    if (f->data != NULL) _parse_file(b, f);
+    _plbl_lock(&b->lock);
+  }
+  _plbl_unlock(&b->lock);
+  _current_worker = NULL;
+  return 0;
+}
+
+#if defined(NGF_PLBL_HAVE_IO_URING)
+
+// A minimal io_uring wrapper, using the raw system calls so as not to depend
+// on liburing.
+typedef struct _plbl_ring {
+  int fd;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+} _plbl_ring;
+
+static void _ring_destroy(_plbl_ring *r) {
+  if (r->sqes != NULL && r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_size);
+  if (r->cq_ptr != NULL && r->cq_ptr != MAP_FAILED && r->cq_ptr != r->sq_ptr) {
+    munmap(r->cq_ptr, r->cq_size);
+  }
+  if (r->sq_ptr != NULL && r->sq_ptr != MAP_FAILED) munmap(r->sq_ptr, r->sq_size);
+  if (r->fd >= 0) close(r->fd);
+}
+
+static bool _ring_init(_plbl_ring *r, uint32_t depth) {
+  struct io_uring_params p;
+  memset(r, 0, sizeof(*r));
+  memset(&p, 0, sizeof(p));
+  r->fd = (int)syscall(__NR_io_uring_setup, depth, &p);
+  if (r->fd < 0) return false;
+  r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (r->cq_size > r->sq_size) r->sq_size = r->cq_size;
+    r->cq_size = r->sq_size;
+  }
+  r->sq_ptr = mmap(NULL, r->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   r->fd, IORING_OFF_SQ_RING);
+  if (r->sq_ptr == MAP_FAILED) goto _ring_init_fail;
+  r->cq_ptr = (p.features & IORING_FEAT_SINGLE_MMAP)
+      ? r->sq_ptr
+      : mmap(NULL, r->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+             r->fd, IORING_OFF_CQ_RING);
+  if (r->cq_ptr == MAP_FAILED) goto _ring_init_fail;
+  r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 r->fd, IORING_OFF_SQES);
+  if (r->sqes == MAP_FAILED) goto _ring_init_fail;
+  r->sq_tail = (unsigned*)((uint8_t*)r->sq_ptr + p.sq_off.tail);
+  r->sq_mask = (unsigned*)((uint8_t*)r->sq_ptr + p.sq_off.ring_mask);
+  r->sq_array = (unsigned*)((uint8_t*)r->sq_ptr + p.sq_off.array);
+  r->cq_head = (unsigned*)((uint8_t*)r->cq_ptr + p.cq_off.head);
+  r->cq_tail = (unsigned*)((uint8_t*)r->cq_ptr + p.cq_off.tail);
+  r->cq_mask = (unsigned*)((uint8_t*)r->cq_ptr + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe*)((uint8_t*)r->cq_ptr + p.cq_off.cqes);
+  return true;
+_ring_init_fail:
+  _ring_destroy(r);
+  return false;
+}
+
+// Queues a read of the remainder of the given file.
+static void _ring_queue_read(_plbl_ring *r, ngf_plbl_batch *b, _plbl_file *f) {
+  const unsigned tail = *r->sq_tail;
+  const unsigned idx = tail & *r->sq_mask;
+  struct io_uring_sqe *sqe = &r->sqes[idx];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = f->fd;
+  sqe->addr = (uint64_t)(uintptr_t)(f->data + f->nread);
+  sqe->len = (uint32_t)(f->size - f->nread);
+  sqe->off = f->nread;
+  sqe->user_data = (uint64_t)(f - b->files);
+  r->sq_array[idx] = idx;
+  __atomic_store_n(r->sq_tail, tail + 1u, __ATOMIC_RELEASE);
+}
+
+static void _finish_read(ngf_plbl_batch *b, _plbl_file *f, int io_error) {
+  close(f->fd);
+  f->fd = -1;
+  if (io_error != 0) {
+    b->status[f - b->files].io_error = io_error;
+    free(f->data);
+    f->data = NULL;
+    return;
+  }
+  _plbl_lock(&b->lock);
+  f->next = NULL;
+  if (b->ready_tail != NULL) b->ready_tail->next = f;
+  else b->ready_head = f;
+  b->ready_tail = f;
+  _plbl_broadcast(&b->cond);
+  _plbl_unlock(&b->lock);
+}
+
+// Opens the files and keeps up to `depth' reads in flight, handing each file
+// over to the workers once it has been read completely. Runs on the calling
+// thread while the workers parse.
+static void _read_files_io_uring(ngf_plbl_batch *b, _plbl_ring *r,
+                                 uint32_t depth) {
+  uint32_t next = 0u, ninflight = 0u, nqueued = 0u;
+  int ring_error = 0;
+  while ((next < b->npaths || ninflight > 0u) && ring_error == 0) {
+    while (next < b->npaths && ninflight < depth) {
+      _plbl_file *f = &b->files[next];
+      struct stat st;
+      f->fd = open(b->paths[next++], O_RDONLY | O_CLOEXEC);
+      if (f->fd < 0) {
+        b->status[f - b->files].io_error = errno;
+        continue;
+      }
+      if (fstat(f->fd, &st) != 0 ||
+          (f->data = malloc(st.st_size > 0 ? (size_t)st.st_size : 1u)) ==
+              NULL) {
+        _finish_read(b, f, errno != 0 ? errno : ENOMEM);
+        continue;
+      }
+      f->size = (size_t)st.st_size;
+      if (f->size == 0u) {
+        _finish_read(b, f, 0);
+        continue;
+      }
+      _ring_queue_read(r, b, f);
+      ++ninflight;
+      ++nqueued;
+    }
+    if (ninflight == 0u) continue;
+    const int nsubmitted = (int)syscall(__NR_io_uring_enter, r->fd, nqueued,
+                                        1u, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (nsubmitted < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        ring_error = errno;
+      }
+    } else {
+      nqueued -= (uint32_t)nsubmitted;
+    }
+    unsigned head = *r->cq_head;
+    const unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+      _plbl_file *f = &b->files[cqe->user_data];
+      if (cqe->res < 0) {
+        _finish_read(b, f, -cqe->res);
+      } else if (cqe->res == 0) {
+        _finish_read(b, f, EIO); // The file got shorter.
+      } else if ((f->nread += (size_t)cqe->res) < f->size) {
+        _ring_queue_read(r, b, f); // Short read, get the rest.
+        ++nqueued;
+        continue;
+      } else {
+        _finish_read(b, f, 0);
+      }
+      --ninflight;
+    }
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+  }
+  if (ring_error != 0) {
+    // The kernel may keep writing into the buffers of outstanding reads even
+    // after the ring is torn down, so wait for their completions before the
+    // buffers are released.
+    while (ninflight > 0u) {
+      const int nsubmitted = (int)syscall(__NR_io_uring_enter, r->fd, nqueued,
+                                          1u, IORING_ENTER_GETEVENTS, NULL, 0);
+      if (nsubmitted < 0) {
+        if (errno != EINTR) break;
+      } else {
+        nqueued -= (uint32_t)nsubmitted;
+      }
+      unsigned head = *r->cq_head;
+      const unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head, --ninflight) {
+        const struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+        _finish_read(b, &b->files[cqe->user_data], ring_error);
+      }
+      __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    }
+    // Files that are still open have reads that couldn't be waited for, and
+    // their buffers are leaked rather than handed back while the kernel may
+    // still write into them. Files that haven't been opened yet fail too.
+    _ring_destroy(r);
+    r->fd = -1;
+    r->sq_ptr = r->cq_ptr = NULL;
+    r->sqes = NULL;
+    for (uint32_t i = 0u; i < b->npaths; ++i) {
+      _plbl_file *f = &b->files[i];
+      if (f->fd >= 0 || i >= next) {
+        if (f->fd >= 0) close(f->fd);
+        f->fd = -1;
+        f->data = NULL;
+        b->status[i].io_error = ring_error;
+      }
+    }
+  }
+}
+
+#endif
+
+static uint32_t _default_nthreads(void) {
+#if defined(_WIN32) || defined(_WIN64)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1u;
+#else
+  const long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (uint32_t)n : 1u;
+#endif
+}
+
+static bool _start_thread(_plbl_worker *w) {
+#if defined(_WIN32) || defined(_WIN64)
+  w->thread = CreateThread(NULL, 0, _worker_proc, w, 0, NULL);
+  return w->thread != NULL;
+#else
+  return pthread_create(&w->thread, NULL, _worker_proc, w) == 0;
+#endif
+}
+
+static void _join_thread(_plbl_worker *w) {
+#if defined(_WIN32) || defined(_WIN64)
+  WaitForSingleObject(w->thread, INFINITE);
+  CloseHandle(w->thread);
+#else
+  pthread_join(w->thread, NULL);
+#endif
+}
+
+ngf_plbl_error ngf_plbl_load(const char *const *paths, uint32_t npaths,
+                             const ngf_plbl_options *options,
+                             ngf_plbl_batch **result) {
+  static const ngf_plbl_options default_options = { 0u, 0u, 0, 0 };
+  assert(paths || npaths == 0u);
+  assert(result);
+  if (options == NULL) options = &default_options;
+  *result = NULL;
+
+  ngf_plbl_batch *b = calloc(1u, sizeof(ngf_plbl_batch));
+  if (b == NULL) return NGF_PLBL_ERROR_OUTOFMEM;
+  _plbl_mutex_init(&b->lock);
+  _plbl_cond_init(&b->cond);
+  b->npaths = npaths;
+  b->paths = paths;
+  b->trusted = options->trusted != 0;
+  b->metadata = calloc(npaths > 0u ? npaths : 1u, sizeof(ngf_plmd*));
+  b->status = calloc(npaths > 0u ? npaths : 1u, sizeof(ngf_plbl_file_status));
+  b->files = calloc(npaths > 0u ? npaths : 1u, sizeof(_plbl_file));
+  if (b->metadata == NULL || b->status == NULL || b->files == NULL) {
+    ngf_plbl_destroy(b);
+    return NGF_PLBL_ERROR_OUTOFMEM;
+  }
+  for (uint32_t i = 0u; i < npaths; ++i) b->files[i].fd = -1;
+
+  // Set up io_uring if possible, and fall back to having the workers do
+  // blocking reads otherwise.
+  b->backend = NGF_PLBL_IO_BACKEND_THREAD_POOL;
+  b->io_done = true;
+#if defined(NGF_PLBL_HAVE_IO_URING)
+  const uint32_t depth =
+      options->queue_depth > 0u ? options->queue_depth
+                                : _PLBL_DEFAULT_QUEUE_DEPTH;
+  _plbl_ring ring;
+  if (!options->force_thread_pool && npaths > 0u && _ring_init(&ring, depth)) {
+    b->backend = NGF_PLBL_IO_BACKEND_IO_URING;
+    b->io_done = false;
+    b->next_unread = npaths; // Workers only parse.
+  }
+#endif
+
+  uint32_t nthreads =
+      options->nthreads > 0u ? options->nthreads : _default_nthreads();
+  if (nthreads > npaths) nthreads = npaths > 0u ? npaths : 1u;
+  _plbl_worker *workers = calloc(nthreads, sizeof(_plbl_worker));
+  ngf_plbl_error err = NGF_PLBL_ERROR_OK;
+  uint32_t nstarted = 0u;
+  if (workers == NULL) {
+    err = NGF_PLBL_ERROR_OUTOFMEM;
+  } else {
+    for (; nstarted < nthreads; ++nstarted) {
+      workers[nstarted].batch = b;
+      if (!_start_thread(&workers[nstarted])) {
+        err = NGF_PLBL_ERROR_THREAD_CREATION_FAILED;
+        break;
+      }
+    }
+  }
+
+#if defined(NGF_PLBL_HAVE_IO_URING)
+  if (b->backend == NGF_PLBL_IO_BACKEND_IO_URING) {
+    if (err == NGF_PLBL_ERROR_OK) _read_files_io_uring(b, &ring, depth);
+    _ring_destroy(&ring);
+    _plbl_lock(&b->lock);
+    b->io_done = true;
+    _plbl_broadcast(&b->cond);
+    _plbl_unlock(&b->lock);
+  }
+#endif
+  if (err != NGF_PLBL_ERROR_OK) {
+    // Let the workers that did start exit without doing anything.
+    _plbl_lock(&b->lock);
+    b->next_unread = npaths;
+    _plbl_unlock(&b->lock);
+  }
+  for (uint32_t t = 0u; t < nstarted; ++t) _join_thread(&workers[t]);
+  free(workers);
+  b->paths = NULL;
+  if (err != NGF_PLBL_ERROR_OK) {
+    ngf_plbl_destroy(b);
+    return err;
+  }
+  *result = b;
+  return NGF_PLBL_ERROR_OK;
+}
+
+ngf_plmd *const* ngf_plbl_get_metadata(const ngf_plbl_batch *b) {
+  return b->metadata;
+}
+
+const ngf_plbl_file_status* ngf_plbl_get_status(const ngf_plbl_batch *b) {
+  return b->status;
+}
+
+uint32_t ngf_plbl_get_count(const ngf_plbl_batch *b) {
+  return b->npaths;
+}
+
+ngf_plbl_io_backend ngf_plbl_get_io_backend(const ngf_plbl_batch *b) {
+  return b->backend;
+}
+
+void ngf_plbl_destroy(ngf_plbl_batch *b) {
+  if (b != NULL) {
+    for (_plbl_chunk *c = b->chunks; c != NULL;) {
+      _plbl_chunk *next = c->next;
+      free(c);
+      c = next;
+    }
+    if (b->files != NULL) {
+      for (uint32_t i = 0u; i < b->npaths; ++i) free(b->files[i].data);
+      free(b->files);
+    }
+    free(b->metadata);
+    free(b->status);
+    _plbl_cond_destroy(&b->cond);
+    _plbl_mutex_destroy(&b->lock);
+    free(b);
+  }
+}
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * Loads many pipeline metadata files at once. On Linux, the files are read
+ * through io_uring with many requests in flight, while worker threads parse
+ * the buffers as they arrive. Elsewhere, or if io_uring isn't available at
+ * runtime, the worker threads read and parse the files themselves.
+ *
+ * All parsed metadata is allocated from an arena owned by the batch, and is
+ * released all at once by ngf_plbl_destroy.
+ */
+typedef struct ngf_plbl_batch ngf_plbl_batch;
+
+typedef enum ngf_plbl_io_backend {
+  NGF_PLBL_IO_BACKEND_IO_URING,
+  NGF_PLBL_IO_BACKEND_THREAD_POOL
+} ngf_plbl_io_backend;
+
+typedef struct ngf_plbl_options {
+  /**
+   * Number of worker threads. 0 means one per online CPU.
+   */
+  uint32_t nthreads;
+  /**
+   * Maximum number of reads in flight when using io_uring. 0 means 64.
+   */
+  uint32_t queue_depth;
+  /**
+   * Nonzero to parse with ngf_plmd_load_trusted instead of ngf_plmd_load.
+   */
+  int trusted;
+  /**
+   * Nonzero to use the thread pool even if io_uring is available.
+   */
+  int force_thread_pool;
+} ngf_plbl_options;
+
+/**
+ * Outcome of loading a single file.
+ */
+typedef struct ngf_plbl_file_status {
+  int io_error; /**< 0, or the errno value if the file couldn't be read. */
+  ngf_plmd_error parse_error; /**< Only meaningful if io_error is 0. */
+} ngf_plbl_file_status;
+
+typedef enum ngf_plbl_error {
+  NGF_PLBL_ERROR_OK,
+  NGF_PLBL_ERROR_OUTOFMEM,
+  NGF_PLBL_ERROR_THREAD_CREATION_FAILED
+} ngf_plbl_error;
+
+/**
+ * Loads the pipeline metadata files at the given paths, and returns once all
+ * of them have been processed. Failing to read or parse an individual file
+ * is not an error; check ngf_plbl_get_status for each file instead.
+ * `options' may be NULL to use the defaults.
+ */
+ngf_plbl_error ngf_plbl_load(const char *const *paths, uint32_t npaths,
+                             const ngf_plbl_options *options,
+                             ngf_plbl_batch **result);
+
+/**
+ * Returns an array with the loaded metadata for each path, in the order the
+ * paths were given. Entries for files that failed to load are NULL. The
+ * metadata belongs to the batch and must not be passed to ngf_plmd_destroy.
+ */
+ngf_plmd *const* ngf_plbl_get_metadata(const ngf_plbl_batch *b);
+
+/**
+ * Returns an array with the outcome of loading each path.
+ */
+const ngf_plbl_file_status* ngf_plbl_get_status(const ngf_plbl_batch *b);
+
+uint32_t ngf_plbl_get_count(const ngf_plbl_batch *b);
+ngf_plbl_io_backend ngf_plbl_get_io_backend(const ngf_plbl_batch *b);
+
+void ngf_plbl_destroy(ngf_plbl_batch *b);
+
+#if defined(__cplusplus)
+}
+#endif
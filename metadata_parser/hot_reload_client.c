@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _POSIX_C_SOURCE 200112L // for getaddrinfo.
+#include "hot_reload_client.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32) || defined(_WIN64)
+  #pragma comment(lib, "ws2_32.lib")
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
+  typedef SOCKET _plhr_socket;
+  #define _PLHR_INVALID_SOCKET INVALID_SOCKET
+  #define _plhr_close closesocket
+  #define _plhr_would_block() (WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+  #include <arpa/inet.h>
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <netdb.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+  typedef int _plhr_socket;
+  #define _PLHR_INVALID_SOCKET (-1)
+  #define _plhr_close close
+  #define _plhr_would_block() (errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
+
+#ifdef _MSC_VER
+#pragma warning(push)
+ // address of dllimport is not static, identity not guaranteed
+#pragma warning(disable:4232)
+#endif
+
+static const ngf_plmd_alloc_callbacks stdlib_alloc = {
+  .alloc = malloc,
+  .free = free
+};
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
+
+// Messages larger than this are assumed to be garbage.
+#define _PLHR_MAX_MESSAGE_SIZE (256u * 1024u * 1024u)
+
+struct ngf_plhr_client {
+  const ngf_plmd_alloc_callbacks *alloc_cb;
+  _plhr_socket socket;
+  uint8_t *buf; // Received bytes that haven't been consumed yet.
+  size_t buf_size;
+  size_t buf_capacity;
+  size_t consumed; // Bytes of the last returned message.
+  int disconnected; // Set once the peer has closed the connection.
+  ngf_plhr_file *files; // Storage for the last returned update.
+  char *strings;
+};
+
+// Reads a big-endian field. Returns 0 if it doesn't fit in the message.
+static int _read_field(const uint8_t **ptr, const uint8_t *end,
+                       uint32_t *value) {
+  if ((size_t)(end - *ptr) < sizeof(uint32_t)) return 0;
+  uint32_t nbo;
+  memcpy(&nbo, *ptr, sizeof(nbo));
+  *value = ntohl(nbo);
+  *ptr += sizeof(uint32_t);
+  return 1;
+}
+
+// Reads a length-prefixed byte string.
+static int _read_bytes(const uint8_t **ptr, const uint8_t *end,
+                       const uint8_t **data, uint32_t *size) {
+  if (!_read_field(ptr, end, size) || (size_t)(end - *ptr) < *size) return 0;
+  *data = *ptr;
+  *ptr += *size;
+  return 1;
+}
+
+// Reads a length-prefixed string and copies it, null-terminated, to
+// `*strings', advancing it.
+static int _read_string(const uint8_t **ptr, const uint8_t *end,
+                        char **strings, const char **result) {
+  const uint8_t *data;
+  uint32_t size;
+  if (!_read_bytes(ptr, end, &data, &size)) return 0;
+  memcpy(*strings, data, size);
+  (*strings)[size] = '\0';
+  *result = *strings;
+  *strings += size + 1u;
+  return 1;
+}
+
+static void _release_update(ngf_plhr_client *c) {
+  if (c->files != NULL) {
+    c->alloc_cb->free(c->files);
+    c->files = NULL;
+  }
+  if (c->strings != NULL) {
+    c->alloc_cb->free(c->strings);
+    c->strings = NULL;
+  }
+  if (c->consumed > 0u) {
+    memmove(c->buf, c->buf + c->consumed, c->buf_size - c->consumed);
+    c->buf_size -= c->consumed;
+    c->consumed = 0u;
+  }
+}
+
+static ngf_plhr_error _parse_update(ngf_plhr_client *c,
+                                   const uint8_t *msg, uint32_t msg_size,
+                                   ngf_plhr_update *update) {
+  const uint8_t *ptr = msg, *end = msg + msg_size;
+  uint32_t version = 0u;
+  if (!_read_field(&ptr, end, &version)) {
+    return NGF_PLHR_ERROR_MALFORMED_MESSAGE;
+  }
+  if (version != NGF_PLHR_PROTOCOL_VERSION) {
+    return NGF_PLHR_ERROR_PROTOCOL_MISMATCH;
+  }
+
+  // Strings are copied out to add null terminators. Each one is preceded by
+  // a 4-byte length in the message, so this is always enough space.
+  c->strings = c->alloc_cb->alloc(msg_size);
+  if (c->strings == NULL) return NGF_PLHR_ERROR_OUTOFMEM;
+  char *strings = c->strings;
+
+  if (!_read_string(&ptr, end, &strings, &update->technique_name) ||
+      !_read_field(&ptr, end, &update->nfiles) ||
+      update->nfiles > msg_size / (3u * sizeof(uint32_t))) {
+    return NGF_PLHR_ERROR_MALFORMED_MESSAGE;
+  }
+  c->files = c->alloc_cb->alloc(sizeof(ngf_plhr_file) *
+                                (update->nfiles > 0u ? update->nfiles : 1u));
+  if (c->files == NULL) return NGF_PLHR_ERROR_OUTOFMEM;
+  for (uint32_t f = 0u; f < update->nfiles; ++f) {
+    ngf_plhr_file *file = &c->files[f];
+    const uint8_t *data;
+    if (!_read_string(&ptr, end, &strings, &file->name) ||
+        !_read_string(&ptr, end, &strings, &file->hash) ||
+        !_read_bytes(&ptr, end, &data, &file->size)) {
+      return NGF_PLHR_ERROR_MALFORMED_MESSAGE;
+    }
+    file->data = data;
+  }
+  update->files = c->files;
+  const uint8_t *metadata;
+  if (!_read_string(&ptr, end, &strings, &update->metadata_hash) ||
+      !_read_bytes(&ptr, end, &metadata, &update->metadata_size)) {
+    return NGF_PLHR_ERROR_MALFORMED_MESSAGE;
+  }
+  update->metadata = metadata;
+  return NGF_PLHR_ERROR_OK;
+}
+
+ngf_plhr_error ngf_plhr_connect(const char *host, const char *port,
+                                const ngf_plmd_alloc_callbacks *alloc_cb,
+                                ngf_plhr_client **result) {
+  assert(host);
+  assert(port);
+  assert(result);
+  *result = NULL;
+
+  // Use stdlib malloc/free by default.
+  if (alloc_cb == NULL) {
+    alloc_cb = &stdlib_alloc;
+  }
+
+#if defined(_WIN32) || defined(_WIN64)
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    return NGF_PLHR_ERROR_CONNECTION_FAILED;
+  }
+#endif
+
+  struct addrinfo hints, *addrs = NULL;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &addrs) != 0) {
+    return NGF_PLHR_ERROR_CONNECTION_FAILED;
+  }
+  _plhr_socket s = _PLHR_INVALID_SOCKET;
+  for (struct addrinfo *a = addrs; a != NULL; a = a->ai_next) {
+    s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (s == _PLHR_INVALID_SOCKET) continue;
+    if (connect(s, a->ai_addr, (int)a->ai_addrlen) == 0) break;
+    _plhr_close(s);
+    s = _PLHR_INVALID_SOCKET;
+  }
+  freeaddrinfo(addrs);
+  if (s == _PLHR_INVALID_SOCKET) {
+    return NGF_PLHR_ERROR_CONNECTION_FAILED;
+  }
+
+  // Polling must never block the application.
+#if defined(_WIN32) || defined(_WIN64)
+  u_long nonblocking = 1;
+  ioctlsocket(s, FIONBIO, &nonblocking);
+#else
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+  ngf_plhr_client *c = alloc_cb->alloc(sizeof(ngf_plhr_client));
+  if (c == NULL) {
+    _plhr_close(s);
+    return NGF_PLHR_ERROR_OUTOFMEM;
+  }
+  memset(c, 0, sizeof(ngf_plhr_client));
+  c->alloc_cb = alloc_cb;
+  c->socket = s;
+  *result = c;
+  return NGF_PLHR_ERROR_OK;
+}
+
+ngf_plhr_error ngf_plhr_poll(ngf_plhr_client *c, ngf_plhr_update *update,
+                             int *has_update) {
+  assert(c);
+  assert(update);
+  assert(has_update);
+  *has_update = 0;
+  _release_update(c);
+
+  // Receive everything that has arrived so far.
+  while (!c->disconnected) {
+    if (c->buf_capacity - c->buf_size < 4096u) {
+      const size_t new_capacity =
+          c->buf_capacity == 0u ? 65536u : c->buf_capacity * 2u;
+      uint8_t *new_buf = c->alloc_cb->alloc(new_capacity);
+      if (new_buf == NULL) return NGF_PLHR_ERROR_OUTOFMEM;
+      if (c->buf != NULL) {
+        memcpy(new_buf, c->buf, c->buf_size);
+        c->alloc_cb->free(c->buf);
+      }
+      c->buf = new_buf;
+      c->buf_capacity = new_capacity;
+    }
+    const int n = (int)recv(c->socket, (char*)c->buf + c->buf_size,
+                            (int)(c->buf_capacity - c->buf_size), 0);
+    if (n > 0) {
+      c->buf_size += (size_t)n;
+    } else if (n < 0 && _plhr_would_block()) {
+      break;
+    } else {
+      // Messages that arrived before the connection was closed are still
+      // delivered.
+      c->disconnected = 1;
+    }
+  }
+
+  // Return the first complete message, if any.
+  const ngf_plhr_error incomplete =
+      c->disconnected ? NGF_PLHR_ERROR_DISCONNECTED : NGF_PLHR_ERROR_OK;
+  uint32_t msg_size;
+  const uint8_t *ptr = c->buf;
+  if (!_read_field(&ptr, c->buf + c->buf_size, &msg_size)) {
+    return incomplete;
+  }
+  if (msg_size > _PLHR_MAX_MESSAGE_SIZE) {
+    return NGF_PLHR_ERROR_MALFORMED_MESSAGE;
+  }
+  if (c->buf_size - sizeof(uint32_t) < msg_size) {
+    return incomplete;
+  }
+  c->consumed = sizeof(uint32_t) + msg_size;
+  const ngf_plhr_error err = _parse_update(c, ptr, msg_size, update);
+  if (err == NGF_PLHR_ERROR_OK) *has_update = 1;
+  return err;
+}
+
+void ngf_plhr_disconnect(ngf_plhr_client *c) {
+  if (c == NULL) return;
+  _release_update(c);
+  _plhr_close(c->socket);
+  if (c->buf != NULL) c->alloc_cb->free(c->buf);
+  c->alloc_cb->free(c);
+#if defined(_WIN32) || defined(_WIN64)
+  WSACleanup();
+#endif
+}
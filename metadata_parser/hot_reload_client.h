@@ -0,0 +1,101 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * Receives techniques published by nicegraf_shaderc running with the
+ * `--publish' option, so that applications can swap pipelines as soon as
+ * they're rebuilt, without scanning the output folder.
+ */
+typedef struct ngf_plhr_client ngf_plhr_client;
+
+#define NGF_PLHR_PROTOCOL_VERSION (1u)
+
+/**
+ * A file generated for a technique.
+ */
+typedef struct ngf_plhr_file {
+  const char *name; /**< File name, relative to the output folder. */
+  const char *hash; /**< SHA-256 hash of the contents, as a hex string. */
+  const void *data; /**< Contents of the file. */
+  uint32_t size; /**< Size of the contents in bytes. */
+} ngf_plhr_file;
+
+/**
+ * A rebuilt technique.
+ */
+typedef struct ngf_plhr_update {
+  const char *technique_name;
+  uint32_t nfiles; /**< Number of generated files. */
+  const ngf_plhr_file *files;
+  const char *metadata_hash; /**< SHA-256 hash of the pipeline metadata. */
+  /**
+   * Contents of the technique's .pipeline file, which can be passed to
+   * ngf_plmd_load.
+   */
+  const void *metadata;
+  uint32_t metadata_size;
+} ngf_plhr_update;
+
+typedef enum ngf_plhr_error {
+  NGF_PLHR_ERROR_OK,
+  NGF_PLHR_ERROR_OUTOFMEM,
+  NGF_PLHR_ERROR_CONNECTION_FAILED,
+  NGF_PLHR_ERROR_DISCONNECTED,
+  NGF_PLHR_ERROR_PROTOCOL_MISMATCH,
+  NGF_PLHR_ERROR_MALFORMED_MESSAGE
+} ngf_plhr_error;
+
+/**
+ * Connects to a compiler publishing techniques on the given host and port.
+ */
+ngf_plhr_error ngf_plhr_connect(const char *host, const char *port,
+                                const ngf_plmd_alloc_callbacks *alloc_cb,
+                                ngf_plhr_client **result);
+
+/**
+ * Checks for a rebuilt technique without blocking. If one has arrived,
+ * `*has_update' is set to 1 and `update' is filled in; otherwise
+ * `*has_update' is set to 0. The contents of `update' remain valid until the
+ * next call to ngf_plhr_poll or ngf_plhr_disconnect. Call repeatedly (e.g.
+ * once per frame) until no more updates are reported. If the compiler goes
+ * away, the updates it sent before that are still returned, and
+ * NGF_PLHR_ERROR_DISCONNECTED is only reported once none are left.
+ */
+ngf_plhr_error ngf_plhr_poll(ngf_plhr_client *c, ngf_plhr_update *update,
+                             int *has_update);
+
+void ngf_plhr_disconnect(ngf_plhr_client *c);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -23,6 +23,9 @@
 #include "metadata_parser.h"
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #if defined(_WIN32) || defined(_WIN64)
@@ -49,38 +52,126 @@ static const ngf_plmd_alloc_callbacks stdlib_alloc = {
 
 struct ngf_plmd {
   uint8_t *raw_data;
-  const ngf_plmd_header *header;
+  ngf_plmd_header header;
   ngf_plmd_entrypoints entrypoints;
   ngf_plmd_layout layout;
   ngf_plmd_cis_map images_to_cis_map;
   ngf_plmd_cis_map samplers_to_cis_map;
   ngf_plmd_user user;
+  ngf_plmd_aliases aliases;
+  ngf_plmd_objects objects;
+  ngf_plmd_uniform_buffer_layouts uniform_buffer_layouts;
+  ngf_plmd_uniform_buffer_member *uniform_buffer_members;
+  ngf_plmd_root_signature root_signature;
+  ngf_plmd_subgroup_features subgroup_features;
+  ngf_plmd_draw_parameters draw_parameters;
+  ngf_plmd_binding_fixups binding_fixups;
+  ngf_plmd_fragment_properties fragment_properties;
+  ngf_plmd_sampling_usage sampling_usage;
+  ngf_plmd_compile_tier compile_tier;
+  ngf_plmd_instrumentation instrumentation;
 };
 
-static ngf_plmd_error _create_cis_map(uint8_t *ptr,
-                                  const ngf_plmd_alloc_callbacks *cb,
-                                  ngf_plmd_cis_map *map) {
-  assert(ptr);
-  map->nentries = *(uint32_t*)ptr;
+static const uint32_t START_OF_RAW_BYTE_BLOCK = 0xffffffff;
+static const uint32_t MAGIC_NUMBER = 0xdeadbeef;
+
+// Reads the fields and raw byte blocks of a record. When validating, every
+// read is checked against the end of the buffer. A failed read marks the
+// cursor as failed and moves it to the end of the buffer, so each record only
+// needs to be checked once, after it has been read. Without validation, the
+// checks compile down to nothing.
+typedef struct _ngf_plmd_cursor {
+  const uint8_t *ptr;
+  const uint8_t *end;
+  bool validate;
+  bool failed;
+} _ngf_plmd_cursor;
+
+static inline _ngf_plmd_cursor _cursor_at(const ngf_plmd *meta,
+                                          size_t buf_size,
+                                          uint32_t offset,
+                                          bool validate) {
+  _ngf_plmd_cursor c = {
+    &meta->raw_data[offset], &meta->raw_data[buf_size], validate, false
+  };
+  return c;
+}
+
+// Checks that `count' elements of `size' bytes each fit into the rest of the
+// buffer. Also used to bound counts before allocating memory for them.
+static inline bool _cursor_reserve(_ngf_plmd_cursor *c,
+                                   uint32_t count,
+                                   size_t size) {
+  if (c->validate &&
+      (c->failed || count > (size_t)(c->end - c->ptr) / size)) {
+    c->failed = true;
+    c->ptr = c->end;
+    return false;
+  }
+  return true;
+}
+
+static inline const void* _cursor_array(_ngf_plmd_cursor *c,
+                                        uint32_t count,
+                                        size_t size) {
+  const void *result = c->ptr;
+  if (_cursor_reserve(c, count, size)) c->ptr += count * size;
+  return result;
+}
+
+static inline uint32_t _cursor_field(_ngf_plmd_cursor *c) {
+  const uint32_t *field = _cursor_array(c, 1u, sizeof(uint32_t));
+  return c->failed ? 0u : *field;
+}
+
+// Reads a raw byte block holding a null-terminated string.
+static inline const char* _cursor_string(_ngf_plmd_cursor *c) {
+  const uint32_t marker = _cursor_field(c);
+  const uint32_t nwords = _cursor_field(c);
+  const char *str = _cursor_array(c, nwords, sizeof(uint32_t));
+  if (c->validate && !c->failed &&
+      (marker != START_OF_RAW_BYTE_BLOCK ||
+       memchr(str, '\0', nwords * sizeof(uint32_t)) == NULL)) {
+    c->failed = true;
+    c->ptr = c->end;
+  }
+  return str;
+}
+
+// Smallest possible size of a raw byte block holding a string.
+#define _MIN_STRING_SIZE (3u * sizeof(uint32_t))
+
+static ngf_plmd_error _create_cis_map(_ngf_plmd_cursor *c,
+                                      const ngf_plmd_alloc_callbacks *cb,
+                                      ngf_plmd_cis_map *map) {
+  map->nentries = _cursor_field(c);
+  if (!_cursor_reserve(c, map->nentries, 3u * sizeof(uint32_t))) {
+    return NGF_PLMD_ERROR_MALFORMED_RECORD;
+  }
   map->entries = cb->alloc(map->nentries * sizeof(ngf_plmd_cis_map_entry*));
   if (map->entries == NULL) {
     return NGF_PLMD_ERROR_OUTOFMEM;
   }
 
-  size_t offset = 4u;
   for (uint32_t e = 0u; e < map->nentries; ++e) {
-    map->entries[e] = (ngf_plmd_cis_map_entry*)(ptr + offset);
-    offset += 3 * 4u + map->entries[e]->ncombined_ids * sizeof(uint32_t);
+    map->entries[e] = (const ngf_plmd_cis_map_entry*)c->ptr;
+    _cursor_field(c);
+    _cursor_field(c);
+    const uint32_t ncombined_ids = _cursor_field(c);
+    _cursor_array(c, ncombined_ids, sizeof(uint32_t));
   }
 
-  return NGF_PLMD_ERROR_OK;
+  return c->failed ? NGF_PLMD_ERROR_MALFORMED_RECORD : NGF_PLMD_ERROR_OK;
 }
 
-ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
-                     const ngf_plmd_alloc_callbacks *alloc_cb,
-                     ngf_plmd **result) {
-  static const uint32_t START_OF_RAW_BYTE_BLOCK = 0xffffffff;
-  static const uint32_t MAGIC_NUMBER = 0xdeadbeef;
+// Parses the metadata. With `validate' set, the offsets, counts and raw byte
+// block lengths found in the buffer are checked before they're used, so that
+// malformed or malicious input results in an error instead of out-of-bounds
+// reads. Otherwise, the input is assumed to be well-formed.
+static inline ngf_plmd_error _ngf_plmd_load(const void *buf, size_t buf_size,
+                                   const ngf_plmd_alloc_callbacks *alloc_cb,
+                                   ngf_plmd **result,
+                                   bool validate) {
   ngf_plmd_error err = NGF_PLMD_ERROR_OK;
   ngf_plmd *meta = NULL;
   assert(buf);
@@ -92,7 +183,7 @@ ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
   }
   
   // Any well-formed pipeline metadata file must contain a multiple of 4 bytes.
-  if ((buf_size & 0b11) != 0) {
+  if ((buf_size & 0b11) != 0 || buf_size > UINT32_MAX) {
     err = NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE;
     goto ngf_plmd_load_cleanup;
   }
@@ -101,7 +192,7 @@ ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
 
   // Allocate space for the result.
   meta = alloc_cb->alloc(sizeof(ngf_plmd));
-  if (result == NULL) {
+  if (meta == NULL) {
     err = NGF_PLMD_ERROR_OUTOFMEM;
     goto ngf_plmd_load_cleanup;
   }
@@ -131,106 +222,394 @@ ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
       // and write it back to the buffer.
       const uint32_t raw_blk_size = ntohl(fields[field_idx]);
       fields[field_idx] = raw_blk_size;
+      if (validate && raw_blk_size > nfields - field_idx - 1u) {
+        err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+        goto ngf_plmd_load_cleanup;
+      }
       field_idx += raw_blk_size; // skip over the raw byte block contents.
     } else {
       fields[field_idx] = ntohl(field_value);
     }
   }
 
-  // Process header.
-  meta->header = (const ngf_plmd_header*)meta->raw_data;
-  const ngf_plmd_header *header = meta->header;
-  if (header->magic_number != MAGIC_NUMBER) {
+  // Process header. Headers written by older versions of the compiler are
+  // shorter, and the fields missing from them are left zeroed.
+  const ngf_plmd_header *header = &meta->header;
+  if (nfields < 2u ||
+      ((const ngf_plmd_header*)meta->raw_data)->magic_number != MAGIC_NUMBER) {
     err = NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH;
     goto ngf_plmd_load_cleanup;
   }
-
-  // Sanity-check offsets in the header.
-  if (header->entrypoints_offset >= buf_size ||
-      header->pipeline_layout_offset >= buf_size ||
-      header->image_to_cis_map_offset >= buf_size ||
-      header->sampler_to_cis_map_offset >= buf_size ||
-      header->user_metadata_offset >= buf_size) {
+  const uint32_t header_size =
+      ((const ngf_plmd_header*)meta->raw_data)->header_size;
+  if (validate &&
+      (header_size > buf_size ||
+       header_size < offsetof(ngf_plmd_header, aliases_offset))) {
     err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
     goto ngf_plmd_load_cleanup;
   }
+  memcpy(&meta->header, meta->raw_data,
+         header_size < sizeof(ngf_plmd_header) ? header_size
+                                               : sizeof(ngf_plmd_header));
+
+  // Sanity-check offsets in the header. All records consist of fields, so
+  // they must start at a multiple of 4 bytes.
+  if (validate) {
+    const uint32_t offsets[] = {
+      header->entrypoints_offset,
+      header->pipeline_layout_offset,
+      header->image_to_cis_map_offset,
+      header->sampler_to_cis_map_offset,
+      header->user_metadata_offset,
+      header->aliases_offset,
+      header->objects_offset,
+      header->uniform_buffer_layouts_offset,
+      header->root_signature_offset,
+      header->subgroup_features_offset,
+      header->draw_parameters_offset,
+      header->binding_fixups_offset,
+      header->fragment_properties_offset,
+      header->sampling_usage_offset,
+      header->compile_tier_offset,
+      header->instrumentation_offset
+    };
+    for (size_t o = 0u; o < sizeof(offsets) / sizeof(offsets[0]); ++o) {
+      if (offsets[o] >= buf_size || (offsets[o] & 0b11) != 0u) {
+        err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+        goto ngf_plmd_load_cleanup;
+      }
+    }
+  }
 
   // Process the entrypoints record.
-  const uint8_t *entrypoints_ptr =
-      &meta->raw_data[header->entrypoints_offset];
-  const uint32_t nentrypoints = *(const uint32_t*)entrypoints_ptr;
-  entrypoints_ptr += sizeof(uint32_t);
-  for (uint32_t ep = 0u; ep < nentrypoints; ++ep) {
-    const uint32_t kind = *(const uint32_t*)entrypoints_ptr;
-    entrypoints_ptr += 2u * sizeof(uint32_t);
-    const uint32_t size = *(const uint32_t*)entrypoints_ptr;
-    entrypoints_ptr += sizeof(uint32_t);
-    const char *name = (const char*)entrypoints_ptr;
-    entrypoints_ptr += size * sizeof(uint32_t);
+  _ngf_plmd_cursor c =
+      _cursor_at(meta, buf_size, header->entrypoints_offset, validate);
+  const uint32_t nentrypoints = _cursor_field(&c);
+  for (uint32_t ep = 0u; ep < nentrypoints && !c.failed; ++ep) {
+    const uint32_t kind = _cursor_field(&c);
+    const char *name = _cursor_string(&c);
     if (kind == 0) meta->entrypoints.vert_shader_entrypoint = name;
     else if (kind == 1) meta->entrypoints.frag_shader_entrypoint = name;
-    else {
+    else if (validate) {
       err = NGF_PLMD_ERROR_INVALID_SHADER_STAGE;
       goto ngf_plmd_load_cleanup;
     }
   }
+  if (c.failed) {
+    err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+    goto ngf_plmd_load_cleanup;
+  }
 
   // Process the pipeline layout record.
-  const uint8_t *pipeline_layout_ptr =
-      &meta->raw_data[header->pipeline_layout_offset];
-  const uint32_t nsets = *(const uint32_t*)pipeline_layout_ptr;
+  c = _cursor_at(meta, buf_size, header->pipeline_layout_offset, validate);
+  const uint32_t nsets = _cursor_field(&c);
+  if (!_cursor_reserve(&c, nsets, sizeof(uint32_t))) {
+    err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+    goto ngf_plmd_load_cleanup;
+  }
   meta->layout.ndescriptor_sets = nsets;
   meta->layout.set_layouts = alloc_cb->alloc(sizeof(void*) * nsets);
   if (meta->layout.set_layouts == NULL) {
     err = NGF_PLMD_ERROR_OUTOFMEM;
     goto ngf_plmd_load_cleanup;
   }
-  const uint8_t *set_ptr = pipeline_layout_ptr + sizeof(uint32_t);
   for (uint32_t s = 0u; s < nsets; ++s) {
-    meta->layout.set_layouts[s] = (const ngf_plmd_descriptor_set_layout*)set_ptr;
-    const uint32_t set_data_size =
-        meta->layout.set_layouts[s]->ndescriptors * sizeof(ngf_plmd_descriptor) +
-        sizeof(uint32_t);
-    set_ptr += set_data_size;
+    meta->layout.set_layouts[s] = (const ngf_plmd_descriptor_set_layout*)c.ptr;
+    const uint32_t ndescriptors = _cursor_field(&c);
+    _cursor_array(&c, ndescriptors, sizeof(ngf_plmd_descriptor));
+  }
+  if (c.failed) {
+    err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+    goto ngf_plmd_load_cleanup;
   }
 
   // Process combined image/sampler maps.
-  _create_cis_map((uint8_t*)meta->raw_data + header->image_to_cis_map_offset,
-                   alloc_cb,
-                   &meta->images_to_cis_map);
-  _create_cis_map((uint8_t*)meta->raw_data + header->sampler_to_cis_map_offset,
-                   alloc_cb,
-                   &meta->samplers_to_cis_map);
+  c = _cursor_at(meta, buf_size, header->image_to_cis_map_offset, validate);
+  err = _create_cis_map(&c, alloc_cb, &meta->images_to_cis_map);
+  if (err != NGF_PLMD_ERROR_OK) {
+    goto ngf_plmd_load_cleanup;
+  }
+  c = _cursor_at(meta, buf_size, header->sampler_to_cis_map_offset, validate);
+  err = _create_cis_map(&c, alloc_cb, &meta->samplers_to_cis_map);
+  if (err != NGF_PLMD_ERROR_OK) {
+    goto ngf_plmd_load_cleanup;
+  }
 
   // Process user metadata.
-  meta->user.nentries = 
-      *(uint32_t*)&meta->raw_data[header->user_metadata_offset];
+  c = _cursor_at(meta, buf_size, header->user_metadata_offset, validate);
+  meta->user.nentries = _cursor_field(&c);
+  if (!_cursor_reserve(&c, meta->user.nentries, 2u * _MIN_STRING_SIZE)) {
+    err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+    goto ngf_plmd_load_cleanup;
+  }
   meta->user.entries =
       alloc_cb->alloc(sizeof(ngf_plmd_user_entry) * meta->user.nentries);
   if (meta->user.entries == NULL) {
     err = NGF_PLMD_ERROR_OUTOFMEM;
     goto ngf_plmd_load_cleanup;
   }
-  uint8_t *blk_ptr = &meta->raw_data[header->user_metadata_offset + 4u];
   for (uint32_t e = 0u; e < meta->user.nentries; ++e) {
-    uint32_t *size_ptr = (uint32_t*)(blk_ptr + sizeof(uint32_t));
-    blk_ptr += 2 * sizeof(uint32_t);
-    meta->user.entries[e].key = (const char*)(blk_ptr);
-    blk_ptr += *size_ptr * sizeof(uint32_t);
+    meta->user.entries[e].key = _cursor_string(&c);
+    meta->user.entries[e].value = _cursor_string(&c);
+  }
+  if (c.failed) {
+    err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+    goto ngf_plmd_load_cleanup;
+  }
 
-    size_ptr = (uint32_t*)(blk_ptr + sizeof(uint32_t));
-    blk_ptr += 2 * sizeof(uint32_t);
-    meta->user.entries[e].value = (const char*)(blk_ptr);
-    blk_ptr += *size_ptr * sizeof(uint32_t);
+  // Process aliases.
+  if (header->aliases_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->aliases_offset, validate);
+    meta->aliases.nentries = _cursor_field(&c);
+    if (!_cursor_reserve(&c, meta->aliases.nentries, 2u * _MIN_STRING_SIZE)) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    meta->aliases.entries =
+        alloc_cb->alloc(sizeof(ngf_plmd_alias) * meta->aliases.nentries);
+    if (meta->aliases.entries == NULL) {
+      err = NGF_PLMD_ERROR_OUTOFMEM;
+      goto ngf_plmd_load_cleanup;
+    }
+    for (uint32_t e = 0u; e < meta->aliases.nentries; ++e) {
+      meta->aliases.entries[e].alias = _cursor_string(&c);
+      meta->aliases.entries[e].target = _cursor_string(&c);
+    }
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+  }
+
+  // Process object store references.
+  if (header->objects_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->objects_offset, validate);
+    meta->objects.nentries = _cursor_field(&c);
+    if (!_cursor_reserve(&c, meta->objects.nentries,
+                         sizeof(uint32_t) + 2u * _MIN_STRING_SIZE)) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    meta->objects.entries =
+        alloc_cb->alloc(sizeof(ngf_plmd_object_ref) * meta->objects.nentries);
+    if (meta->objects.entries == NULL) {
+      err = NGF_PLMD_ERROR_OUTOFMEM;
+      goto ngf_plmd_load_cleanup;
+    }
+    for (uint32_t e = 0u; e < meta->objects.nentries; ++e) {
+      meta->objects.entries[e].stage = _cursor_field(&c);
+      meta->objects.entries[e].name = _cursor_string(&c);
+      meta->objects.entries[e].hash = _cursor_string(&c);
+    }
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+  }
+
+  // Process uniform buffer layouts. The members of all buffers are stored in
+  // a single array, so the record is traversed twice: first to count them,
+  // then to fill them in.
+  if (header->uniform_buffer_layouts_offset != 0u) {
+    ngf_plmd_uniform_buffer_layouts *layouts = &meta->uniform_buffer_layouts;
+    c = _cursor_at(meta, buf_size, header->uniform_buffer_layouts_offset,
+                   validate);
+    layouts->nbuffers = _cursor_field(&c);
+    const _ngf_plmd_cursor buffers_start = c;
+    uint32_t nmembers_total = 0u;
+    for (uint32_t b = 0u; b < layouts->nbuffers && !c.failed; ++b) {
+      _cursor_array(&c, 3u, sizeof(uint32_t));
+      _cursor_string(&c);
+      const uint32_t nmembers = _cursor_field(&c);
+      for (uint32_t m = 0u; m < nmembers && !c.failed; ++m) {
+        _cursor_array(&c, 2u, sizeof(uint32_t));
+        _cursor_string(&c);
+      }
+      nmembers_total += nmembers;
+    }
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    layouts->buffers = alloc_cb->alloc(
+        sizeof(ngf_plmd_uniform_buffer_layout) * layouts->nbuffers);
+    meta->uniform_buffer_members = alloc_cb->alloc(
+        sizeof(ngf_plmd_uniform_buffer_member) * nmembers_total);
+    if (layouts->buffers == NULL || meta->uniform_buffer_members == NULL) {
+      err = NGF_PLMD_ERROR_OUTOFMEM;
+      goto ngf_plmd_load_cleanup;
+    }
+    ngf_plmd_uniform_buffer_member *member = meta->uniform_buffer_members;
+    c = buffers_start;
+    for (uint32_t b = 0u; b < layouts->nbuffers; ++b) {
+      ngf_plmd_uniform_buffer_layout *layout = &layouts->buffers[b];
+      layout->set = _cursor_field(&c);
+      layout->binding = _cursor_field(&c);
+      layout->size = _cursor_field(&c);
+      layout->name = _cursor_string(&c);
+      layout->nmembers = _cursor_field(&c);
+      layout->members = member;
+      for (uint32_t m = 0u; m < layout->nmembers; ++m, ++member) {
+        member->offset = _cursor_field(&c);
+        member->size = _cursor_field(&c);
+        member->name = _cursor_string(&c);
+      }
+    }
+  }
+
+  // Process the root signature.
+  if (header->root_signature_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->root_signature_offset, validate);
+    meta->root_signature.ntables = _cursor_field(&c);
+    if (!_cursor_reserve(&c, meta->root_signature.ntables,
+                         3u * sizeof(uint32_t))) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    ngf_plmd_root_table *tables = alloc_cb->alloc(
+        sizeof(ngf_plmd_root_table) * meta->root_signature.ntables);
+    if (tables == NULL) {
+      err = NGF_PLMD_ERROR_OUTOFMEM;
+      goto ngf_plmd_load_cleanup;
+    }
+    meta->root_signature.tables = tables;
+    for (uint32_t t = 0u; t < meta->root_signature.ntables; ++t) {
+      tables[t].register_space = _cursor_field(&c);
+      tables[t].is_sampler_table = _cursor_field(&c);
+      tables[t].nranges = _cursor_field(&c);
+      tables[t].ranges =
+          _cursor_array(&c, tables[t].nranges, sizeof(ngf_plmd_root_range));
+    }
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+  }
+
+  // Process subgroup features.
+  if (header->subgroup_features_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->subgroup_features_offset, validate);
+    const void *features =
+        _cursor_array(&c, 1u, sizeof(ngf_plmd_subgroup_features));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    memcpy(&meta->subgroup_features, features,
+           sizeof(ngf_plmd_subgroup_features));
+  }
+
+  // Process draw parameters.
+  if (header->draw_parameters_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->draw_parameters_offset, validate);
+    const void *draw_parameters =
+        _cursor_array(&c, 1u, sizeof(ngf_plmd_draw_parameters));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    memcpy(&meta->draw_parameters, draw_parameters,
+           sizeof(ngf_plmd_draw_parameters));
+  }
+
+  // Process binding fixups.
+  if (header->binding_fixups_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->binding_fixups_offset, validate);
+    meta->binding_fixups.nentries = _cursor_field(&c);
+    if (!_cursor_reserve(&c, meta->binding_fixups.nentries,
+                         2u * sizeof(uint32_t) + _MIN_STRING_SIZE)) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    meta->binding_fixups.entries =
+        alloc_cb->alloc(sizeof(ngf_plmd_binding_fixup) *
+                        meta->binding_fixups.nentries);
+    if (meta->binding_fixups.entries == NULL) {
+      err = NGF_PLMD_ERROR_OUTOFMEM;
+      goto ngf_plmd_load_cleanup;
+    }
+    for (uint32_t e = 0u; e < meta->binding_fixups.nentries; ++e) {
+      meta->binding_fixups.entries[e].type = _cursor_field(&c);
+      meta->binding_fixups.entries[e].native_binding = _cursor_field(&c);
+      meta->binding_fixups.entries[e].name = _cursor_string(&c);
+    }
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+  }
+
+  // Process fragment properties.
+  if (header->fragment_properties_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->fragment_properties_offset,
+                   validate);
+    const void *properties =
+        _cursor_array(&c, 1u, sizeof(ngf_plmd_fragment_properties));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    memcpy(&meta->fragment_properties, properties,
+           sizeof(ngf_plmd_fragment_properties));
+  }
+
+  // Process sampling usage.
+  if (header->sampling_usage_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->sampling_usage_offset, validate);
+    meta->sampling_usage.nentries = _cursor_field(&c);
+    meta->sampling_usage.entries = _cursor_array(
+        &c, meta->sampling_usage.nentries,
+        sizeof(ngf_plmd_sampling_usage_entry));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+  }
+
+  // Process the compile tier.
+  if (header->compile_tier_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->compile_tier_offset, validate);
+    const void *tier = _cursor_array(&c, 1u, sizeof(ngf_plmd_compile_tier));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    memcpy(&meta->compile_tier, tier, sizeof(ngf_plmd_compile_tier));
+  }
+
+  // Process the instrumentation record.
+  if (header->instrumentation_offset != 0u) {
+    c = _cursor_at(meta, buf_size, header->instrumentation_offset, validate);
+    const void *instrumentation =
+        _cursor_array(&c, 1u, sizeof(ngf_plmd_instrumentation));
+    if (c.failed) {
+      err = NGF_PLMD_ERROR_MALFORMED_RECORD;
+      goto ngf_plmd_load_cleanup;
+    }
+    memcpy(&meta->instrumentation, instrumentation,
+           sizeof(ngf_plmd_instrumentation));
   }
 
 ngf_plmd_load_cleanup:
   if (err != NGF_PLMD_ERROR_OK) {
     ngf_plmd_destroy(meta, alloc_cb);
+    *result = NULL;
   }
   return err;
 }
 
+ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
+                     const ngf_plmd_alloc_callbacks *alloc_cb,
+                     ngf_plmd **result) {
+  return _ngf_plmd_load(buf, buf_size, alloc_cb, result, true);
+}
+
+ngf_plmd_error ngf_plmd_load_trusted(const void *buf, size_t buf_size,
+                                     const ngf_plmd_alloc_callbacks *alloc_cb,
+                                     ngf_plmd **result) {
+  return _ngf_plmd_load(buf, buf_size, alloc_cb, result, false);
+}
+
 void ngf_plmd_destroy(ngf_plmd *m, const ngf_plmd_alloc_callbacks *alloc_cb) {
   if (alloc_cb == NULL) {
     alloc_cb = &stdlib_alloc;
@@ -251,6 +630,24 @@ void ngf_plmd_destroy(ngf_plmd *m, const ngf_plmd_alloc_callbacks *alloc_cb) {
     if (m->user.entries != NULL) {
       alloc_cb->free((void*)m->user.entries);
     }
+    if (m->aliases.entries != NULL) {
+      alloc_cb->free((void*)m->aliases.entries);
+    }
+    if (m->objects.entries != NULL) {
+      alloc_cb->free((void*)m->objects.entries);
+    }
+    if (m->uniform_buffer_layouts.buffers != NULL) {
+      alloc_cb->free((void*)m->uniform_buffer_layouts.buffers);
+    }
+    if (m->uniform_buffer_members != NULL) {
+      alloc_cb->free((void*)m->uniform_buffer_members);
+    }
+    if (m->root_signature.tables != NULL) {
+      alloc_cb->free((void*)m->root_signature.tables);
+    }
+    if (m->binding_fixups.entries != NULL) {
+      alloc_cb->free((void*)m->binding_fixups.entries);
+    }
     alloc_cb->free(m);
   }
 }
@@ -271,8 +668,60 @@ const ngf_plmd_user* ngf_plmd_get_user(const ngf_plmd *m) {
   return &m->user;
 }
 
+const ngf_plmd_aliases* ngf_plmd_get_aliases(const ngf_plmd *m) {
+  return &m->aliases;
+}
+
+const ngf_plmd_objects* ngf_plmd_get_objects(const ngf_plmd *m) {
+  return &m->objects;
+}
+
+const ngf_plmd_uniform_buffer_layouts*
+ngf_plmd_get_uniform_buffer_layouts(const ngf_plmd *m) {
+  return &m->uniform_buffer_layouts;
+}
+
+const ngf_plmd_root_signature* ngf_plmd_get_root_signature(const ngf_plmd *m) {
+  return &m->root_signature;
+}
+
+const ngf_plmd_subgroup_features*
+ngf_plmd_get_subgroup_features(const ngf_plmd *m) {
+  return &m->subgroup_features;
+}
+
+const ngf_plmd_draw_parameters*
+ngf_plmd_get_draw_parameters(const ngf_plmd *m) {
+  return &m->draw_parameters;
+}
+
+const ngf_plmd_binding_fixups*
+ngf_plmd_get_binding_fixups(const ngf_plmd *m) {
+  return &m->binding_fixups;
+}
+
+const ngf_plmd_fragment_properties*
+ngf_plmd_get_fragment_properties(const ngf_plmd *m) {
+  return &m->fragment_properties;
+}
+
+const ngf_plmd_sampling_usage*
+ngf_plmd_get_sampling_usage(const ngf_plmd *m) {
+  return &m->sampling_usage;
+}
+
+const ngf_plmd_compile_tier*
+ngf_plmd_get_compile_tier(const ngf_plmd *m) {
+  return &m->compile_tier;
+}
+
+const ngf_plmd_instrumentation*
+ngf_plmd_get_instrumentation(const ngf_plmd *m) {
+  return &m->instrumentation;
+}
+
 const ngf_plmd_header* ngf_plmd_get_header(const ngf_plmd *m) {
-  return m->header;
+  return &m->header;
 }
 
 const ngf_plmd_entrypoints* ngf_plmd_get_entrypoints(const ngf_plmd* m) {
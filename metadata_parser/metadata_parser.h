@@ -41,6 +41,47 @@ typedef struct ngf_plmd ngf_plmd;
 #define NGF_PLMD_STAGE_VISIBILITY_VERTEX_BIT   (0x01)
 #define NGF_PLMD_STAGE_VISIBILITY_FRAGMENT_BIT (0x02)
 
+/* Values match D3D12_DESCRIPTOR_RANGE_TYPE. */
+#define NGF_PLMD_ROOT_RANGE_SRV     (0x00)
+#define NGF_PLMD_ROOT_RANGE_UAV     (0x01)
+#define NGF_PLMD_ROOT_RANGE_CBV     (0x02)
+#define NGF_PLMD_ROOT_RANGE_SAMPLER (0x03)
+
+/* Values match VkSubgroupFeatureFlagBits. */
+#define NGF_PLMD_SUBGROUP_FEATURE_BASIC_BIT            (0x01)
+#define NGF_PLMD_SUBGROUP_FEATURE_VOTE_BIT             (0x02)
+#define NGF_PLMD_SUBGROUP_FEATURE_ARITHMETIC_BIT       (0x04)
+#define NGF_PLMD_SUBGROUP_FEATURE_BALLOT_BIT           (0x08)
+#define NGF_PLMD_SUBGROUP_FEATURE_SHUFFLE_BIT          (0x10)
+#define NGF_PLMD_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT (0x20)
+#define NGF_PLMD_SUBGROUP_FEATURE_CLUSTERED_BIT        (0x40)
+#define NGF_PLMD_SUBGROUP_FEATURE_QUAD_BIT             (0x80)
+
+#define NGF_PLMD_DRAW_PARAMETER_BASE_VERTEX_BIT   (0x01)
+#define NGF_PLMD_DRAW_PARAMETER_BASE_INSTANCE_BIT (0x02)
+#define NGF_PLMD_DRAW_PARAMETER_DRAW_INDEX_BIT    (0x04)
+
+#define NGF_PLMD_FRAGMENT_DISCARD_BIT           (0x01)
+#define NGF_PLMD_FRAGMENT_DEPTH_WRITE_BIT       (0x02)
+#define NGF_PLMD_FRAGMENT_DEPTH_GREATER_BIT     (0x04)
+#define NGF_PLMD_FRAGMENT_DEPTH_LESS_BIT        (0x08)
+#define NGF_PLMD_FRAGMENT_SAMPLE_MASK_WRITE_BIT (0x10)
+#define NGF_PLMD_FRAGMENT_EARLY_TESTS_BIT       (0x20)
+#define NGF_PLMD_FRAGMENT_EARLY_Z_ELIGIBLE_BIT  (0x40)
+#define NGF_PLMD_FRAGMENT_SIDE_EFFECTS_BIT      (0x80)
+
+#define NGF_PLMD_SAMPLING_IMPLICIT_LOD_BIT (0x01)
+#define NGF_PLMD_SAMPLING_EXPLICIT_LOD_BIT (0x02)
+#define NGF_PLMD_SAMPLING_GATHER_BIT       (0x04)
+#define NGF_PLMD_SAMPLING_FETCH_BIT        (0x08)
+#define NGF_PLMD_SAMPLING_QUERY_BIT        (0x10)
+#define NGF_PLMD_SAMPLING_DREF_BIT         (0x20)
+
+#define NGF_PLMD_COMPILE_TIER_FINAL (0)
+#define NGF_PLMD_COMPILE_TIER_FAST  (1)
+
+#define NGF_PLMD_INSTRUMENTATION_BUFFER_NAME "ngf_counters"
+
 /**
  * Pipeline metadata header.
  */
@@ -83,6 +124,73 @@ typedef struct ngf_plmd_header {
    * USER_METADATA record is stored.
    */
   uint32_t user_metadata_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the ALIASES
+   * record is stored. Zero if the file was produced by an older version of
+   * the compiler that did not write this record. (Since 0.2)
+   */
+  uint32_t aliases_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the OBJECTS
+   * record is stored. Zero if absent. (Since 0.3)
+   */
+  uint32_t objects_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * UNIFORM_BUFFER_LAYOUTS record is stored. Zero if absent. (Since 0.4)
+   */
+  uint32_t uniform_buffer_layouts_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * ROOT_SIGNATURE record is stored. Zero if absent. (Since 0.5)
+   */
+  uint32_t root_signature_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * SUBGROUP_FEATURES record is stored. Zero if absent. (Since 0.6)
+   */
+  uint32_t subgroup_features_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * DRAW_PARAMETERS record is stored. Zero if absent. (Since 0.7)
+   */
+  uint32_t draw_parameters_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * BINDING_FIXUPS record is stored. Zero if absent. (Since 0.8)
+   */
+  uint32_t binding_fixups_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * FRAGMENT_PROPERTIES record is stored. Zero if absent. (Since 0.9)
+   */
+  uint32_t fragment_properties_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * SAMPLING_USAGE record is stored. Zero if absent. (Since 0.10)
+   */
+  uint32_t sampling_usage_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * COMPILE_TIER record is stored. Zero if absent. (Since 0.11)
+   */
+  uint32_t compile_tier_offset;
+
+  /**
+   * Offset, in bytes, from the beginning of the file, at which the
+   * INSTRUMENTATION record is stored. Zero if absent. (Since 0.12)
+   */
+  uint32_t instrumentation_offset;
 } ngf_plmd_header;
 
 typedef struct ngf_plmd_entrypoints {
@@ -168,13 +276,210 @@ typedef struct ngf_plmd_user {
   ngf_plmd_user_entry *entries;
 } ngf_plmd_user;
 
+/**
+ * A generated file that is identical to another file generated for the same
+ * technique (typically for a different version of the same API).
+ */
+typedef struct ngf_plmd_alias {
+  const char *alias; /**< Name of the duplicate file. */
+  const char *target; /**< Name of the file it is identical to. */
+} ngf_plmd_alias;
+
+/**
+ * Aliased files. Applications may use this to avoid loading and compiling
+ * the same shader several times.
+ */
+typedef struct ngf_plmd_aliases {
+  uint32_t nentries; /**< Number of entries. */
+  ngf_plmd_alias *entries;
+} ngf_plmd_aliases;
+
+/**
+ * A reference to a shader stored in the content-addressed object store.
+ */
+typedef struct ngf_plmd_object_ref {
+  uint32_t stage; /**< 0 for the vertex stage, 1 for the fragment stage. */
+  const char *name; /**< Name the file would have outside of the store. */
+  const char *hash; /**< Hash of the contents, i.e. the file name within
+                         the `objects' folder. */
+} ngf_plmd_object_ref;
+
+/**
+ * Shaders of the technique stored in the content-addressed object store.
+ * Shaders with the same hash are identical, so applications can create a
+ * single shader module for each unique hash and share it between pipelines.
+ */
+typedef struct ngf_plmd_objects {
+  uint32_t nentries; /**< Number of entries. */
+  ngf_plmd_object_ref *entries;
+} ngf_plmd_objects;
+
+/**
+ * A member of a uniform buffer.
+ */
+typedef struct ngf_plmd_uniform_buffer_member {
+  const char *name; /**< Name of the member in the source code. */
+  uint32_t offset; /**< Offset from the start of the buffer, in bytes. */
+  uint32_t size; /**< Size of the member, in bytes. */
+} ngf_plmd_uniform_buffer_member;
+
+/**
+ * Memory layout of a uniform buffer (HLSL cbuffer). Applications should use
+ * the offsets listed here when writing to the buffer, since the compiler
+ * may reorder members to reduce padding.
+ */
+typedef struct ngf_plmd_uniform_buffer_layout {
+  uint32_t set; /**< Descriptor set of the buffer. */
+  uint32_t binding; /**< Binding of the buffer within the set. */
+  uint32_t size; /**< Size of the buffer contents, in bytes. */
+  const char *name; /**< Name of the buffer in the source code. */
+  uint32_t nmembers; /**< Number of members. */
+  const ngf_plmd_uniform_buffer_member *members; /**< Ordered by offset. */
+} ngf_plmd_uniform_buffer_layout;
+
+/**
+ * Layouts of the uniform buffers used by the technique.
+ */
+typedef struct ngf_plmd_uniform_buffer_layouts {
+  uint32_t nbuffers; /**< Number of buffers. */
+  ngf_plmd_uniform_buffer_layout *buffers;
+} ngf_plmd_uniform_buffer_layouts;
+
+/**
+ * A descriptor range within a root signature descriptor table. Each range
+ * holds a single descriptor.
+ */
+typedef struct ngf_plmd_root_range {
+  uint32_t range_type; /**< Type of the range (NGF_PLMD_ROOT_RANGE_...) */
+  uint32_t shader_register; /**< Register, equal to the descriptor binding. */
+} ngf_plmd_root_range;
+
+/**
+ * A root signature descriptor table. Ranges are laid out in the table in the
+ * order they are listed.
+ */
+typedef struct ngf_plmd_root_table {
+  uint32_t register_space; /**< Register space, equal to the descriptor set. */
+  uint32_t is_sampler_table; /**< Nonzero if the table holds samplers. */
+  uint32_t nranges; /**< Number of ranges. */
+  const ngf_plmd_root_range *ranges;
+} ngf_plmd_root_table;
+
+/**
+ * D3D12 root signature of the technique, derived from its pipeline layout.
+ * Empty unless the technique was compiled for the dxil target, in which case
+ * the same root signature is also embedded in the DXIL shaders.
+ */
+typedef struct ngf_plmd_root_signature {
+  uint32_t ntables; /**< Number of descriptor tables. */
+  const ngf_plmd_root_table *tables;
+} ngf_plmd_root_signature;
+
+/**
+ * Subgroup (wave) operations used by the technique. Devices must support
+ * all of the features from all of the stages in order to run it.
+ */
+typedef struct ngf_plmd_subgroup_features {
+  uint32_t features; /**< Mask of NGF_PLMD_SUBGROUP_FEATURE_..._BIT values. */
+  uint32_t stage_visibility_mask; /**< Mask of stages that use subgroup
+                                       operations. */
+} ngf_plmd_subgroup_features;
+
+/**
+ * Draw parameters (base vertex, base instance and draw index) read by the
+ * technique's vertex shader.
+ */
+typedef struct ngf_plmd_draw_parameters {
+  uint32_t used; /**< Mask of NGF_PLMD_DRAW_PARAMETER_..._BIT values. */
+} ngf_plmd_draw_parameters;
+
+/**
+ * A uniform block or combined image/sampler of the technique's GLES 3.0
+ * shaders, which can't declare their bindings in the code.
+ */
+typedef struct ngf_plmd_binding_fixup {
+  uint32_t type; /**< NGF_PLMD_DESC_UNIFORM_BUFFER or
+                      NGF_PLMD_DESC_COMBINED_IMAGE_SAMPLER. */
+  uint32_t native_binding; /**< Uniform block binding or texture unit. */
+  const char *name; /**< Name of the block or sampler in the shader code. */
+} ngf_plmd_binding_fixup;
+
+/**
+ * Bindings that applications have to assign to GLES 3.0 programs after
+ * linking them, ordered by type and native binding.
+ */
+typedef struct ngf_plmd_binding_fixups {
+  uint32_t nentries; /**< Number of entries. */
+  ngf_plmd_binding_fixup *entries;
+} ngf_plmd_binding_fixups;
+
+/**
+ * Properties of the technique's fragment shader that affect when depth and
+ * stencil tests can run. Applications may use them to order draws and to
+ * decide whether a depth prepass is worthwhile.
+ */
+typedef struct ngf_plmd_fragment_properties {
+  uint32_t flags; /**< Mask of NGF_PLMD_FRAGMENT_..._BIT values. */
+} ngf_plmd_fragment_properties;
+
+/**
+ * Describes how the technique's shaders access a texture, storage image or
+ * sampler.
+ */
+typedef struct ngf_plmd_sampling_usage_entry {
+  uint32_t set; /**< Descriptor set of the resource. */
+  uint32_t binding; /**< Binding of the resource within its set. */
+  uint32_t flags; /**< Mask of NGF_PLMD_SAMPLING_..._BIT values. */
+} ngf_plmd_sampling_usage_entry;
+
+/**
+ * Sampling usage of all textures, storage images and samplers in the
+ * pipeline layout.
+ */
+typedef struct ngf_plmd_sampling_usage {
+  uint32_t nentries; /**< Number of entries. */
+  const ngf_plmd_sampling_usage_entry *entries;
+} ngf_plmd_sampling_usage;
+
+/**
+ * Tier of a tiered build that the technique's shaders were produced by.
+ */
+typedef struct ngf_plmd_compile_tier {
+  /**
+   * NGF_PLMD_COMPILE_TIER_FAST if the shaders were compiled without
+   * optimizations, and are going to be replaced by optimized ones;
+   * NGF_PLMD_COMPILE_TIER_FINAL otherwise.
+   */
+  uint32_t tier;
+} ngf_plmd_compile_tier;
+
+/**
+ * Storage buffer holding the execution counters of instrumented shaders.
+ */
+typedef struct ngf_plmd_instrumentation {
+  /**
+   * Number of 32-bit counters in the buffer. Zero if the shaders aren't
+   * instrumented. The <technique>.counters.json file written next to the
+   * pipeline metadata maps each counter to a source location.
+   */
+  uint32_t ncounters;
+
+  /**
+   * Descriptor set and binding of the buffer, which is also listed in the
+   * pipeline layout under the name NGF_PLMD_INSTRUMENTATION_BUFFER_NAME.
+   */
+  uint32_t set;
+  uint32_t binding;
+} ngf_plmd_instrumentation;
+
 typedef enum ngf_plmd_error {
   NGF_PLMD_ERROR_OK,
   NGF_PLMD_ERROR_OUTOFMEM,
   NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH,
   NGF_PLMD_ERROR_BUFFER_TOO_SMALL,
   NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE,
-  NGF_PLMD_ERROR_INVALID_SHADER_STAGE
+  NGF_PLMD_ERROR_INVALID_SHADER_STAGE,
+  NGF_PLMD_ERROR_MALFORMED_RECORD
 } ngf_plmd_error;
 
 typedef struct ngf_plmd_alloc_callbacks {
@@ -182,14 +487,48 @@ typedef struct ngf_plmd_alloc_callbacks {
   void  (*free)(void*);
 } ngf_plmd_alloc_callbacks;
 
+/**
+ * Loads pipeline metadata from the given buffer. Every offset, count and raw
+ * byte block length in the buffer is checked, so this is safe to use on data
+ * from untrusted sources, such as mods or the network.
+ */
 ngf_plmd_error ngf_plmd_load(const void *buf, size_t buf_size,
                              const ngf_plmd_alloc_callbacks *alloc_cb,
                              ngf_plmd **result);
+
+/**
+ * Same as `ngf_plmd_load`, but skips the bounds checks. Only use this for
+ * metadata that is known to be well-formed (i.e. produced by nicegraf_shaderc
+ * and shipped or signed by you). Malformed input results in undefined
+ * behavior.
+ */
+ngf_plmd_error ngf_plmd_load_trusted(const void *buf, size_t buf_size,
+                                     const ngf_plmd_alloc_callbacks *alloc_cb,
+                                     ngf_plmd **result);
 void ngf_plmd_destroy(ngf_plmd *m, const ngf_plmd_alloc_callbacks *alloc_cb);
 const ngf_plmd_layout* ngf_plmd_get_layout(const ngf_plmd *m);
 const ngf_plmd_cis_map* ngf_plmd_get_image_to_cis_map(const ngf_plmd *m);
 const ngf_plmd_cis_map* ngf_plmd_get_sampler_to_cis_map(const ngf_plmd *m);
 const ngf_plmd_user* ngf_plmd_get_user(const ngf_plmd *m);
+const ngf_plmd_aliases* ngf_plmd_get_aliases(const ngf_plmd *m);
+const ngf_plmd_objects* ngf_plmd_get_objects(const ngf_plmd *m);
+const ngf_plmd_uniform_buffer_layouts*
+ngf_plmd_get_uniform_buffer_layouts(const ngf_plmd *m);
+const ngf_plmd_root_signature* ngf_plmd_get_root_signature(const ngf_plmd *m);
+const ngf_plmd_subgroup_features*
+ngf_plmd_get_subgroup_features(const ngf_plmd *m);
+const ngf_plmd_draw_parameters*
+ngf_plmd_get_draw_parameters(const ngf_plmd *m);
+const ngf_plmd_binding_fixups*
+ngf_plmd_get_binding_fixups(const ngf_plmd *m);
+const ngf_plmd_fragment_properties*
+ngf_plmd_get_fragment_properties(const ngf_plmd *m);
+const ngf_plmd_sampling_usage*
+ngf_plmd_get_sampling_usage(const ngf_plmd *m);
+const ngf_plmd_compile_tier*
+ngf_plmd_get_compile_tier(const ngf_plmd *m);
+const ngf_plmd_instrumentation*
+ngf_plmd_get_instrumentation(const ngf_plmd *m);
 const ngf_plmd_entrypoints* ngf_plmd_get_entrypoints(const ngf_plmd *m);
 const ngf_plmd_header* ngf_plmd_get_header(const ngf_plmd *m);
 
@@ -0,0 +1,309 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "net_utils.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#pragma comment(lib, "ws2_32.lib")
+#define close_socket_handle closesocket
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#define close_socket_handle ::close
+#endif
+
+namespace {
+
+// Performs one-time initialization of the socket library.
+void init_sockets() {
+  static const bool initialized = []() {
+#if defined(_WIN32) || defined(_WIN64)
+    WSADATA wsa_data;
+    return WSAStartup(MAKEWORD(2, 2), &wsa_data) == 0;
+#else
+    // Writing to a socket closed by the peer should produce an error code,
+    // not kill the process.
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+  }();
+  (void)initialized;
+}
+
+addrinfo* resolve(const std::string &host_port, bool passive) {
+  std::string host, port;
+  if (!split_host_port(host_port, host, port)) return nullptr;
+  addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_protocol = IPPROTO_TCP;
+  hints.ai_flags = passive ? AI_PASSIVE : 0;
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                  &result) != 0) {
+    return nullptr;
+  }
+  return result;
+}
+
+}
+
+bool split_host_port(const std::string &host_port,
+                     std::string &host,
+                     std::string &port) {
+  const size_t colon_pos = host_port.find_last_of(':');
+  if (colon_pos == std::string::npos || colon_pos == host_port.size() - 1u) {
+    return false;
+  }
+  host = host_port.substr(0, colon_pos);
+  port = host_port.substr(colon_pos + 1u);
+  return true;
+}
+
+tcp_socket tcp_socket::connect_to(const std::string &host_port,
+                                  uint32_t timeout_ms) {
+  init_sockets();
+  addrinfo *addrs = resolve(host_port, false);
+  tcp_socket result;
+  for (addrinfo *a = addrs; a != nullptr && !result.is_valid(); a = a->ai_next) {
+    tcp_socket s { socket(a->ai_family, a->ai_socktype, a->ai_protocol) };
+    if (s.is_valid() && (timeout_ms == 0u || s.set_timeout(timeout_ms)) &&
+        connect(s.handle_, a->ai_addr, (int)a->ai_addrlen) == 0) {
+      const int nodelay = 1;
+      setsockopt(s.handle_, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay,
+                 sizeof(nodelay));
+      result = std::move(s);
+    }
+  }
+  if (addrs) freeaddrinfo(addrs);
+  return result;
+}
+
+tcp_socket tcp_socket::listen_on(const std::string &host_port) {
+  init_sockets();
+  addrinfo *addrs = resolve(host_port, true);
+  tcp_socket result;
+  for (addrinfo *a = addrs; a != nullptr && !result.is_valid(); a = a->ai_next) {
+    tcp_socket s { socket(a->ai_family, a->ai_socktype, a->ai_protocol) };
+    if (!s.is_valid()) continue;
+    const int reuse = 1;
+    setsockopt(s.handle_, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse,
+               sizeof(reuse));
+    if (bind(s.handle_, a->ai_addr, (int)a->ai_addrlen) == 0 &&
+        listen(s.handle_, SOMAXCONN) == 0) {
+      result = std::move(s);
+    }
+  }
+  if (addrs) freeaddrinfo(addrs);
+  return result;
+}
+
+tcp_socket tcp_socket::accept_connection() const {
+  tcp_socket s { accept(handle_, nullptr, nullptr) };
+  if (s.is_valid()) {
+    const int nodelay = 1;
+    setsockopt(s.handle_, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay,
+               sizeof(nodelay));
+  }
+  return s;
+}
+
+bool tcp_socket::send_all(const void *data, size_t size) const {
+  const char *ptr = (const char*)data;
+  while (size > 0u) {
+    const int chunk = size > 0x10000000u ? 0x10000000 : (int)size;
+    const auto nsent = send(handle_, ptr, chunk, 0);
+    if (nsent <= 0) return false;
+    ptr += nsent;
+    size -= (size_t)nsent;
+  }
+  return true;
+}
+
+bool tcp_socket::recv_all(void *data, size_t size) const {
+  char *ptr = (char*)data;
+  while (size > 0u) {
+    const int chunk = size > 0x10000000u ? 0x10000000 : (int)size;
+    const auto nrecvd = recv(handle_, ptr, chunk, 0);
+    if (nrecvd <= 0) return false;
+    ptr += nrecvd;
+    size -= (size_t)nrecvd;
+  }
+  return true;
+}
+
+bool tcp_socket::send_frame(const std::string &payload) const {
+  if (payload.size() > MAX_FRAME_SIZE) return false;
+  const uint32_t nbo_size = htonl((uint32_t)payload.size());
+  return send_all(&nbo_size, sizeof(nbo_size)) &&
+         send_all(payload.data(), payload.size());
+}
+
+bool tcp_socket::recv_frame(std::string &payload) const {
+  uint32_t nbo_size = 0u;
+  if (!recv_all(&nbo_size, sizeof(nbo_size))) return false;
+  const uint32_t size = ntohl(nbo_size);
+  if (size > MAX_FRAME_SIZE) return false;
+  payload.resize(size);
+  return recv_all(&payload[0], payload.size());
+}
+
+bool tcp_socket::set_timeout(uint32_t timeout_ms) const {
+#if defined(_WIN32) || defined(_WIN64)
+  const DWORD timeout = timeout_ms;
+#else
+  timeval timeout;
+  timeout.tv_sec = (time_t)(timeout_ms / 1000u);
+  timeout.tv_usec = (suseconds_t)((timeout_ms % 1000u) * 1000u);
+#endif
+  return setsockopt(handle_, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout,
+                    sizeof(timeout)) == 0 &&
+         setsockopt(handle_, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout,
+                    sizeof(timeout)) == 0;
+}
+
+void tcp_socket::close() {
+  if (is_valid()) {
+    close_socket_handle(handle_);
+    handle_ = NGF_INVALID_SOCKET;
+  }
+}
+
+int http_request(const char *method,
+                 const std::string &url,
+                 const std::string &request_body,
+                 uint32_t timeout_ms,
+                 std::string &response_body) {
+  static const std::string scheme = "http://";
+  if (url.compare(0, scheme.size(), scheme) != 0) return 0;
+  const size_t path_pos = url.find('/', scheme.size());
+  std::string authority = url.substr(scheme.size(), path_pos - scheme.size());
+  const std::string path = path_pos == std::string::npos ? "/" : url.substr(path_pos);
+  const std::string host = authority.substr(0, authority.find_last_of(':'));
+  if (authority.find(':') == std::string::npos) authority += ":80";
+
+  tcp_socket s = tcp_socket::connect_to(authority, timeout_ms);
+  if (!s.is_valid()) return 0;
+  // HTTP/1.0 keeps servers from sending chunked responses.
+  const std::string request_header =
+      std::string(method) + " " + path + " HTTP/1.0\r\n" +
+      "Host: " + host + "\r\n" +
+      "Content-Length: " + std::to_string(request_body.size()) + "\r\n" +
+      "Connection: close\r\n\r\n";
+  if (!s.send_all(request_header.data(), request_header.size()) ||
+      !s.send_all(request_body.data(), request_body.size())) {
+    return 0;
+  }
+
+  // The connection is closed by the server after the response, so just read
+  // everything.
+  std::string response;
+  char chunk[16384];
+  for (;;) {
+    const auto nrecvd = recv(s.handle(), chunk, sizeof(chunk), 0);
+    if (nrecvd < 0) return 0;
+    if (nrecvd == 0) break;
+    response.append(chunk, (size_t)nrecvd);
+  }
+
+  const size_t header_end = response.find("\r\n\r\n");
+  if (header_end == std::string::npos ||
+      response.compare(0, 5, "HTTP/") != 0) {
+    return 0;
+  }
+  const size_t status_pos = response.find(' ');
+  if (status_pos == std::string::npos || status_pos > header_end) return 0;
+  const int status = atoi(response.c_str() + status_pos + 1u);
+
+  // Header field names are case-insensitive.
+  std::string header = response.substr(0, header_end + 2u);
+  for (char &c : header) c = (char)tolower((unsigned char)c);
+  const size_t transfer_encoding_pos = header.find("\r\ntransfer-encoding:");
+  if (transfer_encoding_pos != std::string::npos &&
+      header.find("chunked", transfer_encoding_pos) <
+          header.find("\r\n", transfer_encoding_pos + 2u)) {
+    return 0;
+  }
+  response_body = response.substr(header_end + 4u);
+  static const std::string content_length_field = "\r\ncontent-length:";
+  const size_t content_length_pos = header.find(content_length_field);
+  if (content_length_pos != std::string::npos) {
+    const unsigned long long content_length = strtoull(
+        header.c_str() + content_length_pos + content_length_field.size(),
+        nullptr, 10);
+    // A shorter body means the connection broke off early.
+    if (response_body.size() < content_length) return 0;
+    response_body.resize((size_t)content_length);
+  }
+  return status;
+}
+
+void wire_writer::write_field(uint32_t value) {
+  const uint32_t nbo = htonl(value);
+  data_.append((const char*)&nbo, sizeof(nbo));
+}
+
+void wire_writer::write_string(const std::string &s) {
+  write_bytes(s.data(), s.size());
+}
+
+void wire_writer::write_bytes(const void *bytes, size_t nbytes) {
+  write_field((uint32_t)nbytes);
+  data_.append((const char*)bytes, nbytes);
+}
+
+bool wire_reader::read_field(uint32_t &value) {
+  if (!ok_ || data_.size() - offset_ < sizeof(uint32_t)) {
+    ok_ = false;
+    return false;
+  }
+  uint32_t nbo;
+  memcpy(&nbo, data_.data() + offset_, sizeof(nbo));
+  value = ntohl(nbo);
+  offset_ += sizeof(uint32_t);
+  return true;
+}
+
+bool wire_reader::read_string(std::string &s) {
+  uint32_t size = 0u;
+  if (!read_field(size)) return false;
+  if (data_.size() - offset_ < size) {
+    ok_ = false;
+    return false;
+  }
+  s.assign(data_.data() + offset_, size);
+  offset_ += size;
+  return true;
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#if defined(_WIN32) || defined(_WIN64)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#undef max
+#undef min
+using socket_handle = SOCKET;
+#define NGF_INVALID_SOCKET INVALID_SOCKET
+#else
+using socket_handle = int;
+#define NGF_INVALID_SOCKET (-1)
+#endif
+
+#include <stdint.h>
+#include <string>
+
+// Largest frame accepted by `tcp_socket::recv_frame', so that a bogus length
+// read off the wire can't force a huge allocation.
+constexpr uint32_t MAX_FRAME_SIZE = 256u * 1024u * 1024u;
+
+// A blocking TCP socket.
+class tcp_socket {
+public:
+  tcp_socket() = default;
+  explicit tcp_socket(socket_handle h) : handle_(h) {}
+  tcp_socket(const tcp_socket&) = delete;
+  tcp_socket(tcp_socket &&other) noexcept { *this = std::move(other); }
+  ~tcp_socket() { close(); }
+  tcp_socket& operator=(const tcp_socket&) = delete;
+  tcp_socket& operator=(tcp_socket &&other) noexcept {
+    close();
+    handle_ = other.handle_;
+    other.handle_ = NGF_INVALID_SOCKET;
+    return *this;
+  }
+
+  // Connects to the given `host:port' address. Returns an invalid socket on
+  // failure. A nonzero `timeout_ms' is applied with `set_timeout' before
+  // connecting, which on Linux bounds the time spent connecting as well.
+  static tcp_socket connect_to(const std::string &host_port,
+                               uint32_t timeout_ms = 0u);
+
+  // Creates a socket listening on the given `host:port' address. Returns an
+  // invalid socket on failure.
+  static tcp_socket listen_on(const std::string &host_port);
+
+  // Waits for an incoming connection on a listening socket.
+  tcp_socket accept_connection() const;
+
+  // Sends or receives exactly `size' bytes. Return false if the connection
+  // was closed or an error occurred.
+  bool send_all(const void *data, size_t size) const;
+  bool recv_all(void *data, size_t size) const;
+
+  // Sends or receives a frame: a 32-bit length in network byte order,
+  // followed by that many bytes of payload. Frames larger than
+  // `MAX_FRAME_SIZE' are rejected, and the connection should be dropped.
+  bool send_frame(const std::string &payload) const;
+  bool recv_frame(std::string &payload) const;
+
+  // Makes sends and receives fail if they block for longer than the given
+  // time. Returns false if the timeout couldn't be set.
+  bool set_timeout(uint32_t timeout_ms) const;
+
+  bool is_valid() const { return handle_ != NGF_INVALID_SOCKET; }
+  socket_handle handle() const { return handle_; }
+  void close();
+
+private:
+  socket_handle handle_ = NGF_INVALID_SOCKET;
+};
+
+// Splits a `host:port' string. Returns false if the string is malformed.
+bool split_host_port(const std::string &host_port,
+                     std::string &host,
+                     std::string &port);
+
+// Performs a minimal HTTP/1.0 request (only plain `http://' URLs are
+// supported), giving up if the server doesn't respond within `timeout_ms'
+// milliseconds. Returns the response's status code, or 0 if the server could
+// not be reached, timed out, or sent a malformed response (including one
+// with a chunked body, or a body shorter than its Content-Length).
+int http_request(const char *method,
+                 const std::string &url,
+                 const std::string &request_body,
+                 uint32_t timeout_ms,
+                 std::string &response_body);
+
+// Accumulates fields and strings into a byte buffer that can be sent
+// over the wire. Fields are stored in network byte order.
+class wire_writer {
+public:
+  void write_field(uint32_t value);
+  void write_string(const std::string &s);
+  void write_bytes(const void *bytes, size_t nbytes);
+  const std::string& data() const { return data_; }
+
+private:
+  std::string data_;
+};
+
+// Reads fields and strings written by a `wire_writer'. Once a read runs past
+// the end of the buffer, all subsequent reads fail.
+class wire_reader {
+public:
+  explicit wire_reader(const std::string &data) : data_(data) {}
+  bool read_field(uint32_t &value);
+  bool read_string(std::string &s);
+  bool ok() const { return ok_; }
+
+private:
+  const std::string &data_;
+  size_t offset_ = 0u;
+  bool ok_ = true;
+};
@@ -22,33 +22,64 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 
+#include "artifact_cache.h"
+#include "build_error.h"
+#include "cbuffer_layout.h"
+#include "draw_parameters.h"
 #include "dxc_wrapper.h"
 #include "file_utils.h"
+#include "file_watcher.h"
+#include "fragment_properties.h"
+#include "hash_utils.h"
 #include "header_file_writer.h"
+#include "hot_reload.h"
+#include "output_sink.h"
+#include "perf_counters.h"
 #include "linear_dict.h"
+#include "mem_stats.h"
 #include "pipeline_layout.h"
 #include "pipeline_metadata_file.h"
 #include "separate_to_combined_map.h"
 #include "shader_defines.h"
+#include "shader_instrumentation.h"
+#include "subgroup_features.h"
 #include "target.h"
 #include "technique_parser.h"
+#include "thread_priority.h"
+#include "usage_profile.h"
 #include "spirv_reflect.hpp"
 #include "compilation.h"
+#include "compile_processes.h"
+#include "diagnostics.h"
+#include "remote_compile.h"
+#include "root_signature.h"
+#include "sampling_usage.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <ctype.h>
+#include <map>
 #include <memory>
+#include <set>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
 const char *USAGE = R"RAW(
-Usage: ngf_shaderc <input file name> [options] -- [dxc options]
+Usage: ngf_shaderc <input file name or -> [options] -- [dxc options]
+       ngf_shaderc --worker <host:port>
 
 A wrapper for Microsoft DirectX Shader Compiler and SPIRV-Cross that compiles
-HLSL shaders for multiple different targets.
+HLSL shaders for multiple different targets. If the input file name is `-`,
+the input is read from stdin, and included files are looked up relative to
+the current working directory.
 
 Options:
 
@@ -58,9 +89,11 @@ Options:
   -t <target> - Generate shaders for the given target.  Accepted values are:
       * gl430;
       * gles310, gles300;
-      * msl10, msl11, msl12, msl20;
-      * msl10ios, msl11ios, msl12ios, msl20ios;
-      * spv 
+      * msl10, msl11, msl12, msl20, msl21;
+      * msl10ios, msl11ios, msl12ios, msl20ios, msl21ios;
+      * spv;
+      * dxil (shaders must declare resources with explicit registers
+        and spaces matching their bindings and sets).
     If the option is encountered multiple times, shaders for all of the
     mentioned targets will be generated. At least one occurence of this option is
     required.
@@ -78,45 +111,1265 @@ Options:
   -D <name>=<value> - Add a preprocessor definition `name` with the value `value` to
      techniques.
 
+  --cache-dir <path> - Folder for storing build artifacts, which are reused
+     by subsequent builds with the same inputs.
+
+  --cache-url <url> - URL of a shared remote cache speaking a simple HTTP
+     GET/PUT protocol. Artifacts missing from the cache folder are fetched from
+     the remote cache, and newly built artifacts are uploaded to it.
+
+  -w <host:port> - Send compile jobs to a worker process listening on the
+     given address instead of invoking the DirectX Shader Compiler locally.
+     If the option is encountered multiple times, jobs are distributed among
+     all of the mentioned workers. Specifying the same address several times
+     opens several connections to the same worker.
+
+  --emit-stream - Instead of writing files to the output folder, write all
+     of them to stdout as a binary stream of frames. Each frame is a 32-bit
+     length followed by the file kind (1 - shader, 2 - pipeline metadata,
+     3 - header, 4 - alias written with --alias-outputs, whose contents are
+     the name of the file it duplicates, 5 - counter map written with
+     --instrument), the file name and the file contents. Fields are in
+     network byte order, and names and contents are prefixed with their
+     length. An empty frame marks the end of the output.
+
+  --alias-outputs - Write shaders that are identical for several targets of
+     the same API only once. The other files are created as hard links, and
+     are listed in the pipeline metadata as aliases.
+
+  --object-store - Write each unique shader only once, as
+     `objects/<hash>` in the output folder, instead of writing a file per
+     technique, stage and target. The pipeline metadata of each technique
+     lists the hashes of its shaders.
+
+  --cbuffer-report - Print the number of padding bytes in each uniform
+     buffer (cbuffer) of each technique, and how much smaller the buffers
+     would be if their members were reordered.
+
+  --sampling-report - Print how the shaders of each technique access each
+     texture, storage image and sampler: sampling with implicit or explicit
+     level of detail, gathers, fetches, queries and depth comparisons.
+
+  --pack-cbuffers - Reorder the members of uniform buffers to minimize
+     padding. The new offsets are listed in the pipeline metadata and in the
+     generated header; applications must use them when writing to the
+     buffers. Not supported for the dxil target.
+
+  --ios-base-vertex - Allow vertex shaders generated for the msl*ios targets
+     to read the base vertex and base instance draw parameters. Those require
+     Apple A9 or later GPUs.
+
+  --watch - Keep running after the build, and rebuild whenever the input
+     file or any of the files it includes changes. Only the techniques
+     affected by a change are recompiled, and output files whose contents
+     don't change are left untouched.
+
+  --publish <host:port> - In watch mode, listen on the given address and push
+     rebuilt techniques (generated files and pipeline metadata) to connected
+     applications.
+
+  --mem-stats <path> - Write the number of allocations, bytes allocated and
+     the peak live bytes for each build phase, along with the peak resident
+     set size of the process, to the given file as JSON.
+
+  --perf-counters - Collect hardware performance counters (cycles,
+     instructions, cache misses and branch misses) for each build phase and
+     each call into the DirectX Shader Compiler and SPIRV-Cross, and print
+     them per technique and in total. With -w or --processes, compilation
+     runs in other processes and only preprocessing is measured for the dxc
+     phase. Only supported on Linux; if the counters are unavailable, the
+     option is ignored.
+
+  --processes <count> - Run the DirectX Shader Compiler in the given number
+     of worker processes, started at startup, instead of in this process.
+     Jobs are compiled in parallel, and if the compiler crashes or hangs,
+     the worker process is restarted and the job retried once; if it fails
+     again, only the job at hand fails.
+     Results are passed back through shared memory. Not supported on
+     Windows.
+
+  --compile-timeout <milliseconds> - With --processes, the time after which
+     a compile job is abandoned and its worker process restarted. With -w,
+     the time after which an unresponsive worker is given up on. The
+     default is 60000.
+
+  --usage-profile <path> - Only build the techniques listed in the given
+     file, which holds the combinations of techniques and define values that
+     the application actually requested. Each line is a technique name,
+     optionally followed by `NAME=VALUE' define values that the technique
+     must have; `#' starts a comment. Techniques that aren't listed, and
+     listed combinations that don't match any technique, are reported.
+
+  --always-build <technique> - With --usage-profile, build the given
+     technique even if the profile doesn't list it. A name ending with `*'
+     matches all techniques starting with the part before it. May be
+     specified multiple times.
+
+  --check - Only check the input for errors, without generating code or
+     writing any files. Each unique combination of entry point and defines
+     is run through the front end of the DirectX Shader Compiler, and the
+     diagnostics are printed to stdout, one JSON object per line, with the
+     fields "file", "line", "column", "severity", "message", "technique" and
+     "entry_point". Targets aren't needed. Exits with a nonzero code if
+     there were errors.
+
+  --reflect-only - Only write the pipeline metadata and the header file,
+     skipping code generation. Entry points are still compiled to SPIR-V
+     for reflection. Targets are optional: they only affect the combined
+     image/sampler maps (OpenGL targets) and the root signature (dxil).
+     Binding fixups, which are only known after generating code, are left
+     out of the metadata.
+
+  --instrument - Generate instrumented shaders that count the invocations of
+     each entry point, the executions of each basic block and the iterations
+     of each loop, by atomically incrementing 32-bit counters in a storage
+     buffer. The buffer is added to the pipeline layout at binding 0 of the
+     first descriptor set that the technique doesn't use, and is described
+     in the pipeline metadata. For each technique, a
+     <technique>.counters.json file maps the counters to source locations.
+     Vertex shaders for Metal targets are left uninstrumented. Not supported
+     for the dxil and gles300 targets.
+
+  --tiered - Build in two tiers: all techniques are first compiled without
+     optimizations (-O0) and their outputs written right away, then compiled
+     again with optimizations at a lower thread priority, atomically replacing
+     the unoptimized outputs. The pipeline metadata records which tier each
+     output came from. Unoptimized shaders may use resources that the
+     optimized ones don't, so the pipeline layout can change between the
+     tiers; techniques for which this happens are reported. In watch mode,
+     the optimized build runs in the background, and is abandoned if the
+     input changes before it finishes.
+
+  --worker <host:port> - Run as a worker: listen on the given address and
+     compile jobs received from other instances of the tool.
+
    Everything following the double dash (`--`) is passed as-is to the
    Microsoft DirectX Shader Compiler.
 
 )RAW";
 
+namespace {
+
+// Input file name meaning stdin.
+const char STDIN_INPUT[] = "-";
+
+// Time after which a compile job running in a worker process or on a remote
+// worker is abandoned, unless specified otherwise.
+constexpr uint32_t DEFAULT_COMPILE_TIMEOUT_MS = 60000u;
+
+// Build settings obtained from the command line.
+struct build_options {
+  std::string input_file_path;
+  std::string source_name; // Name of the input for diagnostics.
+  std::string out_folder = ".";
+  std::string header_path = "";
+  std::string header_namespace = "";
+  std::string shader_model = "6_2";
+  std::vector<const target_info*> targets;
+  bool dxil_target = false; // The dxil target is among the targets.
+  std::vector<std::string> worker_addresses;
+  uint32_t compile_timeout_ms = DEFAULT_COMPILE_TIMEOUT_MS;
+  define_container global_macro_definitions;
+  std::vector<std::string> dxc_options;
+  std::vector<std::string> dxil_dxc_options; // Options for the dxil target.
+  bool alias_outputs = false;
+  bool object_store = false;
+  bool pack_cbuffers = false;
+  bool cbuffer_report = false;
+  bool sampling_report = false;
+  bool ios_base_vertex = false;
+  bool reflect_only = false; // Only write metadata and the header.
+  bool instrument = false; // Add execution counters to the shaders.
+  usage_profile profile;
+  // Tier recorded in the pipeline metadata (NGF_PLMD_COMPILE_TIER_*).
+  uint32_t compile_tier = NGF_PLMD_COMPILE_TIER_FINAL;
+  // In tiered builds, the pipeline metadata of each technique from the
+  // unoptimized build, with the compile tier left out, keyed by technique
+  // name. The optimized build reports the techniques whose metadata differs.
+  std::map<std::string, std::string> *unoptimized_metadata = nullptr;
+  // If set, the build is abandoned as soon as possible after the flag is
+  // raised.
+  const std::atomic<bool> *cancel = nullptr;
+  // If set, local compile jobs are run in these worker processes.
+  compile_process_pool *process_pool = nullptr;
+};
+
+// Binding of the storage buffer that holds the counters of instrumented
+// shaders, within the first descriptor set that the technique doesn't use.
+constexpr uint32_t INSTRUMENTATION_BINDING = 0u;
+
+// Name of the macro that holds the root signature when compiling to DXIL.
+const char ROOT_SIGNATURE_DEFINE[] = "NGF_ROOT_SIGNATURE";
+
+// Returns the number of separate values that follow the given SPIR-V specific
+// DXC option on the command line. Options with joined values (such as
+// -fspv-target-env=vulkan1.1) and flags have none.
+size_t spirv_option_value_count(const std::string &option) {
+  if (option == "-fvk-b-shift" || option == "-fvk-t-shift" ||
+      option == "-fvk-s-shift" || option == "-fvk-u-shift" ||
+      option == "-fvk-bind-globals") {
+    return 2u; // Shift or binding, and space or set.
+  }
+  if (option == "-fvk-bind-register") {
+    return 4u; // Register, space, binding and set.
+  }
+  return 0u;
+}
+
+// Abandons the build if it has been cancelled.
+void check_cancelled(const build_options &opts) {
+  if (opts.cancel != nullptr && opts.cancel->load()) abort_build();
+}
+
+// Offset of the total size field within a DXIL container header.
+constexpr size_t DXIL_CONTAINER_SIZE_OFFSET = 24u;
+
+// Folder within the output folder that holds the object store.
+const char OBJECT_STORE_FOLDER[] = "objects";
+
+// Adds the files mentioned by `#line' directives in the preprocessed source
+// (i.e. the input file and everything it includes) to `files'.
+void collect_source_files(const std::string &preprocessed_source,
+                          std::set<std::string> &files) {
+  static const char LINE_DIRECTIVE[] = "#line ";
+  for (size_t pos = preprocessed_source.find(LINE_DIRECTIVE);
+       pos != std::string::npos;
+       pos = preprocessed_source.find(LINE_DIRECTIVE, pos + 1u)) {
+    if (pos > 0u && preprocessed_source[pos - 1u] != '\n') continue;
+    const size_t eol = preprocessed_source.find('\n', pos);
+    const size_t name_start = preprocessed_source.find('"', pos);
+    if (name_start >= eol) continue;
+    const size_t name_end = preprocessed_source.find('"', name_start + 1u);
+    if (name_end >= eol) continue;
+    files.insert(preprocessed_source.substr(name_start + 1u,
+                                            name_end - name_start - 1u));
+  }
+}
+
+// Padding found in a uniform buffer declared by a technique.
+struct cbuffer_report_entry {
+  std::string technique_name;
+  cbuffer_layout declared_layout;
+  uint32_t packed_size;
+};
+
+// Prints the padding of each uniform buffer, and the totals.
+void print_cbuffer_report(FILE *f,
+                          const std::vector<cbuffer_report_entry> &entries,
+                          bool packed) {
+  int technique_width = (int)sizeof("technique") - 1;
+  int buffer_width = (int)sizeof("buffer") - 1;
+  for (const cbuffer_report_entry &e : entries) {
+    technique_width = std::max(technique_width, (int)e.technique_name.size());
+    buffer_width = std::max(buffer_width, (int)e.declared_layout.name.size());
+  }
+  fprintf(f, "Uniform buffer padding:\n");
+  fprintf(f, "  %-*s %-*s %8s %8s %12s\n", technique_width, "technique",
+          buffer_width, "buffer", "size", "padding", "packed size");
+  uint64_t total_padding = 0u, total_savings = 0u;
+  for (const cbuffer_report_entry &e : entries) {
+    const cbuffer_layout &l = e.declared_layout;
+    fprintf(f, "  %-*s %-*s %8u %8u %12u\n", technique_width,
+            e.technique_name.c_str(), buffer_width, l.name.c_str(), l.size,
+            l.padding(), e.packed_size);
+    total_padding += l.padding();
+    total_savings += l.size - e.packed_size;
+  }
+  fprintf(f, "%llu bytes of padding in %zu uniform buffers, %llu bytes %s "
+             "by packing\n",
+          (unsigned long long)total_padding, entries.size(),
+          (unsigned long long)total_savings,
+          packed ? "removed" : "can be removed");
+}
+
+// A texture, storage image or sampler, and the ways in which a technique
+// accesses it.
+struct sampling_report_entry {
+  std::string technique_name;
+  std::string descriptor_name;
+  uint32_t stage_mask;
+  uint32_t usage;
+};
+
+void print_sampling_report(FILE *f,
+                           const std::vector<sampling_report_entry> &entries) {
+  int technique_width = (int)sizeof("technique") - 1;
+  int descriptor_width = (int)sizeof("descriptor") - 1;
+  for (const sampling_report_entry &e : entries) {
+    technique_width = std::max(technique_width, (int)e.technique_name.size());
+    descriptor_width =
+        std::max(descriptor_width, (int)e.descriptor_name.size());
+  }
+  fprintf(f, "Sampling usage:\n");
+  fprintf(f, "  %-*s %-*s %-6s %s\n", technique_width, "technique",
+          descriptor_width, "descriptor", "stages", "usage");
+  for (const sampling_report_entry &e : entries) {
+    const char *stages =
+        e.stage_mask == (STAGE_MASK_VERTEX | STAGE_MASK_FRAGMENT)
+            ? "vs, ps"
+            : e.stage_mask == STAGE_MASK_VERTEX ? "vs" : "ps";
+    fprintf(f, "  %-*s %-*s %-6s %s\n", technique_width,
+            e.technique_name.c_str(), descriptor_width,
+            e.descriptor_name.c_str(), stages,
+            e.usage != 0u ? sampling_usage_names(e.usage).c_str() : "-");
+  }
+}
+
+// Compiles the entry point of the given kind to DXIL, with the root signature
+// embedded into it. Like SPIR-V, DXIL is looked up in the cache first and, if
+// workers are available, produced remotely.
+std::string compile_dxil(const build_options &opts,
+                         const std::string &input_source,
+                         const std::string &preprocessed_source,
+                         const technique &tech,
+                         shader_kind kind,
+                         const root_signature &root_sig,
+                         dxc_wrapper &dxil_compiler,
+                         artifact_cache &cache) {
+  const auto ep = std::find_if(tech.entry_points.begin(),
+                               tech.entry_points.end(),
+                               [kind](const technique::entry_point &e) {
+                                 return e.kind == kind;
+                               });
+  define_container defines = tech.defines;
+  defines.emplace_back(ROOT_SIGNATURE_DEFINE, "\"" + root_sig.hlsl() + "\"");
+  const compile_job job {
+    opts.source_name,
+    preprocessed_source,
+    technique::entry_point { kind, ep->name, {} },
+    defines,
+    opts.shader_model,
+    opts.dxil_dxc_options
+  };
+  std::string dxil;
+  const std::string cache_key =
+      cache.enabled() ? job.cache_key() : std::string();
+  if (cache.enabled() && cache.get(cache_key, dxil)) return dxil;
+
+  set_build_phase(build_phase::dxc);
+  dxc_wrapper::result result;
+  if (!opts.worker_addresses.empty()) {
+    result = std::move(compile_remotely({ job }, opts.worker_addresses,
+                                        opts.compile_timeout_ms,
+                                        dxil_compiler)[0]);
+  } else if (opts.process_pool != nullptr) {
+    check_cancelled(opts);
+    result = std::move(opts.process_pool->compile({ job })[0]);
+  } else {
+    check_cancelled(opts);
+    perf_scope compile_perf_scope(tech.name, build_phase::dxc);
+    result = dxil_compiler.compile_hlsl2spv(input_source.c_str(),
+                                            input_source.size(),
+                                            opts.source_name.c_str(),
+                                            job.entry_point,
+                                            job.defines);
+  }
+  if (result.HasDiagMessage()) {
+    fprintf(stderr, "%s", result.diag_message.c_str());
+  }
+  if (!result.HasData()) {
+    if (result.diag_message.find("Root Signature") != std::string::npos) {
+      fprintf(stderr, "The root signature of technique %s uses registers "
+                      "equal to the descriptor bindings; declare its "
+                      "resources with matching register() annotations\n",
+              tech.name.c_str());
+    }
+    abort_build();
+  }
+  // Drop the padding added by the wrapper, the container header has the
+  // actual size.
+  dxil.assign((const char*)result.spirv_code.data(),
+              result.spirv_code.size() * sizeof(uint32_t));
+  uint32_t container_size = 0u;
+  if (dxil.size() >= DXIL_CONTAINER_SIZE_OFFSET + sizeof(uint32_t)) {
+    memcpy(&container_size, &dxil[DXIL_CONTAINER_SIZE_OFFSET],
+           sizeof(uint32_t));
+  }
+  if (container_size > dxil.size() || dxil.compare(0, 4, "DXBC") != 0) {
+    fprintf(stderr, "DXC produced a malformed DXIL container for %s\n",
+            job.entry_point.name.c_str());
+    abort_build();
+  }
+  dxil.resize(container_size);
+  if (cache.enabled()) cache.put(cache_key, dxil);
+  return dxil;
+}
+
+// Reads the input file (or stdin), adding it to `source_files'.
+std::string load_input(const build_options &opts,
+                       std::set<std::string> &source_files) {
+  std::string input_source;
+  if (opts.input_file_path == STDIN_INPUT) {
+    if (!try_read_stdin(input_source)) {
+      fprintf(stderr, "Failed to read from stdin\n");
+      abort_build();
+    }
+  } else {
+    source_files.insert(opts.input_file_path);
+    if (!try_read_file(opts.input_file_path.c_str(), input_source)) {
+      fprintf(stderr, "Failed to open file %s\n",
+              opts.input_file_path.c_str());
+      abort_build();
+    }
+  }
+  input_source.push_back('\n');
+  return input_source;
+}
+
+// Builds all the outputs for the input file, aborting the build on errors.
+// Adds the source files that the outputs depend on to `source_files'. If the
+// build succeeds, techniques are published to `publisher' (if not null).
+// `dxil_compiler' is only needed if the dxil target is requested.
+// Returns the number of output files that were written.
+uint32_t build(const build_options &opts,
+               dxc_wrapper &dxcompiler,
+               dxc_wrapper *dxil_compiler,
+               artifact_cache &cache,
+               output_sink &sink,
+               hot_reload_publisher *publisher,
+               std::set<std::string> &source_files) {
+#pragma region load_input
+  set_build_phase(build_phase::parse);
+  const std::string all_techniques;
+  perf_scope parse_perf_scope(all_techniques, build_phase::parse);
+
+  // Load the input file.
+  const std::string input_source = load_input(opts, source_files);
+
+  // Look for and parse technique directives in the code.
+  std::vector<technique> techniques;
+  parse_techniques(input_source, techniques, opts.global_macro_definitions);
+  if (techniques.size() == 0u) {
+    fprintf(stderr, "Input file does not appear to define any techniques. "
+                    "Define techniques with a special comment (`//T:').\n");
+    abort_build();
+  }
+  usage_pruning_result pruning;
+  if (opts.profile.enabled()) {
+    pruning = prune_techniques(opts.profile, techniques);
+  }
+  parse_perf_scope.finish();
+#pragma endregion load_input
+
+#pragma region gen_spv
+  set_build_phase(build_phase::dxc);
+
+  // Obtain SPIR-V.
+
+  // Create a compile job for each entry point. If the jobs are to be looked
+  // up in the cache or shipped to workers (remote ones or local processes),
+  // includes are resolved up-front, so that the jobs are self-contained.
+  const bool need_preprocessing =
+      cache.enabled() || !opts.worker_addresses.empty() ||
+      opts.process_pool != nullptr;
+  std::vector<compile_job> jobs;
+  std::vector<technique::entry_point*> job_entry_points;
+  std::vector<const technique*> job_techniques;
+  std::vector<std::string> job_cache_keys;
+  std::vector<std::string> preprocessed_sources;
+  preprocessed_sources.reserve(techniques.size());
+  for (technique &tech : techniques) {
+    preprocessed_sources.emplace_back();
+    std::string &preprocessed_source = preprocessed_sources.back();
+    if (need_preprocessing) {
+      dxc_wrapper::preprocess_result pp;
+      {
+        perf_scope pp_perf_scope(tech.name, build_phase::dxc);
+        pp = dxcompiler.preprocess_hlsl(input_source.c_str(),
+                                        input_source.size(),
+                                        opts.source_name.c_str(),
+                                        tech.defines);
+      }
+      if (pp.HasDiagMessage()) {
+        fprintf(stderr, "%s", pp.diag_message.c_str());
+      }
+      if (!pp.HasData()) {
+        abort_build();
+      }
+      preprocessed_source = std::move(pp.source);
+      collect_source_files(preprocessed_source, source_files);
+    }
+    for (technique::entry_point &ep : tech.entry_points) {
+      compile_job job {
+        opts.source_name,
+        preprocessed_source,
+        technique::entry_point { ep.kind, ep.name, {} },
+        tech.defines,
+        opts.shader_model,
+        opts.dxc_options
+      };
+      std::string cache_key;
+      if (cache.enabled()) {
+        cache_key = job.cache_key();
+        std::string cached_spirv;
+        // A blob that isn't made of whole words is corrupt, and is rebuilt
+        // (and replaced in the cache) like a miss.
+        if (cache.get(cache_key, cached_spirv) && !cached_spirv.empty() &&
+            cached_spirv.size() % sizeof(uint32_t) == 0u) {
+          ep.spirv_code.resize(cached_spirv.size() / sizeof(uint32_t));
+          memcpy(ep.spirv_code.data(), cached_spirv.data(),
+                 ep.spirv_code.size() * sizeof(uint32_t));
+          continue;
+        }
+      }
+      jobs.emplace_back(std::move(job));
+      job_entry_points.push_back(&ep);
+      job_techniques.push_back(&tech);
+      job_cache_keys.emplace_back(std::move(cache_key));
+    }
+  }
+
+  // Produce SPIR-V for the jobs that weren't found in the cache.
+  std::vector<dxc_wrapper::result> results;
+  if (!opts.worker_addresses.empty() && !jobs.empty()) {
+    results = compile_remotely(jobs, opts.worker_addresses,
+                               opts.compile_timeout_ms, dxcompiler);
+  } else if (opts.process_pool != nullptr) {
+    check_cancelled(opts);
+    results = opts.process_pool->compile(jobs);
+  } else {
+    for (size_t job_idx = 0u; job_idx < jobs.size(); ++job_idx) {
+      const compile_job &job = jobs[job_idx];
+      check_cancelled(opts);
+      perf_scope compile_perf_scope(job_techniques[job_idx]->name,
+                                    build_phase::dxc);
+      results.emplace_back(dxcompiler.compile_hlsl2spv(
+          input_source.c_str(),
+          input_source.size(),
+          opts.source_name.c_str(),
+          job.entry_point,
+          job.defines));
+    }
+  }
+  for (size_t job_idx = 0u; job_idx < jobs.size(); ++job_idx) {
+    dxc_wrapper::result &result = results[job_idx];
+    if (result.HasDiagMessage()) {
+      fprintf(stderr, "%s", result.diag_message.c_str());
+    }
+    if (!result.HasData()) {
+      abort_build();
+    }
+    if (cache.enabled()) {
+      cache.put(job_cache_keys[job_idx],
+                std::string((const char*)result.spirv_code.data(),
+                            result.spirv_code.size() * sizeof(uint32_t)));
+    }
+    job_entry_points[job_idx]->spirv_code = std::move(result.spirv_code);
+  }
+#pragma endregion gen_spv
+
+ #pragma region gen_output
+  // Generate output. In watch and tiered mode, files that are already up to
+  // date are left untouched, so that tools watching them don't reload
+  // needlessly.
+  uint32_t files_written = 0u;
+  uint32_t aliased_files = 0u;
+  uint64_t aliased_bytes = 0u;
+  std::set<std::string> written_objects;
+  std::vector<std::vector<published_file>> published_files(techniques.size());
+  std::vector<std::string> published_metadata(techniques.size());
+  std::vector<cbuffer_report_entry> cbuffer_report;
+  std::vector<sampling_report_entry> sampling_report;
+  header_file_writer header_writer(opts.header_namespace);
+
+  for (size_t tech_idx = 0u; tech_idx < techniques.size(); ++tech_idx) {
+    technique &tech = techniques[tech_idx];
+    check_cancelled(opts);
+    pipeline_layout res_layout;
+    separate_to_combined_map images_to_cis, samplers_to_cis;
+    std::vector<compilation> compilations;
+    set_build_phase(build_phase::reflection);
+    perf_scope reflection_perf_scope(tech.name, build_phase::reflection);
+
+    // Reflect the layouts of the technique's uniform buffers, and pack them if
+    // requested. Each buffer is packed once, and the result is applied to
+    // every stage that declares it, so that all stages agree on the layout.
+    std::map<std::pair<uint32_t, uint32_t>, cbuffer_layout> cbuffer_layouts;
+    std::map<std::pair<uint32_t, uint32_t>, cbuffer_layout>
+        declared_cbuffer_layouts;
+    for (technique::entry_point &ep : tech.entry_points) {
+      for (const cbuffer_layout &declared :
+           reflect_cbuffer_layouts(ep.spirv_code)) {
+        const auto key = std::make_pair(declared.set, declared.binding);
+        auto it = cbuffer_layouts.find(key);
+        if (it == cbuffer_layouts.end()) {
+          const cbuffer_layout packed = pack_cbuffer_layout(declared);
+          if (opts.cbuffer_report) {
+            cbuffer_report.push_back(
+                cbuffer_report_entry { tech.name, declared, packed.size });
+          }
+          declared_cbuffer_layouts.emplace(key, declared);
+          it = cbuffer_layouts.emplace(
+              key, opts.pack_cbuffers ? packed : declared).first;
+        } else if (opts.pack_cbuffers &&
+                   !declared.same_as(declared_cbuffer_layouts[key])) {
+          fprintf(stderr, "Can't pack cbuffer %s in technique %s, because it "
+                          "is declared differently by different stages\n",
+                  declared.name.c_str(), tech.name.c_str());
+          abort_build();
+        }
+        if (!opts.pack_cbuffers || it->second.same_as(declared)) continue;
+        cbuffer_layout stage_layout = it->second;
+        stage_layout.type_id = declared.type_id;
+        if (!apply_cbuffer_layout(ep.spirv_code, stage_layout)) {
+          fprintf(stderr, "Failed to pack cbuffer %s in technique %s\n",
+                  declared.name.c_str(), tech.name.c_str());
+          abort_build();
+        }
+      }
+    }
+
+    // Find out which subgroup operations the technique uses, and make sure
+    // they can be expressed for all of the targets.
+    uint32_t subgroup_features = 0u, subgroup_stage_mask = 0u;
+    for (const technique::entry_point &ep : tech.entry_points) {
+      const uint32_t features = required_subgroup_features(ep.spirv_code);
+      if (features == 0u) continue;
+      subgroup_features |= features;
+      subgroup_stage_mask |= ep.kind == shader_kind::vertex
+                                 ? STAGE_MASK_VERTEX
+                                 : STAGE_MASK_FRAGMENT;
+    }
+    for (const target_info *target : opts.targets) {
+      const uint32_t unsupported =
+          subgroup_features & ~supported_subgroup_features(*target);
+      if (unsupported != 0u) {
+        fprintf(stderr, "Technique %s uses subgroup operations (%s) that "
+                        "can't be expressed for target %s\n",
+                tech.name.c_str(), subgroup_feature_names(unsupported).c_str(),
+                target_name(target));
+        abort_build();
+      }
+    }
+
+    // Same for the draw parameters read by the vertex shader.
+    uint32_t draw_parameters = 0u;
+    for (const technique::entry_point &ep : tech.entry_points) {
+      if (ep.kind != shader_kind::vertex) continue;
+      draw_parameters |= used_draw_parameters(ep.spirv_code);
+    }
+    for (const target_info *target : opts.targets) {
+      const uint32_t unsupported =
+          draw_parameters &
+          ~supported_draw_parameters(*target, opts.ios_base_vertex);
+      if (unsupported != 0u) {
+        fprintf(stderr, "Technique %s uses draw parameters (%s) that "
+                        "aren't available for target %s\n",
+                tech.name.c_str(), draw_parameter_names(unsupported).c_str(),
+                target_name(target));
+        abort_build();
+      }
+    }
+
+    // Instrument the entry points if requested. All stages share the
+    // storage buffer that holds the counters. SPIRV-Cross turns Metal vertex
+    // functions that write to buffers into ones that don't rasterize, so
+    // vertex shaders for Metal are generated from the original code, and
+    // their counters stay at zero.
+    std::vector<instrumentation_counter> counters;
+    uint32_t instrumentation_set = 0u;
+    std::vector<std::vector<uint32_t>> uninstrumented_code(
+        tech.entry_points.size());
+    if (opts.instrument) {
+      for (const technique::entry_point &ep : tech.entry_points) {
+        instrumentation_set = std::max(instrumentation_set,
+                                       descriptor_set_count(ep.spirv_code));
+      }
+      for (size_t ep_idx = 0u; ep_idx < tech.entry_points.size(); ++ep_idx) {
+        technique::entry_point &ep = tech.entry_points[ep_idx];
+        if (ep.kind == shader_kind::vertex) {
+          uninstrumented_code[ep_idx] = ep.spirv_code;
+        }
+        if (!instrument_spirv(ep.spirv_code, instrumentation_set,
+                              INSTRUMENTATION_BINDING, counters)) {
+          fprintf(stderr, "Failed to instrument entry point %s of technique "
+                          "%s\n", ep.name.c_str(), tech.name.c_str());
+          abort_build();
+        }
+      }
+    }
+
+    for (size_t ep_idx = 0u; ep_idx < tech.entry_points.size(); ++ep_idx) {
+      const technique::entry_point& ep = tech.entry_points[ep_idx];
+      for (const target_info* target_info : opts.targets) {
+        const bool uninstrumented = opts.instrument &&
+                                    ep.kind == shader_kind::vertex &&
+                                    target_info->api == target_api::METAL;
+        const std::vector<uint32_t>& spv_code =
+            uninstrumented ? uninstrumented_code[ep_idx] : ep.spirv_code;
+        compilations.emplace_back(ep.kind, spv_code, *target_info,
+                                  opts.ios_base_vertex);
+        compilations.back().add_cis_to_map(images_to_cis, samplers_to_cis);
+        compilations.back().add_resources_to_pipeline_layout(res_layout);
+      }
+    }
+
+    res_layout.remap_resources();
+
+    // Only the uniform buffers that are part of the pipeline layout are
+    // described in the outputs.
+    std::vector<const cbuffer_layout*> used_cbuffer_layouts;
+    for (uint32_t set = 0u; set < res_layout.set_count(); ++set) {
+      for (const auto &d : res_layout.set(set)) {
+        auto it = cbuffer_layouts.find(std::make_pair(set, d.second.slot));
+        if (d.second.type == descriptor_type::UNIFORM_BUFFER &&
+            it != cbuffer_layouts.end()) {
+          used_cbuffer_layouts.push_back(&it->second);
+        }
+      }
+    }
+    const root_signature root_sig(res_layout);
+    reflection_perf_scope.finish();
+
+    // DXIL is compiled before any of the technique's shaders are written, so
+    // that an entry point failing to compile (for example because its
+    // registers don't match the root signature) leaves no partial outputs.
+    std::map<shader_kind, std::string> dxil_outputs;
+    for (const compilation &c : compilations) {
+      if (opts.reflect_only) break;
+      if (c.target().api == target_api::D3D12) {
+        dxil_outputs[c.kind()] =
+            compile_dxil(opts, input_source, preprocessed_sources[tech_idx],
+                         tech, c.kind(), root_sig, *dxil_compiler, cache);
+      }
+    }
+
+    // Maps generated code to the first file it was written to, for each API.
+    std::map<std::pair<target_api, std::string>, std::string> written_outputs;
+    std::vector<std::pair<std::string, std::string>> aliases;
+
+    // Stage, name and hash of each shader in the object store.
+    struct object_ref { shader_kind stage; std::string name, hash; };
+    std::vector<object_ref> objects;
+
+    for (compilation &c : compilations) {
+      // In reflect-only mode, stop before generating any code.
+      if (opts.reflect_only) break;
+      const std::string out_file_name = c.output_file_path(tech.name);
+      std::string output;
+      if (c.target().api == target_api::D3D12) {
+        output = std::move(dxil_outputs[c.kind()]);
+      } else {
+        const std::string cache_key =
+            cache.enabled() ? c.cache_key(res_layout) : std::string();
+        const std::string fixups_cache_key =
+            cache.enabled() && c.needs_binding_fixups()
+                ? c.binding_fixups_cache_key(res_layout)
+                : std::string();
+        std::string fixups;
+        if (!cache.enabled() || !cache.get(cache_key, output) ||
+            (!fixups_cache_key.empty() &&
+             !cache.get(fixups_cache_key, fixups))) {
+          set_build_phase(build_phase::cross_compile);
+          perf_scope generate_perf_scope(tech.name,
+                                         build_phase::cross_compile);
+          output = c.generate(res_layout);
+          generate_perf_scope.finish();
+          if (cache.enabled()) cache.put(cache_key, output);
+          if (!fixups_cache_key.empty()) {
+            cache.put(fixups_cache_key, c.save_binding_fixups());
+          }
+        } else if (!fixups_cache_key.empty()) {
+          c.load_binding_fixups(fixups);
+        }
+      }
+      set_build_phase(build_phase::write);
+      perf_scope write_perf_scope(tech.name, build_phase::write);
+      bool is_alias = false;
+      if (opts.object_store) {
+        const std::string hash = sha256_hex(output.data(), output.size());
+        if (written_objects.insert(hash).second &&
+            sink.write(output_kind::shader,
+                       std::string(OBJECT_STORE_FOLDER) + "/" + hash,
+                       output)) {
+          ++files_written;
+        }
+        objects.push_back(object_ref { c.kind(), out_file_name, hash });
+      } else if (opts.alias_outputs) {
+        auto it = written_outputs.emplace(
+            std::make_pair(c.target().api, output), out_file_name).first;
+        if (it->second != out_file_name) {
+          is_alias = true;
+          aliases.emplace_back(out_file_name, it->second);
+          ++aliased_files;
+          aliased_bytes += output.size();
+          if (sink.write_alias(out_file_name, it->second, output)) {
+            ++files_written;
+          }
+        }
+      }
+      if (!is_alias && !opts.object_store &&
+          sink.write(output_kind::shader, out_file_name, output)) {
+        ++files_written;
+      }
+      if (publisher) {
+        published_files[tech_idx].push_back(
+            published_file { out_file_name, std::move(output) });
+      }
+    }
+
+    // Write out the .pipeline file for the current technique.
+    set_build_phase(build_phase::write);
+    perf_scope write_perf_scope(tech.name, build_phase::write);
+    pipeline_metadata_file metadata_file;
+    header_writer.begin_technique(tech.name);
+
+    // Write out the entrypoints section.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)tech.entry_points.size());
+    for (const technique::entry_point& ep : tech.entry_points) {
+      metadata_file.write_field((uint32_t)ep.kind);
+      metadata_file.write_raw_bytes(ep.name.c_str(),
+        ep.name.length() + 1u);
+    }
+
+    // Write out the pipeline layout record.
+    metadata_file.start_new_record();
+    metadata_file.write_field(res_layout.set_count());
+    for (uint32_t set = 0u; set < res_layout.set_count(); ++set) {
+      const descriptor_set_layout& ds = res_layout.set(set);
+      metadata_file.write_field((uint32_t)ds.size());
+      for (const auto& d : ds) {
+        metadata_file.write_field(d.second.slot);
+        metadata_file.write_field((uint32_t)d.second.type);
+        metadata_file.write_field(d.second.stage_mask);
+        header_writer.write_descriptor(d.second, set);
+      }
+    }
+    for (const cbuffer_layout *l : used_cbuffer_layouts) {
+      header_writer.write_cbuffer_layout(*l);
+    }
+    uint32_t fragment_props = 0u;
+    for (const technique::entry_point &ep : tech.entry_points) {
+      if (ep.kind == shader_kind::fragment) {
+        fragment_props = fragment_properties(ep.spirv_code);
+      }
+    }
+    header_writer.write_fragment_properties(fragment_props);
+    header_writer.end_technique();
+
+    // Write out separate-to-combined map records.
+    metadata_file.start_new_record();
+    images_to_cis.serialize(metadata_file);
+    metadata_file.start_new_record();
+    samplers_to_cis.serialize(metadata_file);
+
+    // Write out user metadata record.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)tech.additional_metadata.size());
+    for (const auto& nameval : tech.additional_metadata) {
+      metadata_file.write_raw_bytes(nameval.first.c_str(),
+        nameval.first.size() + 1u);
+      metadata_file.write_raw_bytes(nameval.second.c_str(),
+        nameval.second.size() + 1u);
+    }
+
+    // Write out the aliases record.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)aliases.size());
+    for (const auto &alias : aliases) {
+      metadata_file.write_raw_bytes(alias.first.c_str(),
+                                    alias.first.size() + 1u);
+      metadata_file.write_raw_bytes(alias.second.c_str(),
+                                    alias.second.size() + 1u);
+    }
+
+    // Write out the object store references record.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)objects.size());
+    for (const object_ref &object : objects) {
+      metadata_file.write_field((uint32_t)object.stage);
+      metadata_file.write_raw_bytes(object.name.c_str(),
+                                    object.name.size() + 1u);
+      metadata_file.write_raw_bytes(object.hash.c_str(),
+                                    object.hash.size() + 1u);
+    }
+
+    // Write out the uniform buffer layouts record.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)used_cbuffer_layouts.size());
+    for (const cbuffer_layout *l : used_cbuffer_layouts) {
+      metadata_file.write_field(l->set);
+      metadata_file.write_field(l->binding);
+      metadata_file.write_field(l->size);
+      metadata_file.write_raw_bytes(l->name.c_str(), l->name.size() + 1u);
+      metadata_file.write_field((uint32_t)l->members.size());
+      for (const cbuffer_member &m : l->members) {
+        metadata_file.write_field(m.offset);
+        metadata_file.write_field(m.size);
+        metadata_file.write_raw_bytes(m.name.c_str(), m.name.size() + 1u);
+      }
+    }
+
+    // Write out the root signature record.
+    metadata_file.start_new_record();
+    if (!opts.dxil_target) {
+      metadata_file.write_field(0u);
+    } else {
+      metadata_file.write_field((uint32_t)root_sig.tables().size());
+      for (const root_table &table : root_sig.tables()) {
+        metadata_file.write_field(table.register_space);
+        metadata_file.write_field(table.samplers ? 1u : 0u);
+        metadata_file.write_field((uint32_t)table.ranges.size());
+        for (const root_range &range : table.ranges) {
+          metadata_file.write_field((uint32_t)range.type);
+          metadata_file.write_field(range.shader_register);
+        }
+      }
+    }
+
+    // Write out the subgroup features record.
+    metadata_file.start_new_record();
+    metadata_file.write_field(subgroup_features);
+    metadata_file.write_field(subgroup_stage_mask);
+
+    // Write out the draw parameters record.
+    metadata_file.start_new_record();
+    metadata_file.write_field(draw_parameters);
+
+    // Write out the binding fixups record. Both stages of a program share
+    // the names of their uniform blocks and samplers, so each name is listed
+    // only once.
+    std::vector<binding_fixup> binding_fixups;
+    for (const compilation &c : compilations) {
+      for (const binding_fixup &f : c.binding_fixups()) {
+        const bool seen = std::any_of(
+            binding_fixups.begin(), binding_fixups.end(),
+            [&f](const binding_fixup &other) {
+              return other.type == f.type && other.name == f.name;
+            });
+        if (!seen) binding_fixups.push_back(f);
+      }
+    }
+    std::stable_sort(binding_fixups.begin(), binding_fixups.end(),
+                     [](const binding_fixup &lhs, const binding_fixup &rhs) {
+                       return lhs.type != rhs.type
+                                  ? lhs.type < rhs.type
+                                  : lhs.native_binding < rhs.native_binding;
+                     });
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)binding_fixups.size());
+    for (const binding_fixup &f : binding_fixups) {
+      metadata_file.write_field((uint32_t)f.type);
+      metadata_file.write_field(f.native_binding);
+      metadata_file.write_raw_bytes(f.name.c_str(), f.name.size() + 1u);
+    }
+
+    // Write out the fragment properties record.
+    metadata_file.start_new_record();
+    metadata_file.write_field(fragment_props);
+
+    // Write out the sampling usage record.
+    sampling_usage_map sampling_usage;
+    for (const technique::entry_point &ep : tech.entry_points) {
+      add_sampling_usage(ep.spirv_code, sampling_usage);
+    }
+    std::vector<std::pair<uint32_t, const descriptor*>> sampled_descriptors;
+    for (uint32_t set = 0u; set < res_layout.set_count(); ++set) {
+      for (const auto &d : res_layout.set(set)) {
+        if (d.second.type == descriptor_type::TEXTURE ||
+            d.second.type == descriptor_type::SAMPLER ||
+            d.second.type == descriptor_type::LOADSTORE_IMAGE) {
+          sampled_descriptors.emplace_back(set, &d.second);
+        }
+      }
+    }
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)sampled_descriptors.size());
+    for (const auto &set_and_descriptor : sampled_descriptors) {
+      const descriptor &d = *set_and_descriptor.second;
+      const auto usage_it = sampling_usage.find(
+          std::make_pair(set_and_descriptor.first, d.slot));
+      const uint32_t usage =
+          usage_it != sampling_usage.end() ? usage_it->second : 0u;
+      metadata_file.write_field(set_and_descriptor.first);
+      metadata_file.write_field(d.slot);
+      metadata_file.write_field(usage);
+      if (opts.sampling_report) {
+        sampling_report.push_back(
+            sampling_report_entry { tech.name, d.name, d.stage_mask, usage });
+      }
+    }
+
+    // Write out the compile tier record.
+    metadata_file.start_new_record();
+    const size_t compile_tier_offset = metadata_file.contents().size();
+    metadata_file.write_field(opts.compile_tier);
+
+    // Write out the instrumentation record.
+    metadata_file.start_new_record();
+    metadata_file.write_field((uint32_t)counters.size());
+    metadata_file.write_field(instrumentation_set);
+    metadata_file.write_field(opts.instrument ? INSTRUMENTATION_BINDING : 0u);
+    metadata_file.finalize();
+    if (sink.write(output_kind::pipeline_metadata, tech.name + ".pipeline",
+                   metadata_file.contents())) {
+      ++files_written;
+    }
+    published_metadata[tech_idx] = metadata_file.contents();
+    // Unoptimized code may still refer to resources that optimizations
+    // remove, so the layout can change between the tiers.
+    if (opts.unoptimized_metadata != nullptr) {
+      std::string tierless_metadata = metadata_file.contents();
+      tierless_metadata.replace(compile_tier_offset, sizeof(uint32_t),
+                                sizeof(uint32_t), '\0');
+      if (opts.compile_tier == NGF_PLMD_COMPILE_TIER_FAST) {
+        (*opts.unoptimized_metadata)[tech.name] = std::move(tierless_metadata);
+      } else if ((*opts.unoptimized_metadata)[tech.name] !=
+                 tierless_metadata) {
+        fprintf(sink.status_stream(),
+                "Pipeline metadata of technique %s differs between the "
+                "unoptimized and optimized builds\n", tech.name.c_str());
+      }
+    }
+    if (opts.instrument &&
+        sink.write(output_kind::counter_map, tech.name + ".counters.json",
+                   counter_map_json(tech.name, instrumentation_set,
+                                    INSTRUMENTATION_BINDING, counters))) {
+      ++files_written;
+    }
+  }
+  header_writer.finalize();
+  if (!opts.header_path.empty() &&
+      sink.write(output_kind::header, opts.header_path,
+                 header_writer.contents())) {
+    ++files_written;
+  }
+  sink.finish();
+  if (opts.cbuffer_report) {
+    print_cbuffer_report(sink.status_stream(), cbuffer_report,
+                         opts.pack_cbuffers);
+  }
+  if (opts.sampling_report) {
+    print_sampling_report(sink.status_stream(), sampling_report);
+  }
+  if (opts.profile.enabled()) {
+    print_usage_pruning_report(sink.status_stream(), opts.profile,
+                               pruning);
+  }
+  if (opts.alias_outputs) {
+    fprintf(sink.status_stream(),
+            "Aliased %u identical output files, saving %llu bytes\n",
+            aliased_files, (unsigned long long)aliased_bytes);
+  }
+
+  // Techniques are only published once all of them have been built, so that
+  // applications never see a partially applied change.
+  if (publisher) {
+    for (size_t tech_idx = 0u; tech_idx < techniques.size(); ++tech_idx) {
+      publisher->publish(techniques[tech_idx].name,
+                         published_files[tech_idx],
+                         published_metadata[tech_idx]);
+    }
+  }
+#pragma endregion gen_output
+  return files_written;
+}
+
+// Runs a build, reporting any errors. Returns false if the build failed.
+bool run_build(const build_options &opts,
+               dxc_wrapper &dxcompiler,
+               dxc_wrapper *dxil_compiler,
+               artifact_cache &cache,
+               output_sink &sink,
+               hot_reload_publisher *publisher,
+               std::set<std::string> &source_files,
+               uint32_t &files_written) {
+  bool succeeded = false;
+  try {
+    files_written =
+        build(opts, dxcompiler, dxil_compiler, cache, sink, publisher,
+              source_files);
+    succeeded = true;
+  } catch (const build_error&) {
+  } catch (const spirv_cross::CompilerError &e) {
+    fprintf(stderr, "SPIRV-Cross error: %s\n", e.what());
+  }
+  set_build_phase(build_phase::other);
+  return succeeded;
+}
+
+// Checks the input for errors without generating code or writing any files.
+// Each unique combination of entry point and defines is only run through the
+// front end of `check_compiler', and the diagnostics are printed to stdout as
+// JSON, one per line. Returns false if there were errors.
+bool run_check(const build_options &opts, dxc_wrapper &check_compiler) {
+  std::set<std::string> source_files;
+  std::string input_source;
+  std::vector<technique> techniques;
+  technique_parser_error parser_error;
+  try {
+    input_source = load_input(opts, source_files);
+    parse_techniques(input_source, techniques, opts.global_macro_definitions,
+                     &parser_error);
+  } catch (const build_error&) {
+    if (parser_error.message.empty()) return false;
+    diagnostic d;
+    d.file = opts.source_name;
+    d.line = parser_error.line;
+    d.severity = "error";
+    d.message = parser_error.message;
+    print_diagnostic_json(stdout, d, std::string(), std::string());
+    return false;
+  }
+
+  if (techniques.empty()) {
+    diagnostic d;
+    d.file = opts.source_name;
+    d.severity = "error";
+    d.message = "input file does not appear to define any techniques";
+    print_diagnostic_json(stdout, d, std::string(), std::string());
+    return false;
+  }
+
+  std::set<std::tuple<shader_kind, std::string, define_container>> checked;
+  std::set<std::string> printed;
+  uint32_t nerrors = 0u, nwarnings = 0u;
+  for (const technique &tech : techniques) {
+    for (const technique::entry_point &ep : tech.entry_points) {
+      if (!checked.emplace(ep.kind, ep.name, tech.defines).second) continue;
+      const dxc_wrapper::result result =
+          check_compiler.compile_hlsl2spv(input_source.c_str(),
+                                          input_source.size(),
+                                          opts.source_name.c_str(),
+                                          ep, tech.defines);
+      std::vector<diagnostic> diagnostics =
+          parse_dxc_diagnostics(result.diag_message, opts.source_name);
+      if (!result.HasData() &&
+          std::none_of(diagnostics.begin(), diagnostics.end(),
+                       [](const diagnostic &d) {
+                         return d.severity == "error";
+                       })) {
+        diagnostic d;
+        d.file = opts.source_name;
+        d.severity = "error";
+        d.message = "compilation failed";
+        diagnostics.push_back(d);
+      }
+      // Code shared by several entry points produces the same diagnostics
+      // for each of them, only the first one is printed.
+      for (const diagnostic &d : diagnostics) {
+        const std::string key = d.file + ":" + std::to_string(d.line) + ":" +
+                                std::to_string(d.column) + ":" + d.severity +
+                                ":" + d.message;
+        if (!printed.insert(key).second) continue;
+        if (d.severity == "error") ++nerrors;
+        if (d.severity == "warning") ++nwarnings;
+        print_diagnostic_json(stdout, d, tech.name, ep.name);
+      }
+    }
+  }
+  fflush(stdout);
+  fprintf(stderr, "Checked %zu entry points: %u errors, %u warnings\n",
+          checked.size(), nerrors, nwarnings);
+  return nerrors == 0u;
+}
+
+}
+
 int main(int argc, const char *argv[]) {
   if (argc <= 1) { // Display help if invoked with no arguments.
     printf("%s\n", USAGE);
     exit(0);
   }
+  const std::string exe_path(argv[0]);
+  const std::string exe_dir = exe_path.substr(0, exe_path.find_last_of("/\\"));
+
+  if (std::string(argv[1]) == "--worker") { // Run in worker mode.
+    if (argc != 3) {
+      fprintf(stderr, "Expected an address after --worker\n");
+      exit(1);
+    }
+    run_compile_worker(argv[2], exe_dir);
+  }
+
+  if (std::string(argv[1]) == COMPILE_PROCESS_OPTION) {
+    // Started by a compile process pool.
+    if (argc != 5) {
+      fprintf(stderr, "Expected three file descriptors after %s\n",
+              COMPILE_PROCESS_OPTION);
+      exit(1);
+    }
+    run_compile_process(argv + 2, exe_dir);
+  }
 
 #pragma region cmdline
   // Process command line options, stopping at double dash.
   // Everything after the double dash will be passed as-is to
   // Microsoft DirectX Shader Compiler.
-  const std::string input_file_path { argv[1] };
-  std::string out_folder = ".";
-  std::string header_path = "";
-  std::string header_namespace = "";
-  std::string shader_model = "6_2";
-  std::vector<const target_info*> targets;
-  define_container global_macro_definitions;
+  build_options opts;
+  opts.input_file_path = argv[1];
+  opts.source_name =
+      opts.input_file_path == STDIN_INPUT ? "<stdin>" : opts.input_file_path;
+  std::string cache_dir = "";
+  std::string cache_url = "";
+  std::string publish_address = "";
+  std::string mem_stats_path = "";
+  bool watch = false;
+  bool emit_stream = false;
+  bool perf_counters = false;
+  bool tiered = false;
+  bool check = false;
+  uint32_t nprocesses = 0u;
+  uint32_t compile_timeout_ms = 0u;
   size_t dxc_options_start = argc;
 
   for (size_t o = 2u;
        o < (size_t)argc && dxc_options_start >= argc;
-       o += 2u) {
+       ++o) {
     const std::string option_name { argv[o] };
     if (option_name == "--") {
       dxc_options_start = o + 1u;
       continue;
     }
+    if ("--watch" == option_name) { // Options without a value.
+      watch = true;
+      continue;
+    } else if ("--emit-stream" == option_name) {
+      emit_stream = true;
+      continue;
+    } else if ("--alias-outputs" == option_name) {
+      opts.alias_outputs = true;
+      continue;
+    } else if ("--object-store" == option_name) {
+      opts.object_store = true;
+      continue;
+    } else if ("--pack-cbuffers" == option_name) {
+      opts.pack_cbuffers = true;
+      continue;
+    } else if ("--ios-base-vertex" == option_name) {
+      opts.ios_base_vertex = true;
+      continue;
+    } else if ("--cbuffer-report" == option_name) {
+      opts.cbuffer_report = true;
+      continue;
+    } else if ("--sampling-report" == option_name) {
+      opts.sampling_report = true;
+      continue;
+    } else if ("--perf-counters" == option_name) {
+      perf_counters = true;
+      continue;
+    } else if ("--tiered" == option_name) {
+      tiered = true;
+      continue;
+    } else if ("--reflect-only" == option_name) {
+      opts.reflect_only = true;
+      continue;
+    } else if ("--check" == option_name) {
+      check = true;
+      continue;
+    } else if ("--instrument" == option_name) {
+      opts.instrument = true;
+      continue;
+    }
     if (o + 1u >= (uint32_t)argc) {
       fprintf(stderr, "Expected an option value after %s\n", argv[o]);
       exit(1);
     }
-    const std::string option_value { argv[o + 1u] };
+    const std::string option_value { argv[++o] };
     if (option_value == "--") {
-      fprintf(stderr, "Expected an option value after %s,\n", argv[o]);
+      fprintf(stderr, "Expected an option value after %s,\n",
+              option_name.c_str());
       exit(1);
     }
     if ("-t" == option_name) { // Target to generate code for.
@@ -128,9 +1381,11 @@ int main(int argc, const char *argv[]) {
         fprintf(stderr, "Unknown target \"%s\"\n", option_value.c_str());
         exit(1);
       }
-      targets.push_back(&(t->target));
+      opts.targets.push_back(&(t->target));
+      if (t->target.api == target_api::D3D12) opts.dxil_target = true;
     } else if ("-m" == option_name) {
-      shader_model = option_value;
+      opts.shader_model = option_value;
+      const std::string &shader_model = opts.shader_model;
       if (shader_model.length() != 3) {
           fprintf(stderr, "Invalid value for shader model: \"%s\"\n", shader_model.c_str());
           exit(1);
@@ -145,17 +1400,51 @@ int main(int argc, const char *argv[]) {
         }
       }
     } else if ("-O" == option_name) { // Output folder.
-      out_folder = option_value;
+      opts.out_folder = option_value;
     } else if ("-h" == option_name) {
-      header_path = option_value;
+      opts.header_path = option_value;
     } else if ("-n" == option_name) {
-      header_namespace = option_value;
+      opts.header_namespace = option_value;
+    } else if ("--cache-dir" == option_name) {
+      cache_dir = option_value;
+    } else if ("--cache-url" == option_name) {
+      cache_url = option_value;
+    } else if ("--publish" == option_name) {
+      publish_address = option_value;
+    } else if ("--mem-stats" == option_name) {
+      mem_stats_path = option_value;
+    } else if ("--processes" == option_name) {
+      nprocesses = (uint32_t)strtoul(option_value.c_str(), nullptr, 10);
+      if (nprocesses == 0u) {
+        fprintf(stderr, "Invalid number of processes: \"%s\"\n",
+                option_value.c_str());
+        exit(1);
+      }
+    } else if ("--compile-timeout" == option_name) {
+      compile_timeout_ms =
+          (uint32_t)strtoul(option_value.c_str(), nullptr, 10);
+      if (compile_timeout_ms == 0u) {
+        fprintf(stderr, "Invalid compile timeout: \"%s\"\n",
+                option_value.c_str());
+        exit(1);
+      }
+    } else if ("--usage-profile" == option_name) {
+      std::string error;
+      if (!load_usage_profile(option_value.c_str(), opts.profile,
+                              error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        exit(1);
+      }
+    } else if ("--always-build" == option_name) {
+      opts.profile.always_build.push_back(option_value);
+    } else if ("-w" == option_name) {
+      opts.worker_addresses.push_back(option_value);
     } else if ("-D" == option_name) {
         const size_t pos = option_value.find('=');
         if (pos < option_value.size())
-          global_macro_definitions.emplace_back(option_value.substr(0, pos), option_value.substr(pos+1));
+          opts.global_macro_definitions.emplace_back(option_value.substr(0, pos), option_value.substr(pos+1));
         else
-          global_macro_definitions.emplace_back(option_value, std::string());
+          opts.global_macro_definitions.emplace_back(option_value, std::string());
     } else {
       fprintf(stderr, "Unknown option: \"%s\"\n", option_name.c_str());
       exit(1);
@@ -163,150 +1452,346 @@ int main(int argc, const char *argv[]) {
   }
 
   // Build up parameters for the DirectX Shader Compiler.
-  std::vector<std::string> dxc_options = {
+  opts.dxc_options = {
     "-spirv",  // always enable spir-v codegen
     "-Zpc"     // always forbid overriding explicit matrix orientation.
   };
   // Add the remaining dxc parameters from the command line.
   for (size_t o = dxc_options_start; o < argc; ++o)
-    dxc_options.emplace_back(argv[o]);
+    opts.dxc_options.emplace_back(argv[o]);
+  // Counters of instrumented shaders are mapped to source locations, which
+  // DXC only emits into SPIR-V on request.
+  if (opts.instrument) opts.dxc_options.emplace_back("-fspv-debug=line");
+
+  // The dxil target uses the same parameters, minus the SPIR-V specific ones
+  // along with their values, and has the root signature embedded into the
+  // shaders.
+  for (size_t o = 0u; o < opts.dxc_options.size(); ++o) {
+    const std::string &option = opts.dxc_options[o];
+    if (option == "-spirv") continue;
+    if (option.compare(0, 5, "-fvk-") == 0 ||
+        option.compare(0, 6, "-fspv-") == 0) {
+      o += spirv_option_value_count(option);
+      continue;
+    }
+    opts.dxil_dxc_options.push_back(option);
+  }
+  opts.dxil_dxc_options.push_back("-rootsig-define");
+  opts.dxil_dxc_options.push_back(ROOT_SIGNATURE_DEFINE);
 #pragma endregion cmd_line
 
 #pragma region pre_checks
+  // The pipeline layout doesn't depend on the targets (only the combined
+  // image/sampler maps and the root signature do), so reflection can do
+  // without them.
+  if (opts.targets.empty() && opts.reflect_only) {
+    const auto *spv = std::find_if(TARGET_MAP, TARGET_MAP + TARGET_COUNT,
+                                   [](const named_target_info &x) {
+                                     return strcmp(x.name, "spv") == 0;
+                                   });
+    opts.targets.push_back(&spv->target);
+  }
+
   // Do a sanity check - no point in running with no targets.
-  if (targets.empty()) {
+  if (opts.targets.empty() && !check) {
     fprintf(stderr, "No target shader flavors specified!"
                     " Use -t to specify a target.\n");
     exit(1);
   }
 
-  // Make sure targets are always processed in the same order, no matter
-  // what order they're specified in.
-  std::sort(targets.begin(), targets.end(), [](const target_info *t1,
-                                               const target_info *t2) { 
-                                              return t1->api < t2->api;
-                                            });
-#pragma endregion pre_checks
+  if (watch && opts.input_file_path == STDIN_INPUT) {
+    fprintf(stderr, "--watch can't be used when reading input from stdin\n");
+    exit(1);
+  }
 
-#pragma region load_input
-  // Load the input file.
-  std::string input_source = read_file(input_file_path.c_str());
-  input_source.push_back('\n');
+  if (opts.object_store && opts.alias_outputs) {
+    fprintf(stderr, "--alias-outputs can't be used together with "
+                    "--object-store, which never duplicates shaders\n");
+    exit(1);
+  }
 
-  // Look for and parse technique directives in the code.
-  std::vector<technique> techniques;
-  parse_techniques(input_source, techniques, global_macro_definitions);
-  if (techniques.size() == 0u) {
-    fprintf(stderr, "Input file does not appear to define any techniques. "
-                    "Define techniques with a special comment (`//T:').\n");
+  if (!opts.profile.always_build.empty() &&
+      !opts.profile.enabled()) {
+    fprintf(stderr, "--always-build can only be used together with "
+                    "--usage-profile\n");
     exit(1);
   }
-  const std::string exe_path(argv[0]);
-  const std::string exe_dir = exe_path.substr(0, exe_path.find_last_of("/\\"));
-#pragma endregion load_input
 
-#pragma region gen_spv
-  // Obtain SPIR-V.
-  dxc_wrapper dxcompiler(shader_model, dxc_options, exe_dir);
-  for (technique &tech : techniques) {
-    for (technique::entry_point &ep : tech.entry_points) {
-      // Produce SPIR-V.
-      dxc_wrapper::result result = dxcompiler.compile_hlsl2spv(
-          input_source.c_str(),
-          input_source.size(),
-          input_file_path.c_str(),
-          ep,
-          tech.defines);
-      if (result.HasDiagMessage()) {
-        fprintf(stderr, "%s", result.diag_message.c_str());
-      }
-      if (!result.HasData()) {
+  if (check && (watch || emit_stream || tiered || opts.reflect_only ||
+                opts.instrument || nprocesses > 0u ||
+                !opts.worker_addresses.empty())) {
+    fprintf(stderr, "--check can't be used together with --watch, "
+                    "--emit-stream, --tiered, --reflect-only, --instrument, "
+                    "--processes or -w\n");
+    exit(1);
+  }
+
+  if (opts.reflect_only && (opts.alias_outputs || opts.object_store)) {
+    fprintf(stderr, "--alias-outputs and --object-store can't be used "
+                    "together with --reflect-only, which writes no shaders\n");
+    exit(1);
+  }
+
+  if (opts.reflect_only && tiered) {
+    // Unoptimized SPIR-V may use resources that optimizations remove, which
+    // would change the pipeline layout.
+    fprintf(stderr, "--tiered can't be used together with --reflect-only\n");
+    exit(1);
+  }
+
+  if (opts.pack_cbuffers && opts.dxil_target) {
+    // The dxil target is compiled from HLSL rather than from the rewritten
+    // SPIR-V, so its shaders would read uniform buffers at the declared
+    // offsets rather than at the packed ones.
+    fprintf(stderr, "--pack-cbuffers can't be used with target dxil\n");
+    exit(1);
+  }
+
+  if (opts.instrument) {
+    // The dxil target is compiled from HLSL rather than from the rewritten
+    // SPIR-V, and OpenGL ES 3.0 has no storage buffers.
+    for (const target_info *target : opts.targets) {
+      if (target->api == target_api::D3D12 ||
+          (target->api == target_api::GL && target->version_maj == 3u &&
+           target->version_min == 0u)) {
+        fprintf(stderr, "--instrument can't be used with target %s\n",
+                target_name(target));
         exit(1);
       }
-      ep.spirv_code = std::move(result.spirv_code);
     }
   }
-#pragma endregion gen_spv
 
- #pragma region gen_output
-  // Generate output.
+  if (tiered && emit_stream) {
+    fprintf(stderr, "--tiered can't be used together with --emit-stream\n");
+    exit(1);
+  }
 
-  // Attempt to open header file for writing.
-  const bool generate_header = !header_path.empty();
-  header_file_writer header_writer(out_folder, header_path, header_namespace);
-  if (generate_header && !header_writer.is_open()) {
-    fprintf(stderr, "Failed to open output file %s\n", header_writer.path());
+  if (tiered && perf_counters) {
+    // The optimized rebuild may run on a different thread, and the counters
+    // only measure the thread that enabled them.
+    fprintf(stderr, "--tiered can't be used together with --perf-counters\n");
     exit(1);
   }
 
-  for (const technique& tech : techniques) {
-    pipeline_layout res_layout;
-    separate_to_combined_map images_to_cis, samplers_to_cis;
-    std::vector<compilation> compilations;
-    
-    for (const technique::entry_point& ep : tech.entry_points) {
-      const std::vector<uint32_t>& spv_code = ep.spirv_code;
-      for (const target_info* target_info : targets) {
-        compilations.emplace_back(ep.kind, spv_code, *target_info);
-        compilations.back().add_cis_to_map(images_to_cis, samplers_to_cis);
-        compilations.back().add_resources_to_pipeline_layout(res_layout);
-      }
-    }
+  if (nprocesses > 0u && !opts.worker_addresses.empty()) {
+    fprintf(stderr, "--processes can't be used together with -w\n");
+    exit(1);
+  }
 
-    res_layout.remap_resources();
+  if (compile_timeout_ms > 0u && nprocesses == 0u &&
+      opts.worker_addresses.empty()) {
+    fprintf(stderr, "--compile-timeout can only be used together with "
+                    "--processes or -w\n");
+    exit(1);
+  }
+  if (compile_timeout_ms > 0u) opts.compile_timeout_ms = compile_timeout_ms;
 
-    for (compilation &c : compilations) {
-      std::string out_file_path = out_folder + PATH_SEPARATOR + tech.name;
-      c.run(out_file_path.c_str(), res_layout);
+  if (!publish_address.empty() && !watch) {
+    fprintf(stderr, "--publish can only be used together with --watch\n");
+    exit(1);
+  }
+
+  // Make sure targets are always processed in the same order, no matter
+  // what order they're specified in. Within an API, targets are ordered as in
+  // TARGET_MAP, so aliases always refer to the oldest version.
+  std::sort(opts.targets.begin(), opts.targets.end(),
+            [](const target_info *t1, const target_info *t2) {
+              return t1->api < t2->api || (t1->api == t2->api && t1 < t2);
+            });
+#pragma endregion pre_checks
+
+  // Checking only needs the compiler's front end. DXC doesn't offer a
+  // syntax-only mode, the closest is emitting unoptimized SPIR-V without
+  // legalization or validation.
+  if (check) {
+    std::vector<std::string> check_options = opts.dxc_options;
+    check_options.emplace_back("-fcgl");
+    dxc_wrapper check_compiler(opts.shader_model, check_options, exe_dir);
+    return run_check(opts, check_compiler) ? 0 : 1;
+  }
+
+  std::unique_ptr<compile_process_pool> process_pool;
+  if (nprocesses > 0u) {
+    process_pool = std::make_unique<compile_process_pool>(
+        nprocesses,
+        opts.compile_timeout_ms,
+        exe_path);
+    opts.process_pool = process_pool.get();
+  }
+
+  // Count allocations from here on, so that the statistics cover setting up
+  // the compiler as well.
+  if (!mem_stats_path.empty()) enable_mem_stats();
+  const auto write_mem_stats = [&mem_stats_path]() {
+    if (!mem_stats_path.empty() &&
+        !write_file_atomically(mem_stats_path.c_str(), mem_stats_json())) {
+      fprintf(stderr, "Failed to write memory statistics to %s\n",
+              mem_stats_path.c_str());
     }
+  };
 
-    // Write out the .pipeline file for the current technique.
-    std::string metadata_file_path =
-      out_folder + PATH_SEPARATOR + tech.name + ".pipeline";
-    pipeline_metadata_file metadata_file(metadata_file_path.c_str());
-    header_writer.begin_technique(tech.name);
+  // The compiler and the cache are kept around for the lifetime of the
+  // process, so that rebuilds in watch mode only redo the work affected by
+  // the changes.
+  artifact_cache cache(cache_dir, cache_url);
+  dxc_wrapper dxcompiler(opts.shader_model, opts.dxc_options, exe_dir);
+  std::unique_ptr<dxc_wrapper> dxil_compiler;
+  if (opts.dxil_target && !opts.reflect_only) {
+    dxil_compiler = std::make_unique<dxc_wrapper>(opts.shader_model,
+                                                  opts.dxil_dxc_options,
+                                                  exe_dir);
+  }
+  output_sink sink(opts.out_folder, emit_stream);
+  sink.set_compare_contents(watch || tiered);
+  FILE *status_stream = sink.status_stream();
+  if (perf_counters) {
+    enable_perf_counters(status_stream, !opts.worker_addresses.empty() ||
+                                            opts.process_pool != nullptr);
+  }
+  std::set<std::string> source_files;
+  uint32_t files_written = 0u;
 
-    // Write out the entrypoints section.
-    metadata_file.start_new_record();
-    metadata_file.write_field((uint32_t)tech.entry_points.size());
-    for (const technique::entry_point& ep : tech.entry_points) {
-      metadata_file.write_field((uint32_t)ep.kind);
-      metadata_file.write_raw_bytes(ep.name.c_str(),
-        ep.name.length() + 1u);
+  // In tiered mode, every build is first done without optimizations, and the
+  // optimized outputs then replace the unoptimized ones. Applications may be
+  // loading the outputs in the meantime, so they're replaced atomically.
+  std::map<std::string, std::string> unoptimized_metadata;
+  if (tiered) opts.unoptimized_metadata = &unoptimized_metadata;
+  build_options fast_opts = opts;
+  std::unique_ptr<dxc_wrapper> fast_dxcompiler;
+  std::unique_ptr<dxc_wrapper> fast_dxil_compiler;
+  if (tiered) {
+    fast_opts.compile_tier = NGF_PLMD_COMPILE_TIER_FAST;
+    fast_opts.dxc_options.emplace_back("-O0");
+    fast_opts.dxil_dxc_options.emplace_back("-O0");
+    fast_dxcompiler = std::make_unique<dxc_wrapper>(opts.shader_model,
+                                                    fast_opts.dxc_options,
+                                                    exe_dir);
+    if (dxil_compiler) {
+      fast_dxil_compiler =
+          std::make_unique<dxc_wrapper>(opts.shader_model,
+                                        fast_opts.dxil_dxc_options, exe_dir);
     }
+    sink.set_atomic_writes(true);
+  }
 
-    // Write out the pipeline layout record.
-    metadata_file.start_new_record();
-    metadata_file.write_field(res_layout.set_count());
-    for (uint32_t set = 0u; set < res_layout.set_count(); ++set) {
-      const descriptor_set_layout& ds = res_layout.set(set);
-      metadata_file.write_field((uint32_t)ds.size());
-      for (const auto& d : ds) {
-        metadata_file.write_field(d.second.slot);
-        metadata_file.write_field((uint32_t)d.second.type);
-        metadata_file.write_field(d.second.stage_mask);
-        header_writer.write_descriptor(d.second, set);
+  if (!watch) {
+    if (tiered) {
+      const auto start_time = std::chrono::steady_clock::now();
+      if (!run_build(fast_opts, *fast_dxcompiler, fast_dxil_compiler.get(),
+                     cache, sink, nullptr, source_files, files_written)) {
+        write_mem_stats();
+        return 1;
       }
+      fprintf(status_stream,
+              "Unoptimized build finished in %.0f ms, "
+              "%u output files updated\n",
+              std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start_time).count(),
+              files_written);
+      fflush(status_stream);
+      lower_thread_priority();
     }
-    header_writer.end_technique();
-
-    // Write out separate-to-combined map records.
-    metadata_file.start_new_record();
-    images_to_cis.serialize(metadata_file);
-    metadata_file.start_new_record();
-    samplers_to_cis.serialize(metadata_file);
+    const bool succeeded =
+        run_build(opts, dxcompiler, dxil_compiler.get(), cache, sink, nullptr,
+                  source_files, files_written);
+    if (succeeded && cache.enabled()) {
+      cache.print_stats(status_stream);
+    }
+    if (succeeded) print_perf_counters(status_stream);
+    write_mem_stats();
+    return succeeded ? 0 : 1;
+  }
 
-    // Write out user metadata record.
-    metadata_file.start_new_record();
-    metadata_file.write_field((uint32_t)tech.additional_metadata.size());
-    for (const auto& nameval : tech.additional_metadata) {
-      metadata_file.write_raw_bytes(nameval.first.c_str(),
-        nameval.first.size() + 1u);
-      metadata_file.write_raw_bytes(nameval.second.c_str(),
-        nameval.second.size() + 1u);
+  // In watch mode, rebuild whenever the input file or any of the files it
+  // includes changes. Preprocessing is needed to find the included files,
+  // and keeping artifacts in memory makes it pay for itself.
+  cache.keep_in_memory();
+  std::unique_ptr<hot_reload_publisher> publisher;
+  if (!publish_address.empty()) {
+    publisher = std::make_unique<hot_reload_publisher>(publish_address);
+  }
+  // The optimized rebuild of a tiered build runs in the background while
+  // waiting for changes, and is cancelled if the input changes again before
+  // it finishes.
+  std::atomic<bool> cancel_optimized_build { false };
+  std::thread optimized_build_thread;
+  const auto stop_optimized_build = [&]() {
+    if (optimized_build_thread.joinable()) {
+      cancel_optimized_build = true;
+      optimized_build_thread.join();
+      cancel_optimized_build = false;
     }
-    metadata_file.finalize();
+  };
+  build_options optimized_opts = opts;
+  optimized_opts.cancel = &cancel_optimized_build;
+  for (;;) {
+    const auto start_time = std::chrono::steady_clock::now();
+    // Only keep the artifacts of the previous build (both tiers of it, in
+    // tiered mode), the others are unlikely to be needed again.
+    cache.evict_unused();
+    // Files saved while the build runs must trigger another build, so their
+    // state is recorded up-front.
+    std::vector<std::string> snapshot_files(source_files.begin(),
+                                            source_files.end());
+    snapshot_files.push_back(opts.input_file_path);
+    const file_snapshot snapshot(snapshot_files);
+    std::set<std::string> new_source_files;
+    cache.reset_stats();
+    reset_mem_stats();
+    reset_perf_counters();
+    const bool succeeded =
+        tiered ? run_build(fast_opts, *fast_dxcompiler,
+                           fast_dxil_compiler.get(), cache, sink,
+                           publisher.get(), new_source_files, files_written)
+               : run_build(opts, dxcompiler, dxil_compiler.get(), cache, sink,
+                           publisher.get(), new_source_files, files_written);
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time).count();
+    if (succeeded) {
+      cache.print_stats(status_stream);
+      print_perf_counters(status_stream);
+      fprintf(status_stream, "%s finished in %.0f ms, %u output files updated\n",
+             tiered ? "Unoptimized build" : "Build", elapsed_ms,
+             files_written);
+      source_files = std::move(new_source_files);
+    } else {
+      // A failed build may not have discovered all of the included files,
+      // keep watching the ones found previously.
+      fprintf(status_stream, "Build failed\n");
+      source_files.insert(new_source_files.begin(), new_source_files.end());
+    }
+    write_mem_stats();
+    fprintf(status_stream, "Watching %zu source files for changes...\n",
+            source_files.size());
+    fflush(status_stream);
+    if (tiered && succeeded) {
+      optimized_build_thread = std::thread([&]() {
+        lower_thread_priority();
+        const auto optimized_start_time = std::chrono::steady_clock::now();
+        std::set<std::string> unused_source_files;
+        uint32_t optimized_files_written = 0u;
+        const bool optimized_succeeded =
+            run_build(optimized_opts, dxcompiler, dxil_compiler.get(), cache,
+                      sink, publisher.get(), unused_source_files,
+                      optimized_files_written);
+        if (optimized_succeeded) {
+          fprintf(status_stream,
+                  "Optimized build finished in %.0f ms, "
+                  "%u output files updated\n",
+                  std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() -
+                      optimized_start_time).count(),
+                  optimized_files_written);
+        } else if (!cancel_optimized_build) {
+          fprintf(status_stream, "Optimized build failed\n");
+        }
+        fflush(status_stream);
+      });
+    }
+    wait_for_file_changes(std::vector<std::string>(source_files.begin(),
+                                                   source_files.end()),
+                          snapshot);
+    // Changes make the optimized build obsolete.
+    stop_optimized_build();
   }
-#pragma endregion gen_output
-  return 0;
 }
@@ -0,0 +1,120 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "output_sink.h"
+#include "build_error.h"
+#include "file_utils.h"
+#include "net_utils.h"
+
+#include <filesystem>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+output_sink::output_sink(const std::string &folder, bool stream)
+    : folder_(folder),
+      stream_(stream) {
+#if defined(_WIN32) || defined(_WIN64)
+  if (stream_) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void write_frame(const std::string &payload) {
+  wire_writer w;
+  w.write_bytes(payload.data(), payload.size());
+  const std::string &frame = w.data();
+  if (fwrite(frame.data(), 1u, frame.size(), stdout) != frame.size()) {
+    fprintf(stderr, "Failed to write to the output stream\n");
+    abort_build();
+  }
+}
+
+}
+
+bool output_sink::write(output_kind kind, const std::string &name,
+                        const std::string &data) {
+  if (!stream_) {
+    const std::string path = folder_ + PATH_SEPARATOR + name;
+    // Generated files may go to subfolders, i.e. the object store.
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+    if (compare_contents_) {
+      std::string old_data;
+      if (try_read_file(path.c_str(), old_data) && old_data == data) {
+        return false;
+      }
+    }
+    // Writing through a hard link left by a previous build would clobber
+    // the file it was an alias of.
+    if (fs::hard_link_count(path, ec) > 1u && !ec) fs::remove(path, ec);
+    if (atomic_writes_) {
+      if (!write_file_atomically(path.c_str(), data)) {
+        fprintf(stderr, "Failed to write %s\n", path.c_str());
+        abort_build();
+      }
+      return true;
+    }
+    write_file(path.c_str(), data);
+    return true;
+  }
+  wire_writer w;
+  w.write_field((uint32_t)kind);
+  w.write_string(name);
+  w.write_string(data);
+  write_frame(w.data());
+  return true;
+}
+
+bool output_sink::write_alias(const std::string &name,
+                              const std::string &target_name,
+                              const std::string &data) {
+  if (!stream_) {
+    const std::string path = folder_ + PATH_SEPARATOR + name;
+    const std::string target_path = folder_ + PATH_SEPARATOR + target_name;
+    std::error_code ec;
+    if (fs::equivalent(path, target_path, ec)) return false;
+    fs::remove(path, ec);
+    fs::create_hard_link(target_path, path, ec);
+    if (ec) write_file(path.c_str(), data);
+    return true;
+  }
+  wire_writer w;
+  w.write_field((uint32_t)output_kind::alias);
+  w.write_string(name);
+  w.write_string(target_name);
+  write_frame(w.data());
+  return true;
+}
+
+void output_sink::finish() {
+  if (stream_) {
+    write_frame(std::string());
+    fflush(stdout);
+  }
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// Kinds of generated files.
+enum class output_kind : uint32_t {
+  shader = 1u,
+  pipeline_metadata = 2u,
+  header = 3u,
+  alias = 4u,
+  counter_map = 5u
+};
+
+// Destination for generated files: either the output folder, or a binary
+// stream on the standard output.
+//
+// The stream is a sequence of frames (see `tcp_socket::send_frame'), each
+// containing the kind of the file, its name (relative to the output folder)
+// and its contents. For aliases, the contents are the name of the file being
+// aliased. A frame with an empty payload marks the end of a build.
+class output_sink {
+public:
+  output_sink(const std::string &folder, bool stream);
+
+  // Writes out a generated file. If contents are compared, files in the
+  // output folder that are already up to date are left untouched. Returns
+  // true if anything was written.
+  bool write(output_kind kind, const std::string &name,
+             const std::string &data);
+
+  // Writes out a file that is identical to the previously written file
+  // `target_name'. In the output folder, the file is created as a hard link
+  // (or as a copy, if hard links aren't supported). Returns true if anything
+  // was written.
+  bool write_alias(const std::string &name, const std::string &target_name,
+                   const std::string &data);
+
+  // Marks the end of a build.
+  void finish();
+
+  // Makes writes to the output folder replace files atomically (by writing
+  // to a temporary file and renaming it), so that readers never observe a
+  // partially written file.
+  void set_atomic_writes(bool atomic) { atomic_writes_ = atomic; }
+
+  // Makes writes to the output folder compare the contents of existing files
+  // first, and leave the ones that are up to date untouched, so that tools
+  // watching the folder don't reload needlessly. This costs a read of every
+  // existing file, which only pays off when rebuilding repeatedly.
+  void set_compare_contents(bool compare) { compare_contents_ = compare; }
+
+  // Stream that status messages should go to, so that they don't get mixed
+  // with the binary output.
+  FILE* status_stream() const { return stream_ ? stderr : stdout; }
+
+private:
+  std::string folder_;
+  bool stream_;
+  bool atomic_writes_ = false;
+  bool compare_contents_ = false;
+};
@@ -0,0 +1,269 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Accumulated measurements for a technique and phase.
+struct perf_entry {
+  uint32_t calls = 0u;
+  perf_sample counters;
+};
+
+bool enabled = false;
+bool dxc_preprocessing_only = false;
+
+// Techniques in the order they were first measured, and the measurements
+// for each of them.
+std::vector<std::string> techniques;
+std::map<std::pair<std::string, build_phase>, perf_entry> entries;
+
+constexpr uint32_t EVENT_COUNT = 4u;
+
+// Counter values that are not available.
+constexpr uint64_t UNAVAILABLE = ~0ull;
+
+#if defined(__linux__)
+
+const uint64_t EVENTS[EVENT_COUNT] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// All events are opened as a single group, so that they're scheduled onto the
+// hardware together. Events that can't be opened are left out of the group.
+int group_fd = -1;
+int event_indices[EVENT_COUNT] = { -1, -1, -1, -1 };
+uint32_t group_size = 0u;
+
+int open_event(uint64_t config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  // Counting user space only works with the default perf_event_paranoid
+  // setting, and the kernel's work isn't interesting here anyway.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+perf_sample read_counters() {
+  uint64_t data[3u + EVENT_COUNT];
+  perf_sample s;
+  if (read(group_fd, data, sizeof(data)) < (ssize_t)(3u * sizeof(uint64_t))) {
+    return s;
+  }
+  // If the kernel had to multiplex the counters, extrapolate from the time
+  // they were actually running.
+  const uint64_t time_enabled = data[1], time_running = data[2];
+  const double scale = time_running > 0u && time_running < time_enabled
+      ? (double)time_enabled / (double)time_running
+      : 1.0;
+  uint64_t values[EVENT_COUNT];
+  for (uint32_t e = 0u; e < EVENT_COUNT; ++e) {
+    values[e] = event_indices[e] < 0
+        ? UNAVAILABLE
+        : (uint64_t)((double)data[3u + event_indices[e]] * scale);
+  }
+  s.cycles = values[0];
+  s.instructions = values[1];
+  s.cache_misses = values[2];
+  s.branch_misses = values[3];
+  return s;
+}
+
+#else
+
+perf_sample read_counters() {
+  return perf_sample {};
+}
+
+#endif
+
+uint64_t delta(uint64_t start, uint64_t end) {
+  if (start == UNAVAILABLE || end == UNAVAILABLE) return UNAVAILABLE;
+  return end > start ? end - start : 0u;
+}
+
+void accumulate(uint64_t &sum, uint64_t value) {
+  sum = (sum == UNAVAILABLE || value == UNAVAILABLE) ? UNAVAILABLE
+                                                     : sum + value;
+}
+
+void accumulate(perf_entry &sum, const perf_entry &value) {
+  sum.calls += value.calls;
+  accumulate(sum.counters.cycles, value.counters.cycles);
+  accumulate(sum.counters.instructions, value.counters.instructions);
+  accumulate(sum.counters.cache_misses, value.counters.cache_misses);
+  accumulate(sum.counters.branch_misses, value.counters.branch_misses);
+}
+
+void format_counter(char *buf, size_t size, uint64_t value) {
+  if (value == UNAVAILABLE) snprintf(buf, size, "n/a");
+  else snprintf(buf, size, "%llu", (unsigned long long)value);
+}
+
+void print_entry(FILE *f, int name_width, const char *name,
+                 build_phase phase, const perf_entry &e) {
+  char cycles[24], instructions[24], cache_misses[24], branch_misses[24];
+  char ipc[16] = "n/a";
+  format_counter(cycles, sizeof(cycles), e.counters.cycles);
+  format_counter(instructions, sizeof(instructions), e.counters.instructions);
+  format_counter(cache_misses, sizeof(cache_misses), e.counters.cache_misses);
+  format_counter(branch_misses, sizeof(branch_misses),
+                 e.counters.branch_misses);
+  if (e.counters.cycles != UNAVAILABLE &&
+      e.counters.instructions != UNAVAILABLE && e.counters.cycles > 0u) {
+    snprintf(ipc, sizeof(ipc), "%.2f",
+             (double)e.counters.instructions / (double)e.counters.cycles);
+  }
+  fprintf(f, "  %-*s %-13s %6u %14s %14s %5s %12s %13s\n", name_width, name,
+          build_phase_name(phase), e.calls, cycles, instructions, ipc,
+          cache_misses, branch_misses);
+}
+
+}
+
+bool enable_perf_counters(FILE *f, bool remote_compilation) {
+  dxc_preprocessing_only = remote_compilation;
+#if defined(__linux__)
+  if (group_fd < 0) {
+    int open_errno = 0;
+    for (uint32_t e = 0u; e < EVENT_COUNT; ++e) {
+      const int fd = open_event(EVENTS[e]);
+      if (fd < 0) {
+        open_errno = errno;
+        continue;
+      }
+      if (group_fd < 0) group_fd = fd;
+      event_indices[e] = (int)group_size++;
+    }
+    if (group_fd < 0) {
+      fprintf(f, "Performance counters are unavailable (%s), "
+                 "--perf-counters is ignored\n", strerror(open_errno));
+      if (open_errno == EACCES || open_errno == EPERM) {
+        fprintf(f, "Check /proc/sys/kernel/perf_event_paranoid\n");
+      }
+      return false;
+    }
+    ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+  enabled = true;
+  return true;
+#else
+  fprintf(f, "Performance counters are only supported on Linux, "
+             "--perf-counters is ignored\n");
+  return false;
+#endif
+}
+
+void reset_perf_counters() {
+  techniques.clear();
+  entries.clear();
+}
+
+void print_perf_counters(FILE *f) {
+  if (!enabled) return;
+  static const char TOTAL[] = "total";
+  static const char ALL_TECHNIQUES[] = "*";
+  int name_width = (int)sizeof("technique") - 1;
+  for (const std::string &t : techniques) {
+    name_width = std::max(name_width, (int)t.size());
+  }
+  fprintf(f, "Performance counters:\n");
+  fprintf(f, "  %-*s %-13s %6s %14s %14s %5s %12s %13s\n", name_width,
+          "technique", "phase", "calls", "cycles", "instructions", "IPC",
+          "cache misses", "branch misses");
+  perf_entry totals[(uint32_t)build_phase::count];
+  for (const std::string &t : techniques) {
+    for (uint32_t p = 0u; p < (uint32_t)build_phase::count; ++p) {
+      auto it = entries.find(std::make_pair(t, (build_phase)p));
+      if (it == entries.end()) continue;
+      print_entry(f, name_width, t.empty() ? ALL_TECHNIQUES : t.c_str(),
+                  (build_phase)p, it->second);
+      accumulate(totals[p], it->second);
+    }
+  }
+  for (uint32_t p = 0u; p < (uint32_t)build_phase::count; ++p) {
+    if (totals[p].calls > 0u) {
+      print_entry(f, name_width, TOTAL, (build_phase)p, totals[p]);
+    }
+  }
+  if (dxc_preprocessing_only &&
+      totals[(uint32_t)build_phase::dxc].calls > 0u) {
+    fprintf(f, "  (%s: preprocessing only, compile jobs ran in other "
+               "processes and aren't measured)\n",
+            build_phase_name(build_phase::dxc));
+  }
+}
+
+perf_scope::perf_scope(const std::string &technique, build_phase phase)
+    : technique_(technique),
+      phase_(phase),
+      active_(enabled) {
+  if (active_) start_ = read_counters();
+}
+
+void perf_scope::finish() {
+  if (!active_) return;
+  active_ = false;
+  const perf_sample end = read_counters();
+  auto key = std::make_pair(technique_, phase_);
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    if (std::find(techniques.begin(), techniques.end(), technique_) ==
+        techniques.end()) {
+      techniques.push_back(technique_);
+    }
+    it = entries.emplace(std::move(key), perf_entry {}).first;
+  }
+  perf_entry e;
+  e.calls = 1u;
+  e.counters.cycles = delta(start_.cycles, end.cycles);
+  e.counters.instructions = delta(start_.instructions, end.instructions);
+  e.counters.cache_misses = delta(start_.cache_misses, end.cache_misses);
+  e.counters.branch_misses = delta(start_.branch_misses, end.branch_misses);
+  accumulate(it->second, e);
+}
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "build_phase.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// Values of the hardware performance counters collected for a build.
+struct perf_sample {
+  uint64_t cycles = 0u;
+  uint64_t instructions = 0u;
+  uint64_t cache_misses = 0u;
+  uint64_t branch_misses = 0u;
+};
+
+// Starts collecting hardware performance counters (cycles, instructions,
+// cache misses and branch misses) for the calling thread. If the counters
+// can't be used, prints the reason to `f' and returns false; measurements
+// are then ignored. `remote_compilation' tells that compile jobs run in other
+// processes, so the dxc phase only covers preprocessing, which is pointed
+// out in the report.
+bool enable_perf_counters(FILE *f, bool remote_compilation);
+
+// Discards all measurements, e.g. before starting another build.
+void reset_perf_counters();
+
+// Prints the measurements for each technique and phase, followed by the
+// totals for each phase.
+void print_perf_counters(FILE *f);
+
+// Measures the counters from construction until `finish' is called (or the
+// object is destroyed), and attributes the result to the given technique and
+// phase. An empty technique name stands for work that isn't specific to a
+// technique. Must be used on the thread that enabled the counters.
+class perf_scope {
+public:
+  perf_scope(const std::string &technique, build_phase phase);
+  ~perf_scope() { finish(); }
+  perf_scope(const perf_scope&) = delete;
+  perf_scope& operator=(const perf_scope&) = delete;
+
+  void finish();
+
+private:
+  const std::string &technique_;
+  build_phase phase_;
+  bool active_;
+  perf_sample start_;
+};
@@ -22,6 +22,7 @@
 
 
 #include "pipeline_layout.h"
+#include "build_error.h"
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -63,7 +64,7 @@ void pipeline_layout::process_resources(
       fprintf(stderr, "Attempt to assign a descriptor of different type to "
                       "slot %d in set %d which is already occupied by "
                       "\"%s\"\n", binding_id, set_id, desc.name.c_str());
-      exit(1);
+      abort_build();
     }
     if (desc.type != descriptor_type::INVALID &&
         r.name != desc.name) {
@@ -71,24 +72,27 @@ void pipeline_layout::process_resources(
                       "(\"%s\" and \"%s\")  to descriptor at slot %d in set "
                       "%d.\n", desc.name.c_str(), r.name.c_str(),
                       binding_id, set_id);
-      exit(1);
+      abort_build();
     }
     desc.stage_mask |= smb;
     desc.usages.emplace_back(&refl, r.id);
   }
 }
-void pipeline_layout::dump_native_binding_map(FILE* f) const{
-  fprintf(f, "/**NGF_NATIVE_BINDING_MAP\n");
+std::string pipeline_layout::native_binding_map() const {
+  std::string result = "/**NGF_NATIVE_BINDING_MAP\n";
+  char line[64];
   for (const auto &set_id_and_layout : sets_) {
     for (const auto &binding_id_and_descriptor : set_id_and_layout.second.layout) {
-      fprintf(f, "(%d %d) : %d\n",
-              set_id_and_layout.first,
-              binding_id_and_descriptor.first,
-              binding_id_and_descriptor.second.native_binding);
+      snprintf(line, sizeof(line), "(%d %d) : %d\n",
+               set_id_and_layout.first,
+               binding_id_and_descriptor.first,
+               binding_id_and_descriptor.second.native_binding);
+      result += line;
     }
   }
-  fprintf(f, "(-1 -1) : -1\n");
-  fprintf(f, "**/\n");
+  result += "(-1 -1) : -1\n";
+  result += "**/\n";
+  return result;
 }
 
 void pipeline_layout::remap_resources() {
@@ -83,9 +83,9 @@ public:
   // (i.e. OpenGL and Metal).
   void remap_resources();
 
-  // Dumps out the (set, binding) => (native binding) map as a comment to
-  // the output file.
-  void dump_native_binding_map(FILE* f) const;
+  // Returns the (set, binding) => (native binding) map formatted as a
+  // comment, to be appended to the output file.
+  std::string native_binding_map() const;
 
 private:
   struct descriptor_set {
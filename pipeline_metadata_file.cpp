@@ -22,9 +22,7 @@
 
 #define _CRT_SECURE_NO_WARNINGS
 #include "pipeline_metadata_file.h"
-#include <assert.h>
-#include <stdlib.h>
-#include <stdio.h>
+#include <string.h>
 
 #if defined(_WIN32) || defined(_WIN64)
 #pragma comment(lib, "ws2_32.lib")
@@ -33,26 +31,19 @@
 #include <arpa/inet.h>
 #endif
 
-pipeline_metadata_file::pipeline_metadata_file(const char *file_path) {
-  f_ = fopen(file_path, "wb");
-  if (f_ == nullptr) {
-    fprintf(stderr, "Error opening output file %s\n", file_path);
-    exit(1);
-  }
-  fwrite(&header_, sizeof(header_), 1u, f_); // write placeholder header.
+pipeline_metadata_file::pipeline_metadata_file() {
+  data_.resize(sizeof(header_)); // placeholder header.
   current_section_offset_ptr_ = &header_.entrypoints_offset;
 }
 
 void pipeline_metadata_file::start_new_record() {
-  assert(f_);
   *current_section_offset_ptr_ = htonl(current_offset_);
   current_section_offset_ptr_ += 1u;
 }
 
 void pipeline_metadata_file::write_field(uint32_t value) {
-  assert(f_);
   uint32_t nbo = htonl(value);
-  fwrite(&nbo, sizeof(uint32_t), 1u, f_);
+  data_.append((const char*)&nbo, sizeof(uint32_t));
   current_offset_ += 4u;
 }
 
@@ -64,10 +55,9 @@ void pipeline_metadata_file::write_raw_bytes(const void *bytes,
   size_t nwords = nwords_div + (nwords_mod > 0u ? 1u : 0u);
   write_field(0xffffffff);
   write_field((uint32_t)nwords);
-  fwrite(bytes, 1u, nbytes, f_);
+  data_.append((const char*)bytes, nbytes);
   if (nwords_mod > 0u) {
-    uint32_t dummy = 0u;
-    fwrite(&dummy, 1u, sizeof(uint32_t) - nwords_mod, f_);
+    data_.append(sizeof(uint32_t) - nwords_mod, '\0');
   }
   current_offset_ += (uint32_t)(nwords * sizeof(uint32_t));
 }
@@ -76,9 +66,6 @@ void pipeline_metadata_file::finalize() {
   header_.magic_number = htonl(0xdeadbeef);
   header_.header_size = htonl(sizeof(header_));
   header_.version_maj = htonl(0u);
-  header_.version_min = htonl(1u);
-  fseek(f_, 0u, 0u);
-  fwrite(&header_, sizeof(header_), 1u, f_);
-  fclose(f_);
-  f_ = NULL;
+  header_.version_min = htonl(12u);
+  memcpy(&data_[0], &header_, sizeof(header_));
 }
\ No newline at end of file
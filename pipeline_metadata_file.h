@@ -20,13 +20,13 @@ SOFTWARE.
 
 #include "metadata_parser/metadata_parser.h"
 #include <stdint.h>
-#include <stdio.h>
+#include <string>
 
 // Convenience class for generating pipeline metadata in binary format.
 class pipeline_metadata_file {
 public:
-  // Open a new pipeline metadata file for writing.
-  explicit pipeline_metadata_file(const char *file_path);
+  // Start a new pipeline metadata file in memory.
+  pipeline_metadata_file();
 
   // Begin a new record.
   void start_new_record();
@@ -37,11 +37,14 @@ public:
   // Write the contents of the given byte buffer into the file.
   void write_raw_bytes(const void *bytes, size_t nbytes);
 
-  // Finalize writing and close the file.
+  // Finalize the contents. No records may be added afterwards.
   void finalize();
 
+  // Returns the contents of the file. Only valid after finalizing.
+  const std::string& contents() const { return data_; }
+
 private:
-  FILE *f_;
+  std::string data_;
   ngf_plmd_header header_;
   uint32_t *current_section_offset_ptr_;
   uint32_t current_offset_ = sizeof(ngf_plmd_header);
@@ -0,0 +1,254 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "remote_compile.h"
+#include "artifact_cache.h"
+#include "hash_utils.h"
+#include "net_utils.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+namespace {
+
+// Bump whenever the layout of jobs or results changes.
+constexpr uint32_t PROTOCOL_VERSION = 1u;
+
+// Serves a single coordinator connection until it is closed.
+void serve_connection(tcp_socket connection, std::string exe_dir) {
+  job_compiler compiler(exe_dir);
+  std::string request;
+  while (connection.recv_frame(request)) {
+    compile_job job;
+    dxc_wrapper::result result;
+    if (!job.deserialize(request)) {
+      result.diag_message = "malformed compile job received by worker\n";
+    } else {
+      result = compiler.compile(job);
+    }
+    if (!connection.send_frame(serialize_compile_result(result))) break;
+  }
+}
+
+}
+
+std::string compile_job::serialize() const {
+  wire_writer w;
+  w.write_field(PROTOCOL_VERSION);
+  w.write_string(source_name);
+  w.write_string(preprocessed_source);
+  w.write_field((uint32_t)entry_point.kind);
+  w.write_string(entry_point.name);
+  w.write_field((uint32_t)defines.size());
+  for (const auto &define : defines) {
+    w.write_string(define.first);
+    w.write_string(define.second);
+  }
+  w.write_string(shader_model);
+  w.write_field((uint32_t)dxc_options.size());
+  for (const std::string &option : dxc_options) {
+    w.write_string(option);
+  }
+  return w.data();
+}
+
+bool compile_job::deserialize(const std::string &data) {
+  wire_reader r(data);
+  uint32_t version = 0u, kind = 0u, ndefines = 0u, noptions = 0u;
+  if (!r.read_field(version) || version != PROTOCOL_VERSION) return false;
+  r.read_string(source_name);
+  r.read_string(preprocessed_source);
+  r.read_field(kind);
+  if (kind > (uint32_t)shader_kind::fragment) return false;
+  entry_point.kind = (shader_kind)kind;
+  r.read_string(entry_point.name);
+  r.read_field(ndefines);
+  for (uint32_t d = 0u; d < ndefines && r.ok(); ++d) {
+    std::string name, value;
+    r.read_string(name);
+    r.read_string(value);
+    defines.emplace_back(std::move(name), std::move(value));
+  }
+  r.read_string(shader_model);
+  r.read_field(noptions);
+  for (uint32_t o = 0u; o < noptions && r.ok(); ++o) {
+    std::string option;
+    r.read_string(option);
+    dxc_options.emplace_back(std::move(option));
+  }
+  return r.ok();
+}
+
+std::string compile_job::cache_key() const {
+  // The source name is only used for diagnostics, and leaving it out allows
+  // sharing results between checkouts at different locations. Note that the
+  // preprocessed source may still refer to included files by path.
+  sha256 h;
+  h.update_string("spirv");
+  h.update_field(ARTIFACT_CACHE_VERSION);
+  h.update_string(preprocessed_source);
+  h.update_field((uint32_t)entry_point.kind);
+  h.update_string(entry_point.name);
+  h.update_field((uint32_t)defines.size());
+  for (const auto &define : defines) {
+    h.update_string(define.first);
+    h.update_string(define.second);
+  }
+  h.update_string(shader_model);
+  h.update_field((uint32_t)dxc_options.size());
+  for (const std::string &option : dxc_options) {
+    h.update_string(option);
+  }
+  return h.hex_digest();
+}
+
+dxc_wrapper::result job_compiler::compile(const compile_job &job) {
+  std::unique_ptr<dxc_wrapper> &dxcompiler =
+      compilers_[std::make_pair(job.shader_model, job.dxc_options)];
+  if (!dxcompiler) {
+    dxcompiler = std::make_unique<dxc_wrapper>(job.shader_model,
+                                               job.dxc_options, exe_dir_);
+  }
+  return dxcompiler->compile_hlsl2spv(job.preprocessed_source.c_str(),
+                                      job.preprocessed_source.size(),
+                                      job.source_name.c_str(),
+                                      job.entry_point,
+                                      job.defines);
+}
+
+std::string serialize_compile_result(const dxc_wrapper::result &res) {
+  wire_writer w;
+  w.write_field(PROTOCOL_VERSION);
+  w.write_field((uint32_t)res.spirv_code.size());
+  for (uint32_t word : res.spirv_code) w.write_field(word);
+  w.write_string(res.diag_message);
+  return w.data();
+}
+
+bool deserialize_compile_result(const std::string &data,
+                                dxc_wrapper::result &res) {
+  wire_reader r(data);
+  uint32_t version = 0u, nwords = 0u;
+  if (!r.read_field(version) || version != PROTOCOL_VERSION) return false;
+  r.read_field(nwords);
+  if (!r.ok() || nwords > data.size() / sizeof(uint32_t)) return false;
+  res.spirv_code.resize(nwords);
+  for (uint32_t i = 0u; i < nwords; ++i) r.read_field(res.spirv_code[i]);
+  r.read_string(res.diag_message);
+  return r.ok();
+}
+
+void run_compile_worker(const std::string &host_port,
+                        const std::string &exe_dir) {
+  tcp_socket listener = tcp_socket::listen_on(host_port);
+  if (!listener.is_valid()) {
+    fprintf(stderr, "Failed to listen on %s\n", host_port.c_str());
+    exit(1);
+  }
+  fprintf(stderr, "Worker listening on %s\n", host_port.c_str());
+  for (;;) {
+    tcp_socket connection = listener.accept_connection();
+    if (!connection.is_valid()) continue;
+    std::thread(serve_connection, std::move(connection), exe_dir).detach();
+  }
+}
+
+std::vector<dxc_wrapper::result> compile_remotely(
+    const std::vector<compile_job> &jobs,
+    const std::vector<std::string> &worker_addresses,
+    uint32_t timeout_ms,
+    dxc_wrapper &local_compiler) {
+  std::vector<dxc_wrapper::result> results(jobs.size());
+  std::deque<size_t> pending_jobs;
+  for (size_t j = 0u; j < jobs.size(); ++j) pending_jobs.push_back(j);
+  size_t unfinished_jobs = jobs.size();
+  std::mutex pending_jobs_mutex;
+  std::condition_variable pending_jobs_cv;
+
+  // Each worker connection is served by a separate thread, which pulls jobs
+  // off the shared queue. If a connection breaks or times out, the job is put
+  // back into the queue for the remaining workers to pick up, so threads with
+  // working connections keep waiting until every job is finished.
+  auto worker_proc = [&](const std::string &address) {
+    tcp_socket connection = tcp_socket::connect_to(address);
+    if (!connection.is_valid() || !connection.set_timeout(timeout_ms)) {
+      fprintf(stderr, "Failed to connect to worker %s\n", address.c_str());
+      return;
+    }
+    for (;;) {
+      size_t job_idx;
+      {
+        std::unique_lock<std::mutex> lock(pending_jobs_mutex);
+        pending_jobs_cv.wait(lock, [&] {
+          return !pending_jobs.empty() || unfinished_jobs == 0u;
+        });
+        if (unfinished_jobs == 0u) return;
+        job_idx = pending_jobs.front();
+        pending_jobs.pop_front();
+      }
+      std::string response;
+      const bool ok = connection.send_frame(jobs[job_idx].serialize()) &&
+                      connection.recv_frame(response) &&
+                      deserialize_compile_result(response, results[job_idx]);
+      {
+        std::lock_guard<std::mutex> lock(pending_jobs_mutex);
+        if (ok) {
+          --unfinished_jobs;
+        } else {
+          pending_jobs.push_back(job_idx);
+        }
+      }
+      pending_jobs_cv.notify_all();
+      if (!ok) {
+        fprintf(stderr, "Lost connection to worker %s\n", address.c_str());
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (const std::string &address : worker_addresses) {
+    threads.emplace_back(worker_proc, address);
+  }
+  for (std::thread &t : threads) t.join();
+
+  if (!pending_jobs.empty()) {
+    fprintf(stderr, "No workers left, compiling the remaining %zu jobs "
+                    "locally\n", pending_jobs.size());
+  }
+  for (size_t job_idx : pending_jobs) {
+    const compile_job &job = jobs[job_idx];
+    results[job_idx] =
+        local_compiler.compile_hlsl2spv(job.preprocessed_source.c_str(),
+                                        job.preprocessed_source.size(),
+                                        job.source_name.c_str(),
+                                        job.entry_point,
+                                        job.defines);
+  }
+  return results;
+}
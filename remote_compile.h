@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "dxc_wrapper.h"
+#include "shader_defines.h"
+#include "technique_parser.h"
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Everything a worker needs in order to produce SPIR-V for a single entry
+// point, independently of the coordinator's file system.
+struct compile_job {
+  std::string source_name; // Used for diagnostics only.
+  std::string preprocessed_source;
+  technique::entry_point entry_point;
+  define_container defines;
+  std::string shader_model;
+  std::vector<std::string> dxc_options;
+
+  std::string serialize() const;
+  bool deserialize(const std::string &data);
+
+  // Returns a key identifying the job's result in an artifact cache.
+  std::string cache_key() const;
+};
+
+// Compiles jobs locally, keeping a compiler instance around for each
+// combination of shader model and options encountered so far.
+class job_compiler {
+public:
+  explicit job_compiler(const std::string &exe_dir) : exe_dir_(exe_dir) {}
+
+  dxc_wrapper::result compile(const compile_job &job);
+
+private:
+  std::string exe_dir_;
+  std::map<std::pair<std::string, std::vector<std::string>>,
+           std::unique_ptr<dxc_wrapper>> compilers_;
+};
+
+// Serialization of DXC compilation results.
+std::string serialize_compile_result(const dxc_wrapper::result &r);
+bool deserialize_compile_result(const std::string &data,
+                                dxc_wrapper::result &r);
+
+// Runs a worker process that accepts connections on the given `host:port'
+// address and compiles the jobs it receives. Never returns.
+[[noreturn]] void run_compile_worker(const std::string &host_port,
+                                     const std::string &exe_dir);
+
+// Distributes the given jobs among remote workers and returns the results,
+// in the same order as the jobs. A worker that doesn't respond within the
+// given time is treated as lost. Jobs that no worker is left to process are
+// compiled with `local_compiler', which must have been created with the same
+// shader model and options as the jobs.
+std::vector<dxc_wrapper::result> compile_remotely(
+    const std::vector<compile_job> &jobs,
+    const std::vector<std::string> &worker_addresses,
+    uint32_t timeout_ms,
+    dxc_wrapper &local_compiler);
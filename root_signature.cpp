@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "root_signature.h"
+#include "build_error.h"
+
+#include <stdio.h>
+
+namespace {
+
+// Returns true if all usages of a storage buffer only read from it, in which
+// case it can be accessed through an SRV.
+bool is_read_only_buffer(const descriptor &d) {
+  for (const auto &usage : d.usages) {
+    if (!usage.first->get_buffer_block_flags(usage.second)
+             .get(spv::DecorationNonWritable)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}
+
+root_signature::root_signature(const pipeline_layout &layout) {
+  for (uint32_t set = 0u; set < layout.set_count(); ++set) {
+    root_table views { set, false, {} }, samplers { set, true, {} };
+    for (const auto &binding_and_descriptor : layout.set(set)) {
+      const descriptor &d = binding_and_descriptor.second;
+      switch (d.type) {
+      case descriptor_type::UNIFORM_BUFFER:
+        views.ranges.push_back(root_range { root_range_type::CBV, d.slot });
+        break;
+      case descriptor_type::STORAGE_BUFFER:
+        views.ranges.push_back(root_range {
+          is_read_only_buffer(d) ? root_range_type::SRV : root_range_type::UAV,
+          d.slot
+        });
+        break;
+      case descriptor_type::LOADSTORE_IMAGE:
+        views.ranges.push_back(root_range { root_range_type::UAV, d.slot });
+        break;
+      case descriptor_type::TEXTURE:
+        views.ranges.push_back(root_range { root_range_type::SRV, d.slot });
+        break;
+      case descriptor_type::SAMPLER:
+        samplers.ranges.push_back(
+            root_range { root_range_type::SAMPLER, d.slot });
+        break;
+      default:
+        fprintf(stderr, "Descriptor %s (set %u, binding %u) can't be "
+                        "expressed in a D3D12 root signature\n",
+                d.name.c_str(), set, d.slot);
+        abort_build();
+      }
+    }
+    if (!views.ranges.empty()) tables_.emplace_back(std::move(views));
+    if (!samplers.ranges.empty()) tables_.emplace_back(std::move(samplers));
+  }
+}
+
+std::string root_signature::hlsl() const {
+  std::string result = "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT)";
+  for (const root_table &table : tables_) {
+    result += ", DescriptorTable(";
+    for (size_t r = 0u; r < table.ranges.size(); ++r) {
+      const root_range &range = table.ranges[r];
+      const char *type = "", *register_prefix = "";
+      switch (range.type) {
+      case root_range_type::SRV: type = "SRV"; register_prefix = "t"; break;
+      case root_range_type::UAV: type = "UAV"; register_prefix = "u"; break;
+      case root_range_type::CBV: type = "CBV"; register_prefix = "b"; break;
+      case root_range_type::SAMPLER:
+        type = "Sampler"; register_prefix = "s"; break;
+      }
+      if (r > 0u) result += ", ";
+      result += std::string(type) + "(" + register_prefix +
+                std::to_string(range.shader_register) + ", space = " +
+                std::to_string(table.register_space) + ")";
+    }
+    result += ")";
+  }
+  return result;
+}
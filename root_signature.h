@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "pipeline_layout.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Types of D3D12 descriptor ranges. The values match D3D12_DESCRIPTOR_RANGE_TYPE.
+enum class root_range_type {
+  SRV = NGF_PLMD_ROOT_RANGE_SRV,
+  UAV = NGF_PLMD_ROOT_RANGE_UAV,
+  CBV = NGF_PLMD_ROOT_RANGE_CBV,
+  SAMPLER = NGF_PLMD_ROOT_RANGE_SAMPLER
+};
+
+// A single-descriptor range within a descriptor table.
+struct root_range {
+  root_range_type type;
+  uint32_t shader_register; // Equal to the descriptor's binding.
+};
+
+// A descriptor table. Its ranges are laid out in the order they're listed.
+struct root_table {
+  uint32_t register_space; // Equal to the descriptor set.
+  bool samplers; // D3D12 keeps samplers in separate tables.
+  std::vector<root_range> ranges;
+};
+
+// D3D12 root signature derived from a pipeline layout. Each descriptor set
+// maps to a register space, with registers equal to the bindings, and becomes
+// at most two descriptor tables: one for CBVs, SRVs and UAVs, and one for
+// samplers.
+class root_signature {
+public:
+  explicit root_signature(const pipeline_layout &layout);
+
+  const std::vector<root_table>& tables() const { return tables_; }
+
+  // Returns the root signature in HLSL syntax, as accepted by DXC's
+  // `-rootsig-define' option.
+  std::string hlsl() const;
+
+private:
+  std::vector<root_table> tables_;
+};
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Loads the given pipeline metadata files as one batch, and prints the
+// outcome for each of them.
+
+#include "metadata_parser/batch_loader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, const char *argv[]) {
+  ngf_plbl_options options = { 0u, 0u, 0, 0 };
+  int first_path = 1;
+  for (; first_path < argc && argv[first_path][0] == '-'; ++first_path) {
+    if (strcmp(argv[first_path], "--threads") == 0) {
+      options.force_thread_pool = 1;
+    } else if (strcmp(argv[first_path], "--trusted") == 0) {
+      options.trusted = 1;
+    } else {
+      break;
+    }
+  }
+  if (first_path >= argc) {
+    printf("Usage: batch_load_metadata [--threads] [--trusted] "
+           "<pipeline metadata file> ...\n");
+    exit(0);
+  }
+  ngf_plbl_batch *batch;
+  ngf_plbl_error err = ngf_plbl_load(&argv[first_path],
+                                     (uint32_t)(argc - first_path),
+                                     &options, &batch);
+  if (err != NGF_PLBL_ERROR_OK) {
+    fprintf(stderr, "Error loading batch: %d\n", err);
+    exit(1);
+  }
+  printf("backend: %s\n",
+         ngf_plbl_get_io_backend(batch) == NGF_PLBL_IO_BACKEND_IO_URING
+             ? "io_uring" : "thread_pool");
+  ngf_plmd *const *metadata = ngf_plbl_get_metadata(batch);
+  const ngf_plbl_file_status *status = ngf_plbl_get_status(batch);
+  int nfailed = 0;
+  for (uint32_t i = 0u; i < ngf_plbl_get_count(batch); ++i) {
+    const char *path = argv[first_path + (int)i];
+    if (status[i].io_error != 0) {
+      printf("%s: I/O error %d\n", path, status[i].io_error);
+      ++nfailed;
+    } else if (metadata[i] == NULL) {
+      printf("%s: parse error %d\n", path, status[i].parse_error);
+      ++nfailed;
+    } else {
+      const ngf_plmd_entrypoints *ep = ngf_plmd_get_entrypoints(metadata[i]);
+      printf("%s: ok (%s, %s)\n", path,
+             ep->vert_shader_entrypoint ? ep->vert_shader_entrypoint : "-",
+             ep->frag_shader_entrypoint ? ep->frag_shader_entrypoint : "-");
+    }
+  }
+  ngf_plbl_destroy(batch);
+  return nfailed == 0 ? 0 : 1;
+}
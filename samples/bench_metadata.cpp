@@ -0,0 +1,355 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Measures the performance of the pipeline metadata loader on synthetic
+// .pipeline files of various shapes, and prints the results as JSON.
+
+#include "file_utils.h"
+#include "metadata_parser/metadata_parser.h"
+#include "pipeline_metadata_file.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Describes the contents of a synthetic metadata file.
+struct bench_shape {
+  const char *name;
+  uint32_t nsets;
+  uint32_t ndescriptors_per_set;
+  uint32_t ncis_entries; // Entries in each of the two CIS maps.
+  uint32_t ncombined_ids_per_entry;
+  uint32_t nuser_entries;
+};
+
+static const bench_shape SHAPES[] = {
+  { "typical",           2u,    4u,   4u, 1u,    4u },
+  { "many_sets",        64u,    4u,   4u, 1u,    4u },
+  { "many_descriptors",  1u, 1024u,   4u, 1u,    4u },
+  { "big_cis_maps",      2u,    4u, 512u, 8u,    4u },
+  { "many_user_entries", 2u,    4u,   4u, 1u, 1024u },
+};
+
+// Caches are evicted by streaming through a buffer larger than any last
+// level cache the benchmark is likely to run on.
+static const size_t EVICTION_BUFFER_SIZE = 64u * 1024u * 1024u;
+
+static std::string generate(const bench_shape &s) {
+  pipeline_metadata_file f;
+  f.start_new_record(); // entrypoints
+  f.write_field(2u);
+  f.write_field(0u);
+  f.write_raw_bytes("VSMain", 7u);
+  f.write_field(1u);
+  f.write_raw_bytes("PSMain", 7u);
+  f.start_new_record(); // pipeline layout
+  f.write_field(s.nsets);
+  for (uint32_t set = 0u; set < s.nsets; ++set) {
+    f.write_field(s.ndescriptors_per_set);
+    for (uint32_t d = 0u; d < s.ndescriptors_per_set; ++d) {
+      f.write_field(d);
+      f.write_field(d % 6u);
+      f.write_field(3u);
+    }
+  }
+  for (uint32_t map = 0u; map < 2u; ++map) {
+    f.start_new_record(); // image and sampler to CIS maps
+    f.write_field(s.ncis_entries);
+    for (uint32_t e = 0u; e < s.ncis_entries; ++e) {
+      f.write_field(e % s.nsets);
+      f.write_field(e);
+      f.write_field(s.ncombined_ids_per_entry);
+      for (uint32_t c = 0u; c < s.ncombined_ids_per_entry; ++c) {
+        f.write_field(e * s.ncombined_ids_per_entry + c);
+      }
+    }
+  }
+  f.start_new_record(); // user metadata
+  f.write_field(s.nuser_entries);
+  for (uint32_t e = 0u; e < s.nuser_entries; ++e) {
+    const std::string key = "key_" + std::to_string(e);
+    const std::string value = "value_" + std::to_string(e);
+    f.write_raw_bytes(key.c_str(), key.size() + 1u);
+    f.write_raw_bytes(value.c_str(), value.size() + 1u);
+  }
+  for (uint32_t r = 0u; r < 5u; ++r) {
+    // aliases, objects, uniform buffer layouts, root signature, subgroup
+    // features.
+    f.start_new_record();
+    f.write_field(0u);
+  }
+  f.write_field(0u); // subgroup feature stage mask.
+  f.start_new_record(); // draw parameters
+  f.write_field(0u);
+  f.start_new_record(); // binding fixups
+  f.write_field(0u);
+  f.start_new_record(); // fragment properties
+  f.write_field(0u);
+  f.start_new_record(); // sampling usage
+  f.write_field(0u);
+  f.start_new_record(); // compile tier
+  f.write_field(0u);
+  f.start_new_record(); // instrumentation
+  f.write_field(0u);
+  f.write_field(0u);
+  f.write_field(0u);
+  f.finalize();
+  return f.contents();
+}
+
+// Allocator that counts what the loader asks for.
+static uint64_t nallocations = 0u;
+static uint64_t nbytes_allocated = 0u;
+static void* counting_alloc(size_t size) {
+  ++nallocations;
+  nbytes_allocated += size;
+  return malloc(size);
+}
+static const ngf_plmd_alloc_callbacks counting_alloc_cb = {
+  counting_alloc, free
+};
+
+static std::vector<uint8_t> eviction_buffer;
+static volatile uint8_t eviction_sink;
+static void evict_caches() {
+  uint8_t acc = 0u;
+  for (size_t i = 0u; i < eviction_buffer.size(); i += 64u) {
+    eviction_buffer[i] += 1u;
+    acc ^= eviction_buffer[i];
+  }
+  eviction_sink = acc;
+}
+
+using bench_clock = std::chrono::steady_clock;
+
+static double ns_since(bench_clock::time_point start) {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      bench_clock::now() - start).count();
+}
+
+typedef ngf_plmd_error (*load_fn)(const void*, size_t,
+                                  const ngf_plmd_alloc_callbacks*,
+                                  ngf_plmd**);
+
+static ngf_plmd* load_or_die(load_fn load, const std::string &data) {
+  ngf_plmd *m = nullptr;
+  if (load(data.data(), data.size(), &counting_alloc_cb, &m) !=
+      NGF_PLMD_ERROR_OK) {
+    fprintf(stderr, "Failed to load generated metadata\n");
+    exit(1);
+  }
+  return m;
+}
+
+// Average time, in nanoseconds, to load and to destroy the given metadata.
+// With `cold' set, caches are evicted before every iteration, and the time
+// spent doing so isn't counted.
+struct load_timing {
+  double load_ns = 0.0;
+  double destroy_ns = 0.0;
+};
+static load_timing time_load(load_fn load, const std::string &data,
+                             uint32_t iterations, bool cold) {
+  load_timing t;
+  for (uint32_t i = 0u; i < iterations; ++i) {
+    if (cold) evict_caches();
+    const bench_clock::time_point load_start = bench_clock::now();
+    ngf_plmd *m = load_or_die(load, data);
+    t.load_ns += ns_since(load_start);
+    const bench_clock::time_point destroy_start = bench_clock::now();
+    ngf_plmd_destroy(m, &counting_alloc_cb);
+    t.destroy_ns += ns_since(destroy_start);
+  }
+  t.load_ns /= iterations;
+  t.destroy_ns /= iterations;
+  return t;
+}
+
+// Lookups an application typically performs on loaded metadata. The API
+// only exposes arrays, so these are linear scans.
+static const ngf_plmd_descriptor* find_descriptor(const ngf_plmd *m,
+                                                  uint32_t set,
+                                                  uint32_t binding) {
+  const ngf_plmd_layout *layout = ngf_plmd_get_layout(m);
+  if (set >= layout->ndescriptor_sets) return nullptr;
+  const ngf_plmd_descriptor_set_layout *s = layout->set_layouts[set];
+  for (uint32_t d = 0u; d < s->ndescriptors; ++d) {
+    if (s->descriptors[d].binding == binding) return &s->descriptors[d];
+  }
+  return nullptr;
+}
+
+static const ngf_plmd_cis_map_entry* find_cis_entry(const ngf_plmd *m,
+                                                    uint32_t set,
+                                                    uint32_t binding) {
+  const ngf_plmd_cis_map *map = ngf_plmd_get_image_to_cis_map(m);
+  for (uint32_t e = 0u; e < map->nentries; ++e) {
+    if (map->entries[e]->separate_set_id == set &&
+        map->entries[e]->separate_binding_id == binding) {
+      return map->entries[e];
+    }
+  }
+  return nullptr;
+}
+
+static const char* find_user_value(const ngf_plmd *m, const char *key) {
+  const ngf_plmd_user *user = ngf_plmd_get_user(m);
+  for (uint32_t e = 0u; e < user->nentries; ++e) {
+    if (strcmp(user->entries[e].key, key) == 0) {
+      return user->entries[e].value;
+    }
+  }
+  return nullptr;
+}
+
+// Average time, in nanoseconds, of a lookup for each of the keys, which are
+// spread evenly over the contents of the metadata.
+template <class F>
+static double time_lookups(uint32_t iterations, uint32_t nkeys, F &&lookup) {
+  uint32_t nfound = 0u;
+  const bench_clock::time_point start = bench_clock::now();
+  for (uint32_t i = 0u; i < iterations; ++i) {
+    for (uint32_t k = 0u; k < nkeys; ++k) nfound += lookup(k) ? 1u : 0u;
+  }
+  const double ns = ns_since(start);
+  if (nfound != iterations * nkeys) {
+    fprintf(stderr, "Lookup failed\n");
+    exit(1);
+  }
+  return ns / ((double)iterations * nkeys);
+}
+
+static const char *USAGE =
+    "Usage: bench_metadata [--iterations <n>] [--output <file>] "
+    "[--write-files <dir>]\n";
+
+int main(int argc, const char *argv[]) {
+  uint32_t iterations = 1000u;
+  const char *output_path = nullptr;
+  const char *files_dir = nullptr;
+  for (int a = 1; a < argc; ++a) {
+    if (strcmp(argv[a], "--iterations") == 0 && a + 1 < argc) {
+      iterations = (uint32_t)strtoul(argv[++a], nullptr, 10);
+    } else if (strcmp(argv[a], "--output") == 0 && a + 1 < argc) {
+      output_path = argv[++a];
+    } else if (strcmp(argv[a], "--write-files") == 0 && a + 1 < argc) {
+      files_dir = argv[++a];
+    } else {
+      fprintf(stderr, "%s", USAGE);
+      exit(1);
+    }
+  }
+  if (iterations == 0u) {
+    fprintf(stderr, "%s", USAGE);
+    exit(1);
+  }
+  // Cold iterations are much slower due to the eviction, so fewer are run.
+  const uint32_t cold_iterations = iterations / 10u > 0u ? iterations / 10u : 1u;
+  eviction_buffer.resize(EVICTION_BUFFER_SIZE);
+
+  std::string json = "{\n  \"iterations\": " + std::to_string(iterations) +
+                     ",\n  \"cold_iterations\": " +
+                     std::to_string(cold_iterations) +
+                     ",\n  \"shapes\": [\n";
+  const size_t nshapes = sizeof(SHAPES) / sizeof(SHAPES[0]);
+  for (size_t s = 0u; s < nshapes; ++s) {
+    const bench_shape &shape = SHAPES[s];
+    const std::string data = generate(shape);
+    if (files_dir != nullptr) {
+      write_file((std::string(files_dir) + PATH_SEPARATOR + shape.name +
+                  ".pipeline").c_str(), data);
+    }
+
+    nallocations = nbytes_allocated = 0u;
+    ngf_plmd_destroy(load_or_die(ngf_plmd_load, data), &counting_alloc_cb);
+    const uint64_t allocations_per_load = nallocations;
+    const uint64_t bytes_per_load = nbytes_allocated;
+
+    const load_timing warm = time_load(ngf_plmd_load, data, iterations, false);
+    const load_timing cold =
+        time_load(ngf_plmd_load, data, cold_iterations, true);
+    const load_timing warm_trusted =
+        time_load(ngf_plmd_load_trusted, data, iterations, false);
+    const load_timing cold_trusted =
+        time_load(ngf_plmd_load_trusted, data, cold_iterations, true);
+
+    ngf_plmd *m = load_or_die(ngf_plmd_load, data);
+    const uint32_t ndescriptors = shape.nsets * shape.ndescriptors_per_set;
+    const double descriptor_lookup_ns =
+        time_lookups(iterations, ndescriptors, [&](uint32_t k) {
+          return find_descriptor(m, k / shape.ndescriptors_per_set,
+                                 k % shape.ndescriptors_per_set) != nullptr;
+        });
+    const double cis_lookup_ns =
+        time_lookups(iterations, shape.ncis_entries, [&](uint32_t k) {
+          return find_cis_entry(m, k % shape.nsets, k) != nullptr;
+        });
+    std::vector<std::string> keys;
+    for (uint32_t e = 0u; e < shape.nuser_entries; ++e) {
+      keys.push_back("key_" + std::to_string(e));
+    }
+    const double user_lookup_ns =
+        time_lookups(iterations, shape.nuser_entries, [&](uint32_t k) {
+          return find_user_value(m, keys[k].c_str()) != nullptr;
+        });
+    ngf_plmd_destroy(m, &counting_alloc_cb);
+
+    const double mb_per_s = (double)data.size() / warm.load_ns * 1e3;
+    char buf[2048];
+    snprintf(buf, sizeof(buf),
+        "    {\n"
+        "      \"name\": \"%s\",\n"
+        "      \"file_size\": %zu,\n"
+        "      \"sets\": %u,\n"
+        "      \"descriptors\": %u,\n"
+        "      \"cis_entries\": %u,\n"
+        "      \"user_entries\": %u,\n"
+        "      \"allocations_per_load\": %llu,\n"
+        "      \"bytes_allocated_per_load\": %llu,\n"
+        "      \"load\": { \"warm_ns\": %.1f, \"cold_ns\": %.1f, "
+        "\"warm_mb_per_s\": %.1f },\n"
+        "      \"load_trusted\": { \"warm_ns\": %.1f, \"cold_ns\": %.1f },\n"
+        "      \"destroy\": { \"warm_ns\": %.1f, \"cold_ns\": %.1f },\n"
+        "      \"lookup_ns\": { \"descriptor\": %.1f, \"cis_entry\": %.1f, "
+        "\"user_entry\": %.1f }\n"
+        "    }%s\n",
+        shape.name, data.size(), shape.nsets, ndescriptors, shape.ncis_entries,
+        shape.nuser_entries, (unsigned long long)allocations_per_load,
+        (unsigned long long)bytes_per_load, warm.load_ns, cold.load_ns,
+        mb_per_s, warm_trusted.load_ns, cold_trusted.load_ns,
+        warm.destroy_ns, cold.destroy_ns, descriptor_lookup_ns, cis_lookup_ns,
+        user_lookup_ns, s + 1u < nshapes ? "," : "");
+    json += buf;
+  }
+  json += "  ]\n}\n";
+
+  if (output_path != nullptr) {
+    write_file(output_path, json);
+  } else {
+    fputs(json.c_str(), stdout);
+  }
+  return 0;
+}
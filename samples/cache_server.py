@@ -0,0 +1,68 @@
+"""
+A tiny reference implementation of the remote artifact cache protocol used by
+nicegraf_shaderc's --cache-url option.
+
+  GET /<prefix>/<key>  - responds with the artifact (200) or 404.
+  PUT /<prefix>/<key>  - stores the request body as the artifact.
+
+Usage: python3 cache_server.py <port> <storage folder>
+"""
+import http.server, os, pathlib, re, sys, tempfile
+
+KEY_PATTERN = re.compile(r'^[0-9a-f]{64}$')
+
+class CacheRequestHandler(http.server.BaseHTTPRequestHandler):
+  protocol_version = 'HTTP/1.0'
+  storage = None
+
+  def artifact_path(self):
+    key = self.path.rstrip('/').rsplit('/', 1)[-1]
+    if not KEY_PATTERN.match(key):
+      return None
+    return self.storage / key[0:2] / key
+
+  def do_GET(self):
+    path = self.artifact_path()
+    if path is None or not path.is_file():
+      self.send_response(404)
+      self.send_header('Content-Length', '0')
+      self.end_headers()
+      return
+    data = path.read_bytes()
+    self.send_response(200)
+    self.send_header('Content-Length', str(len(data)))
+    self.end_headers()
+    self.wfile.write(data)
+
+  def do_PUT(self):
+    path = self.artifact_path()
+    length = int(self.headers.get('Content-Length', '0'))
+    data = self.rfile.read(length)
+    if path is None:
+      self.send_response(400)
+    else:
+      path.parent.mkdir(parents = True, exist_ok = True)
+      # Write to a temporary file first so that concurrent readers never see
+      # partial artifacts.
+      fd, tmp_name = tempfile.mkstemp(dir = str(path.parent))
+      with os.fdopen(fd, 'wb') as tmp:
+        tmp.write(data)
+      os.replace(tmp_name, str(path))
+      self.send_response(201)
+    self.send_header('Content-Length', '0')
+    self.end_headers()
+
+  def log_message(self, format, *args):
+    pass
+
+def main(argv):
+  if len(argv) != 3:
+    print(__doc__)
+    sys.exit(1)
+  CacheRequestHandler.storage = pathlib.Path(argv[2])
+  CacheRequestHandler.storage.mkdir(parents = True, exist_ok = True)
+  server = http.server.ThreadingHTTPServer(('', int(argv[1])), CacheRequestHandler)
+  server.serve_forever()
+
+if __name__ == "__main__":
+  main(sys.argv)
@@ -67,7 +67,27 @@ int main(int argc, const char *argv[]) {
          header->image_to_cis_map_offset);
   printf("  \"sampler_to_cis_map_offset\": %d,\n",
          header->sampler_to_cis_map_offset);
-  printf("  \"user_metadata_offset\": %d\n},\n", header->user_metadata_offset);
+  printf("  \"user_metadata_offset\": %d,\n", header->user_metadata_offset);
+  printf("  \"aliases_offset\": %d,\n", header->aliases_offset);
+  printf("  \"objects_offset\": %d,\n", header->objects_offset);
+  printf("  \"uniform_buffer_layouts_offset\": %d,\n",
+         header->uniform_buffer_layouts_offset);
+  printf("  \"root_signature_offset\": %d,\n",
+         header->root_signature_offset);
+  printf("  \"subgroup_features_offset\": %d,\n",
+         header->subgroup_features_offset);
+  printf("  \"draw_parameters_offset\": %d,\n",
+         header->draw_parameters_offset);
+  printf("  \"binding_fixups_offset\": %d,\n",
+         header->binding_fixups_offset);
+  printf("  \"fragment_properties_offset\": %d,\n",
+         header->fragment_properties_offset);
+  printf("  \"sampling_usage_offset\": %d,\n",
+         header->sampling_usage_offset);
+  printf("  \"compile_tier_offset\": %d,\n",
+         header->compile_tier_offset);
+  printf("  \"instrumentation_offset\": %d\n},\n",
+         header->instrumentation_offset);
   printf("\"entrypoints\": { \n");
   const ngf_plmd_entrypoints *eps = ngf_plmd_get_entrypoints(m);
   printf("  \"vertex\": \"%s\",\n", eps->vert_shader_entrypoint);
@@ -113,7 +133,121 @@ int main(int argc, const char *argv[]) {
     if (e != user->nentries - 1) printf(",");
     printf("\n");
   }
-  printf("}\n}\n");
+  printf("},\n");
+
+  printf("\"aliases\": {\n");
+  const ngf_plmd_aliases *aliases = ngf_plmd_get_aliases(m);
+  for (uint32_t e = 0u; e < aliases->nentries; ++e) {
+    printf("  \"%s\": \"%s\"", aliases->entries[e].alias,
+           aliases->entries[e].target);
+    if (e != aliases->nentries - 1) printf(",");
+    printf("\n");
+  }
+  printf("},\n");
+
+  printf("\"objects\": [\n");
+  const ngf_plmd_objects *objects = ngf_plmd_get_objects(m);
+  for (uint32_t e = 0u; e < objects->nentries; ++e) {
+    printf("  { \"stage\": %d, \"name\": \"%s\", \"hash\": \"%s\" }",
+           objects->entries[e].stage, objects->entries[e].name,
+           objects->entries[e].hash);
+    if (e != objects->nentries - 1) printf(",");
+    printf("\n");
+  }
+  printf("],\n");
+
+  printf("\"uniform_buffer_layouts\": [\n");
+  const ngf_plmd_uniform_buffer_layouts *ubls =
+      ngf_plmd_get_uniform_buffer_layouts(m);
+  for (uint32_t b = 0u; b < ubls->nbuffers; ++b) {
+    const ngf_plmd_uniform_buffer_layout *ubl = &ubls->buffers[b];
+    printf("  {\n");
+    printf("    \"name\": \"%s\",\n", ubl->name);
+    printf("    \"set\": %d,\n", ubl->set);
+    printf("    \"binding\": %d,\n", ubl->binding);
+    printf("    \"size\": %d,\n", ubl->size);
+    printf("    \"members\": [\n");
+    for (uint32_t mi = 0u; mi < ubl->nmembers; ++mi) {
+      printf("      { \"name\": \"%s\", \"offset\": %d, \"size\": %d }",
+             ubl->members[mi].name, ubl->members[mi].offset,
+             ubl->members[mi].size);
+      if (mi != ubl->nmembers - 1) printf(",");
+      printf("\n");
+    }
+    printf("    ]\n");
+    printf("  }");
+    if (b != ubls->nbuffers - 1) printf(",");
+    printf("\n");
+  }
+  printf("],\n");
+
+  printf("\"root_signature\": [\n");
+  const ngf_plmd_root_signature *root_sig = ngf_plmd_get_root_signature(m);
+  for (uint32_t t = 0u; t < root_sig->ntables; ++t) {
+    const ngf_plmd_root_table *table = &root_sig->tables[t];
+    printf("  {\n");
+    printf("    \"register_space\": %d,\n", table->register_space);
+    printf("    \"is_sampler_table\": %d,\n", table->is_sampler_table);
+    printf("    \"ranges\": [\n");
+    for (uint32_t r = 0u; r < table->nranges; ++r) {
+      printf("      { \"range_type\": %d, \"shader_register\": %d }",
+             table->ranges[r].range_type, table->ranges[r].shader_register);
+      if (r != table->nranges - 1) printf(",");
+      printf("\n");
+    }
+    printf("    ]\n");
+    printf("  }");
+    if (t != root_sig->ntables - 1) printf(",");
+    printf("\n");
+  }
+  printf("],\n");
+
+  const ngf_plmd_subgroup_features *subgroup_features =
+      ngf_plmd_get_subgroup_features(m);
+  printf("\"subgroup_features\": {\n");
+  printf("  \"features\": %d,\n", subgroup_features->features);
+  printf("  \"stage_vis\": %d\n", subgroup_features->stage_visibility_mask);
+  printf("},\n");
+
+  const ngf_plmd_draw_parameters *draw_parameters =
+      ngf_plmd_get_draw_parameters(m);
+  printf("\"draw_parameters\": %d,\n", draw_parameters->used);
+
+  printf("\"binding_fixups\": [\n");
+  const ngf_plmd_binding_fixups *fixups = ngf_plmd_get_binding_fixups(m);
+  for (uint32_t e = 0u; e < fixups->nentries; ++e) {
+    printf("  { \"type\": %d, \"native_binding\": %d, \"name\": \"%s\" }",
+           fixups->entries[e].type, fixups->entries[e].native_binding,
+           fixups->entries[e].name);
+    if (e != fixups->nentries - 1) printf(",");
+    printf("\n");
+  }
+  printf("],\n");
+
+  const ngf_plmd_fragment_properties *fragment_properties =
+      ngf_plmd_get_fragment_properties(m);
+  printf("\"fragment_properties\": %d,\n", fragment_properties->flags);
+
+  printf("\"sampling_usage\": [\n");
+  const ngf_plmd_sampling_usage *sampling_usage =
+      ngf_plmd_get_sampling_usage(m);
+  for (uint32_t e = 0u; e < sampling_usage->nentries; ++e) {
+    printf("  { \"set\": %d, \"binding\": %d, \"flags\": %d }",
+           sampling_usage->entries[e].set, sampling_usage->entries[e].binding,
+           sampling_usage->entries[e].flags);
+    if (e != sampling_usage->nentries - 1) printf(",");
+    printf("\n");
+  }
+  printf("],\n");
+
+  printf("\"compile_tier\": %d,\n", ngf_plmd_get_compile_tier(m)->tier);
+
+  const ngf_plmd_instrumentation *instrumentation =
+      ngf_plmd_get_instrumentation(m);
+  printf("\"instrumentation\": {\"ncounters\": %d, \"set\": %d, "
+         "\"binding\": %d}\n", instrumentation->ncounters,
+         instrumentation->set, instrumentation->binding);
+  printf("}\n");
   ngf_plmd_destroy(m, NULL);
   return 0;
 }
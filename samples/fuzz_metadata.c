@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Feeds mutated pipeline metadata into ngf_plmd_load. Built with libFuzzer
+// (NGF_PLMD_LIBFUZZER), it is a regular fuzz target. Otherwise, it takes a
+// list of well-formed .pipeline files and runs a fixed number of random
+// mutations of each through the loader, which is enough to catch regressions
+// when run under a sanitizer.
+
+#include "metadata_parser/metadata_parser.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  ngf_plmd *m = NULL;
+  if (ngf_plmd_load(data, size, NULL, &m) == NGF_PLMD_ERROR_OK) {
+    // Touch everything the loader hands out, so that a bad pointer shows up
+    // here rather than in the application.
+    const ngf_plmd_entrypoints *ep = ngf_plmd_get_entrypoints(m);
+    size_t n = 0u;
+    if (ep->vert_shader_entrypoint) n += strlen(ep->vert_shader_entrypoint);
+    if (ep->frag_shader_entrypoint) n += strlen(ep->frag_shader_entrypoint);
+    const ngf_plmd_layout *layout = ngf_plmd_get_layout(m);
+    for (uint32_t s = 0u; s < layout->ndescriptor_sets; ++s) {
+      const ngf_plmd_descriptor_set_layout *set = layout->set_layouts[s];
+      for (uint32_t d = 0u; d < set->ndescriptors; ++d) {
+        n += set->descriptors[d].binding;
+      }
+    }
+    const ngf_plmd_cis_map *maps[] = {
+      ngf_plmd_get_image_to_cis_map(m), ngf_plmd_get_sampler_to_cis_map(m)
+    };
+    for (size_t i = 0u; i < 2u; ++i) {
+      for (uint32_t e = 0u; e < maps[i]->nentries; ++e) {
+        const ngf_plmd_cis_map_entry *entry = maps[i]->entries[e];
+        for (uint32_t c = 0u; c < entry->ncombined_ids; ++c) {
+          n += entry->combined_ids[c];
+        }
+      }
+    }
+    const ngf_plmd_user *user = ngf_plmd_get_user(m);
+    for (uint32_t e = 0u; e < user->nentries; ++e) {
+      n += strlen(user->entries[e].key) + strlen(user->entries[e].value);
+    }
+    const ngf_plmd_aliases *aliases = ngf_plmd_get_aliases(m);
+    for (uint32_t e = 0u; e < aliases->nentries; ++e) {
+      n += strlen(aliases->entries[e].alias) +
+           strlen(aliases->entries[e].target);
+    }
+    const ngf_plmd_objects *objects = ngf_plmd_get_objects(m);
+    for (uint32_t e = 0u; e < objects->nentries; ++e) {
+      n += strlen(objects->entries[e].name) + strlen(objects->entries[e].hash);
+    }
+    const ngf_plmd_uniform_buffer_layouts *ubos =
+        ngf_plmd_get_uniform_buffer_layouts(m);
+    for (uint32_t b = 0u; b < ubos->nbuffers; ++b) {
+      n += strlen(ubos->buffers[b].name);
+      for (uint32_t i = 0u; i < ubos->buffers[b].nmembers; ++i) {
+        n += strlen(ubos->buffers[b].members[i].name);
+      }
+    }
+    const ngf_plmd_root_signature *rs = ngf_plmd_get_root_signature(m);
+    for (uint32_t t = 0u; t < rs->ntables; ++t) {
+      for (uint32_t r = 0u; r < rs->tables[t].nranges; ++r) {
+        n += rs->tables[t].ranges[r].shader_register;
+      }
+    }
+    const ngf_plmd_binding_fixups *fixups = ngf_plmd_get_binding_fixups(m);
+    for (uint32_t e = 0u; e < fixups->nentries; ++e) {
+      n += strlen(fixups->entries[e].name);
+    }
+    const ngf_plmd_sampling_usage *usage = ngf_plmd_get_sampling_usage(m);
+    for (uint32_t e = 0u; e < usage->nentries; ++e) {
+      n += usage->entries[e].flags;
+    }
+    n += ngf_plmd_get_compile_tier(m)->tier;
+    n += ngf_plmd_get_instrumentation(m)->ncounters;
+    ngf_plmd_destroy(m, NULL);
+    return n == SIZE_MAX; // keep the reads from being optimized away.
+  }
+  return 0;
+}
+
+#if !defined(NGF_PLMD_LIBFUZZER)
+
+static const uint32_t MUTATIONS_PER_INPUT = 20000u;
+
+// xorshift32, seeded identically for every run so failures are reproducible.
+static uint32_t rng_state = 0x9e3779b9u;
+static uint32_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+// Applies one of a few mutations that are likely to upset the loader:
+// flipping bits, overwriting a field with a large or boundary value, and
+// truncating the buffer.
+static size_t mutate(uint8_t *data, size_t size) {
+  static const uint32_t interesting_values[] = {
+    0u, 1u, 0x7fffffffu, 0x80000000u, 0xfffffffeu, 0xffffffffu, 0x00ffffffu
+  };
+  const size_t nfields = size / 4u;
+  if (nfields == 0u) return size;
+  switch (rng() % 4u) {
+  case 0: {
+    const uint32_t nflips = 1u + rng() % 4u;
+    for (uint32_t i = 0u; i < nflips; ++i) {
+      data[rng() % size] ^= (uint8_t)(1u << (rng() % 8u));
+    }
+    break;
+  }
+  case 1: {
+    const uint32_t v = interesting_values[rng() % (sizeof(interesting_values) /
+                                                   sizeof(interesting_values[0]))];
+    memcpy(&data[(rng() % nfields) * 4u], &v, sizeof(v));
+    break;
+  }
+  case 2: {
+    const uint32_t v = rng();
+    memcpy(&data[(rng() % nfields) * 4u], &v, sizeof(v));
+    break;
+  }
+  default:
+    size = (rng() % nfields) * 4u + ((rng() % 8u) == 0u ? rng() % 4u : 0u);
+    break;
+  }
+  return size;
+}
+
+static uint8_t* read_file(const char *path, size_t *size) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) return NULL;
+  fseek(f, 0, SEEK_END);
+  const long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *data = malloc(len > 0 ? (size_t)len : 1u);
+  if (data != NULL && fread(data, 1u, (size_t)len, f) != (size_t)len) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  *size = (size_t)len;
+  return data;
+}
+
+int main(int argc, const char *argv[]) {
+  if (argc < 2) {
+    printf("Usage: fuzz_metadata <pipeline metadata file> ...\n");
+    exit(0);
+  }
+  for (int a = 1; a < argc; ++a) {
+    size_t size = 0u;
+    uint8_t *original = read_file(argv[a], &size);
+    if (original == NULL) {
+      fprintf(stderr, "Failed to read %s\n", argv[a]);
+      exit(1);
+    }
+    ngf_plmd *m = NULL;
+    if (ngf_plmd_load(original, size, NULL, &m) != NGF_PLMD_ERROR_OK) {
+      fprintf(stderr, "Failed to load unmodified %s\n", argv[a]);
+      exit(1);
+    }
+    ngf_plmd_destroy(m, NULL);
+    if (ngf_plmd_load_trusted(original, size, NULL, &m) != NGF_PLMD_ERROR_OK) {
+      fprintf(stderr, "Trusted load of unmodified %s failed\n", argv[a]);
+      exit(1);
+    }
+    ngf_plmd_destroy(m, NULL);
+    uint8_t *mutated = malloc(size > 0u ? size : 1u);
+    uint32_t nrejected = 0u;
+    for (uint32_t i = 0u; i < MUTATIONS_PER_INPUT; ++i) {
+      memcpy(mutated, original, size);
+      size_t mutated_size = mutate(mutated, size);
+      const uint32_t nextra = rng() % 3u;
+      for (uint32_t j = 0u; j < nextra; ++j) {
+        mutated_size = mutate(mutated, mutated_size);
+      }
+      // Copy to an exactly sized allocation so that sanitizers catch reads
+      // past the end of the input.
+      uint8_t *input = malloc(mutated_size > 0u ? mutated_size : 1u);
+      memcpy(input, mutated, mutated_size);
+      ngf_plmd *result = NULL;
+      if (ngf_plmd_load(input, mutated_size, NULL, &result) !=
+          NGF_PLMD_ERROR_OK) {
+        ++nrejected;
+      } else {
+        ngf_plmd_destroy(result, NULL);
+      }
+      LLVMFuzzerTestOneInput(input, mutated_size);
+      free(input);
+    }
+    printf("%s: %u mutations, %u rejected\n", argv[a],
+           MUTATIONS_PER_INPUT, nrejected);
+    free(mutated);
+    free(original);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Prints the techniques published by `nicegraf_shaderc --watch --publish'.
+
+#define _POSIX_C_SOURCE 200112L // for nanosleep.
+#include "metadata_parser/hot_reload_client.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#define sleep_ms(ms) Sleep(ms)
+#else
+#include <time.h>
+static void sleep_ms(long ms) {
+  const struct timespec t = { ms / 1000, (ms % 1000) * 1000000 };
+  nanosleep(&t, NULL);
+}
+#endif
+
+int main(int argc, const char *argv[]) {
+  if (argc != 3) {
+    printf("Usage: hot_reload_listener <host> <port>\n");
+    exit(0);
+  }
+  ngf_plhr_client *client;
+  ngf_plhr_error err = ngf_plhr_connect(argv[1], argv[2], NULL, &client);
+  if (err != NGF_PLHR_ERROR_OK) {
+    fprintf(stderr, "Error connecting: %d\n", err);
+    exit(1);
+  }
+  for (;;) {
+    ngf_plhr_update update;
+    int has_update;
+    err = ngf_plhr_poll(client, &update, &has_update);
+    if (err != NGF_PLHR_ERROR_OK) {
+      fprintf(stderr, "Error receiving updates: %d\n", err);
+      break;
+    }
+    if (!has_update) {
+      sleep_ms(16);
+      continue;
+    }
+    printf("technique %s\n", update.technique_name);
+    for (uint32_t f = 0u; f < update.nfiles; ++f) {
+      printf("  %s %u bytes %s\n", update.files[f].name, update.files[f].size,
+             update.files[f].hash);
+    }
+    // Applications would rebuild their pipelines at this point.
+    ngf_plmd *m;
+    const ngf_plmd_error plmd_err =
+        ngf_plmd_load(update.metadata, update.metadata_size, NULL, &m);
+    if (plmd_err != NGF_PLMD_ERROR_OK) {
+      fprintf(stderr, "Error loading pipeline metadata: %d\n", plmd_err);
+    } else {
+      printf("  metadata %u bytes %s\n", update.metadata_size,
+             update.metadata_hash);
+      ngf_plmd_destroy(m, NULL);
+    }
+    fflush(stdout);
+  }
+  ngf_plhr_disconnect(client);
+  return 1;
+}
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "sampling_usage.h"
+
+#include "spirv.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Returns the usage flags implied by an image instruction, or 0 for other
+// instructions.
+uint32_t image_instruction_usage(spv::Op op) {
+  switch (op) {
+  case spv::OpImageSampleImplicitLod:
+  case spv::OpImageSampleProjImplicitLod:
+  case spv::OpImageSparseSampleImplicitLod:
+  case spv::OpImageSparseSampleProjImplicitLod:
+    return SAMPLING_IMPLICIT_LOD;
+  case spv::OpImageSampleExplicitLod:
+  case spv::OpImageSampleProjExplicitLod:
+  case spv::OpImageSparseSampleExplicitLod:
+  case spv::OpImageSparseSampleProjExplicitLod:
+    return SAMPLING_EXPLICIT_LOD;
+  case spv::OpImageSampleDrefImplicitLod:
+  case spv::OpImageSampleProjDrefImplicitLod:
+  case spv::OpImageSparseSampleDrefImplicitLod:
+  case spv::OpImageSparseSampleProjDrefImplicitLod:
+    return SAMPLING_IMPLICIT_LOD | SAMPLING_DREF;
+  case spv::OpImageSampleDrefExplicitLod:
+  case spv::OpImageSampleProjDrefExplicitLod:
+  case spv::OpImageSparseSampleDrefExplicitLod:
+  case spv::OpImageSparseSampleProjDrefExplicitLod:
+    return SAMPLING_EXPLICIT_LOD | SAMPLING_DREF;
+  case spv::OpImageGather:
+  case spv::OpImageSparseGather:
+    return SAMPLING_GATHER;
+  case spv::OpImageDrefGather:
+  case spv::OpImageSparseDrefGather:
+    return SAMPLING_GATHER | SAMPLING_DREF;
+  case spv::OpImageFetch:
+  case spv::OpImageSparseFetch:
+  case spv::OpImageRead:
+  case spv::OpImageSparseRead:
+    return SAMPLING_FETCH;
+  case spv::OpImageQuerySizeLod:
+  case spv::OpImageQuerySize:
+  case spv::OpImageQueryLod:
+  case spv::OpImageQueryLevels:
+  case spv::OpImageQuerySamples:
+    return SAMPLING_QUERY;
+  default:
+    return 0u;
+  }
+}
+
+const struct {
+  sampling_usage_bit bit;
+  const char *name;
+} SAMPLING_USAGE_NAMES[] = {
+  { SAMPLING_IMPLICIT_LOD, "implicit_lod" },
+  { SAMPLING_EXPLICIT_LOD, "explicit_lod" },
+  { SAMPLING_GATHER, "gather" },
+  { SAMPLING_FETCH, "fetch" },
+  { SAMPLING_QUERY, "query" },
+  { SAMPLING_DREF, "dref" }
+};
+
+}
+
+void add_sampling_usage(const std::vector<uint32_t> &spirv_code,
+                        sampling_usage_map &usage) {
+  constexpr size_t HEADER_SIZE = 5u;
+  std::unordered_map<uint32_t, uint32_t> sets, bindings;
+  // Ids that each image, sampler or pointer to one is derived from.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> sources;
+  // Image operand and flags of each image instruction.
+  std::vector<std::pair<uint32_t, uint32_t>> accesses;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (word_count == 0u || pos + word_count > spirv_code.size()) break;
+    const uint32_t *operands = &spirv_code[pos + 1u];
+    const uint32_t noperands = word_count - 1u;
+    switch (op) {
+    case spv::OpDecorate:
+      if (noperands < 3u) break;
+      if (operands[1] == spv::DecorationDescriptorSet) {
+        sets[operands[0]] = operands[2];
+      } else if (operands[1] == spv::DecorationBinding) {
+        bindings[operands[0]] = operands[2];
+      }
+      break;
+    case spv::OpLoad:
+    case spv::OpCopyObject:
+    case spv::OpImage:
+    case spv::OpAccessChain:
+    case spv::OpInBoundsAccessChain:
+      // The object or base pointer follows the result type and id.
+      if (noperands >= 3u) sources[operands[1]].push_back(operands[2]);
+      break;
+    case spv::OpSampledImage:
+      if (noperands >= 4u) {
+        sources[operands[1]].push_back(operands[2]);
+        sources[operands[1]].push_back(operands[3]);
+      }
+      break;
+    case spv::OpSelect:
+      if (noperands >= 5u) {
+        sources[operands[1]].push_back(operands[3]);
+        sources[operands[1]].push_back(operands[4]);
+      }
+      break;
+    case spv::OpPhi:
+      for (uint32_t o = 2u; o + 1u < noperands; o += 2u) {
+        sources[operands[1]].push_back(operands[o]);
+      }
+      break;
+    default: {
+      const uint32_t flags = image_instruction_usage(op);
+      if (flags != 0u && noperands >= 3u) {
+        accesses.emplace_back(operands[2], flags);
+      }
+      break;
+    }
+    }
+    pos += word_count;
+  }
+
+  for (const auto &access : accesses) {
+    std::vector<uint32_t> pending { access.first };
+    std::unordered_set<uint32_t> visited;
+    while (!pending.empty()) {
+      const uint32_t id = pending.back();
+      pending.pop_back();
+      if (!visited.insert(id).second) continue;
+      const auto binding_it = bindings.find(id);
+      if (binding_it != bindings.end()) {
+        const auto set_it = sets.find(id);
+        const uint32_t set = set_it != sets.end() ? set_it->second : 0u;
+        usage[std::make_pair(set, binding_it->second)] |= access.second;
+        continue;
+      }
+      const auto sources_it = sources.find(id);
+      if (sources_it != sources.end()) {
+        pending.insert(pending.end(), sources_it->second.begin(),
+                       sources_it->second.end());
+      }
+    }
+  }
+}
+
+std::string sampling_usage_names(uint32_t usage) {
+  std::string result;
+  for (const auto &u : SAMPLING_USAGE_NAMES) {
+    if ((usage & u.bit) == 0u) continue;
+    if (!result.empty()) result += ", ";
+    result += u.name;
+  }
+  return result;
+}
@@ -0,0 +1,53 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser/metadata_parser.h"
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Ways in which a shader accesses a texture or a sampler.
+enum sampling_usage_bit {
+  SAMPLING_IMPLICIT_LOD = NGF_PLMD_SAMPLING_IMPLICIT_LOD_BIT,
+  SAMPLING_EXPLICIT_LOD = NGF_PLMD_SAMPLING_EXPLICIT_LOD_BIT,
+  SAMPLING_GATHER = NGF_PLMD_SAMPLING_GATHER_BIT,
+  SAMPLING_FETCH = NGF_PLMD_SAMPLING_FETCH_BIT,
+  SAMPLING_QUERY = NGF_PLMD_SAMPLING_QUERY_BIT,
+  SAMPLING_DREF = NGF_PLMD_SAMPLING_DREF_BIT
+};
+
+// Sampling usage flags of images and samplers, keyed by (set, binding).
+using sampling_usage_map = std::map<std::pair<uint32_t, uint32_t>, uint32_t>;
+
+// Adds the sampling usage of the images and samplers in a SPIR-V module to
+// the map. Each image instruction is traced back to the variables that its
+// image and sampler operands are loaded from.
+void add_sampling_usage(const std::vector<uint32_t> &spirv_code,
+                        sampling_usage_map &usage);
+
+// Returns a comma-separated list of names of the flags in the mask.
+std::string sampling_usage_names(uint32_t usage);
@@ -0,0 +1,390 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#define SPV_ENABLE_UTILITY_CODE
+#include "shader_instrumentation.h"
+#include "diagnostics.h"
+#include "spirv.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+#include <map>
+#include <string.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 5u;
+
+// SPIR-V 1.3 made the StorageBuffer storage class part of the core
+// specification, and since SPIR-V 1.4 entry points have to list all global
+// variables that they use.
+constexpr uint32_t SPIRV_VERSION_1_3 = 0x00010300u;
+constexpr uint32_t SPIRV_VERSION_1_4 = 0x00010400u;
+
+// Name of the counters array within the storage buffer.
+const char COUNTERS_MEMBER_NAME[] = "counters";
+
+// Source location set by an OpLine instruction.
+struct source_location {
+  uint32_t file = 0u; // Id of the OpString holding the file name, or 0.
+  uint32_t line = 0u;
+  uint32_t column = 0u;
+};
+
+// Returns true for instructions that may precede debug names in a module.
+bool precedes_names(spv::Op op) {
+  switch (op) {
+  case spv::OpCapability:
+  case spv::OpExtension:
+  case spv::OpExtInstImport:
+  case spv::OpMemoryModel:
+  case spv::OpEntryPoint:
+  case spv::OpExecutionMode:
+  case spv::OpExecutionModeId:
+  case spv::OpString:
+  case spv::OpSourceExtension:
+  case spv::OpSource:
+  case spv::OpSourceContinued:
+  case spv::OpName:
+  case spv::OpMemberName:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Returns true for instructions that may precede annotations in a module.
+bool precedes_annotations(spv::Op op) {
+  switch (op) {
+  case spv::OpModuleProcessed:
+  case spv::OpDecorate:
+  case spv::OpMemberDecorate:
+  case spv::OpDecorationGroup:
+  case spv::OpGroupDecorate:
+  case spv::OpGroupMemberDecorate:
+  case spv::OpDecorateId:
+  case spv::OpDecorateString:
+  case spv::OpMemberDecorateString:
+    return true;
+  default:
+    return precedes_names(op);
+  }
+}
+
+// Appends an instruction to a sequence of words. `literal' is an optional
+// string operand that follows all the other operands.
+void append_instruction(std::vector<uint32_t> &words,
+                        spv::Op op,
+                        std::initializer_list<uint32_t> operands,
+                        const char *literal = nullptr) {
+  const size_t literal_words = literal ? strlen(literal) / 4u + 1u : 0u;
+  words.push_back(
+      (uint32_t)(1u + operands.size() + literal_words) << 16u | op);
+  words.insert(words.end(), operands);
+  if (literal != nullptr) {
+    const size_t start = words.size();
+    words.resize(start + literal_words, 0u);
+    memcpy(&words[start], literal, strlen(literal));
+  }
+}
+
+const char* counter_kind_name(counter_kind kind) {
+  switch (kind) {
+  case counter_kind::invocations: return "invocations";
+  case counter_kind::block: return "block";
+  case counter_kind::loop: return "loop";
+  }
+  return "unknown";
+}
+
+}
+
+uint32_t descriptor_set_count(const std::vector<uint32_t> &spirv_code) {
+  uint32_t count = 0u;
+  if (spirv_code.size() < HEADER_SIZE || spirv_code[0] != spv::MagicNumber) {
+    return count;
+  }
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    if (word_count == 0u || pos + word_count > spirv_code.size()) break;
+    if ((spirv_code[pos] & 0xffffu) == spv::OpDecorate && word_count == 4u &&
+        spirv_code[pos + 2u] == spv::DecorationDescriptorSet) {
+      count = std::max(count, spirv_code[pos + 3u] + 1u);
+    }
+    pos += word_count;
+  }
+  return count;
+}
+
+bool instrument_spirv(std::vector<uint32_t> &spirv_code,
+                      uint32_t set,
+                      uint32_t binding,
+                      std::vector<instrumentation_counter> &counters) {
+  if (spirv_code.size() < HEADER_SIZE || spirv_code[0] != spv::MagicNumber) {
+    return false;
+  }
+  const uint32_t version = spirv_code[1];
+
+  // Find where names, annotations and functions begin, collect the file
+  // names, the 32-bit unsigned integer type and constants, and find the basic
+  // blocks along with their source locations. A block is attributed to the
+  // first line it executes, and a loop to the line of its header's merge
+  // instruction.
+  std::unordered_map<uint32_t, std::string> file_names;
+  std::unordered_set<uint32_t> entry_functions;
+  std::string stage;
+  uint32_t uint_type = 0u;
+  std::map<uint32_t, uint32_t> uint_constants;
+  size_t names_pos = 0u, annotations_pos = 0u, functions_pos = 0u;
+  std::vector<uint32_t> blocks;
+  std::unordered_set<uint32_t> entry_blocks;
+  std::unordered_map<uint32_t, source_location> block_locations;
+  std::unordered_map<uint32_t, source_location> loop_locations;
+  uint32_t function = 0u, block = 0u;
+  bool first_block = false;
+  source_location location;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (word_count == 0u || pos + word_count > spirv_code.size()) return false;
+    const uint32_t *operands = &spirv_code[pos + 1u];
+    if (names_pos == 0u && !precedes_names(op)) names_pos = pos;
+    if (annotations_pos == 0u && !precedes_annotations(op)) {
+      annotations_pos = pos;
+    }
+    switch (op) {
+    case spv::OpEntryPoint:
+      if (word_count < 3u) return false;
+      entry_functions.insert(operands[1]);
+      if (stage.empty()) {
+        stage = operands[0] == spv::ExecutionModelVertex ? "vertex"
+              : operands[0] == spv::ExecutionModelFragment ? "fragment"
+              : "other";
+      }
+      break;
+    case spv::OpString:
+      if (word_count < 3u) return false;
+      file_names[operands[0]] = std::string(
+          (const char*)(operands + 1u),
+          strnlen((const char*)(operands + 1u), (word_count - 2u) * 4u));
+      break;
+    case spv::OpTypeInt:
+      if (word_count == 4u && operands[1] == 32u && operands[2] == 0u &&
+          uint_type == 0u) {
+        uint_type = operands[0];
+      }
+      break;
+    case spv::OpConstant:
+      if (word_count == 4u && uint_type != 0u && operands[0] == uint_type) {
+        uint_constants.emplace(operands[2], operands[1]);
+      }
+      break;
+    case spv::OpFunction:
+      if (functions_pos == 0u) functions_pos = pos;
+      function = operands[1];
+      first_block = true;
+      break;
+    case spv::OpFunctionEnd:
+      function = block = 0u;
+      break;
+    case spv::OpLabel:
+      block = operands[0];
+      blocks.push_back(block);
+      if (first_block && entry_functions.count(function) != 0u) {
+        entry_blocks.insert(block);
+      }
+      first_block = false;
+      location = source_location();
+      break;
+    case spv::OpLine:
+      location = source_location { operands[0], operands[1], operands[2] };
+      if (block != 0u) block_locations.emplace(block, location);
+      break;
+    case spv::OpNoLine:
+      location = source_location();
+      break;
+    case spv::OpLoopMerge:
+      loop_locations[operands[1]] = location;
+      break;
+    default:
+      break;
+    }
+    pos += word_count;
+  }
+  if (functions_pos == 0u || blocks.empty()) return false;
+
+  uint32_t id_bound = spirv_code[3];
+  std::vector<uint32_t> names, annotations, globals;
+  if (uint_type == 0u) {
+    uint_type = id_bound++;
+    append_instruction(globals, spv::OpTypeInt, { uint_type, 32u, 0u });
+  }
+  auto get_constant = [&](uint32_t value) {
+    auto it = uint_constants.find(value);
+    if (it != uint_constants.end()) return it->second;
+    const uint32_t id = id_bound++;
+    append_instruction(globals, spv::OpConstant, { uint_type, id, value });
+    uint_constants.emplace(value, id);
+    return id;
+  };
+
+  // Declare the storage buffer. Before SPIR-V 1.3, storage buffers are
+  // uniform blocks decorated with BufferBlock.
+  const bool storage_buffer_class = version >= SPIRV_VERSION_1_3;
+  const uint32_t storage_class = storage_buffer_class
+                                     ? spv::StorageClassStorageBuffer
+                                     : spv::StorageClassUniform;
+  const uint32_t array_type = id_bound++, block_type = id_bound++,
+                 block_pointer_type = id_bound++,
+                 uint_pointer_type = id_bound++, buffer = id_bound++;
+  const std::string block_type_name =
+      std::string("type.") + INSTRUMENTATION_BUFFER_NAME;
+  append_instruction(names, spv::OpName, { block_type },
+                     block_type_name.c_str());
+  append_instruction(names, spv::OpMemberName, { block_type, 0u },
+                     COUNTERS_MEMBER_NAME);
+  append_instruction(names, spv::OpName, { buffer },
+                     INSTRUMENTATION_BUFFER_NAME);
+  append_instruction(annotations, spv::OpDecorate,
+                     { array_type, spv::DecorationArrayStride, 4u });
+  append_instruction(annotations, spv::OpMemberDecorate,
+                     { block_type, 0u, spv::DecorationOffset, 0u });
+  append_instruction(annotations, spv::OpDecorate,
+                     { block_type, storage_buffer_class
+                                       ? spv::DecorationBlock
+                                       : spv::DecorationBufferBlock });
+  append_instruction(annotations, spv::OpDecorate,
+                     { buffer, spv::DecorationDescriptorSet, set });
+  append_instruction(annotations, spv::OpDecorate,
+                     { buffer, spv::DecorationBinding, binding });
+  append_instruction(globals, spv::OpTypeRuntimeArray,
+                     { array_type, uint_type });
+  append_instruction(globals, spv::OpTypeStruct, { block_type, array_type });
+  append_instruction(globals, spv::OpTypePointer,
+                     { block_pointer_type, storage_class, block_type });
+  append_instruction(globals, spv::OpTypePointer,
+                     { uint_pointer_type, storage_class, uint_type });
+  append_instruction(globals, spv::OpVariable,
+                     { block_pointer_type, buffer, storage_class });
+  const uint32_t zero = get_constant(0u), one = get_constant(1u),
+                 scope = get_constant(spv::ScopeDevice),
+                 semantics = get_constant(spv::MemorySemanticsMaskNone);
+
+  // Assign a counter to every block. The first block of the entry point
+  // counts invocations, and the first block of a loop's continue construct
+  // counts its iterations.
+  std::unordered_map<uint32_t, uint32_t> block_counters;
+  for (uint32_t label : blocks) {
+    instrumentation_counter counter;
+    counter.stage = stage;
+    source_location counter_location;
+    auto loop = loop_locations.find(label);
+    if (entry_blocks.count(label) != 0u) {
+      counter.kind = counter_kind::invocations;
+    } else if (loop != loop_locations.end()) {
+      counter.kind = counter_kind::loop;
+      counter_location = loop->second;
+    } else {
+      counter.kind = counter_kind::block;
+    }
+    if (counter.kind != counter_kind::loop) {
+      auto it = block_locations.find(label);
+      if (it != block_locations.end()) counter_location = it->second;
+    }
+    auto file = file_names.find(counter_location.file);
+    if (file != file_names.end()) counter.file = file->second;
+    counter.line = counter_location.line;
+    counter.column = counter_location.column;
+    block_counters[label] = get_constant((uint32_t)counters.size());
+    counters.push_back(counter);
+  }
+
+  // Rebuild the module with the new declarations, and increment the counter
+  // of each block right after its phis and variables.
+  std::vector<uint32_t> instrumented(spirv_code.begin(),
+                                     spirv_code.begin() + HEADER_SIZE);
+  instrumented.reserve(spirv_code.size() + names.size() + annotations.size() +
+                       globals.size() + blocks.size() * 11u);
+  uint32_t pending_counter = 0u;
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (pos == names_pos) {
+      instrumented.insert(instrumented.end(), names.begin(), names.end());
+    }
+    if (pos == annotations_pos) {
+      instrumented.insert(instrumented.end(), annotations.begin(),
+                          annotations.end());
+    }
+    if (pos == functions_pos) {
+      instrumented.insert(instrumented.end(), globals.begin(), globals.end());
+    }
+    if (pending_counter != 0u && op != spv::OpPhi && op != spv::OpVariable &&
+        op != spv::OpLine && op != spv::OpNoLine) {
+      const uint32_t pointer = id_bound++, result = id_bound++;
+      append_instruction(instrumented, spv::OpAccessChain,
+                         { uint_pointer_type, pointer, buffer, zero,
+                           pending_counter });
+      append_instruction(instrumented, spv::OpAtomicIAdd,
+                         { uint_type, result, pointer, scope, semantics,
+                           one });
+      pending_counter = 0u;
+    }
+    const size_t start = instrumented.size();
+    instrumented.insert(instrumented.end(), spirv_code.begin() + pos,
+                        spirv_code.begin() + pos + word_count);
+    if (op == spv::OpEntryPoint && version >= SPIRV_VERSION_1_4) {
+      instrumented[start] += 1u << 16u;
+      instrumented.push_back(buffer);
+    } else if (op == spv::OpLabel) {
+      pending_counter = block_counters[spirv_code[pos + 1u]];
+    }
+    pos += word_count;
+  }
+  instrumented[3] = id_bound;
+  spirv_code = std::move(instrumented);
+  return true;
+}
+
+std::string counter_map_json(const std::string &technique,
+                             uint32_t set,
+                             uint32_t binding,
+                             const std::vector<instrumentation_counter> &counters) {
+  std::string json = "{\n  \"technique\": " + json_string(technique) +
+                     ",\n  \"set\": " + std::to_string(set) +
+                     ",\n  \"binding\": " + std::to_string(binding) +
+                     ",\n  \"counters\": [";
+  for (size_t i = 0u; i < counters.size(); ++i) {
+    const instrumentation_counter &c = counters[i];
+    json += i == 0u ? "\n" : ",\n";
+    json += "    {\"index\": " + std::to_string(i) +
+            ", \"stage\": " + json_string(c.stage) +
+            ", \"kind\": " + json_string(counter_kind_name(c.kind)) +
+            ", \"file\": " + json_string(c.file) +
+            ", \"line\": " + std::to_string(c.line) +
+            ", \"column\": " + std::to_string(c.column) + "}";
+  }
+  json += counters.empty() ? "]\n}\n" : "\n  ]\n}\n";
+  return json;
+}
@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// What an instrumentation counter counts.
+enum class counter_kind {
+  invocations, // Invocations of the entry point.
+  block,       // Executions of a basic block.
+  loop         // Iterations of a loop that reached its continue block.
+};
+
+// A counter added to a shader by `instrument_spirv', along with the source
+// location of the code that it counts.
+struct instrumentation_counter {
+  counter_kind kind;
+  std::string stage;    // "vertex" or "fragment".
+  std::string file;     // Empty if unknown.
+  uint32_t line = 0u;   // 1-based, or 0 if unknown.
+  uint32_t column = 0u; // 1-based, or 0 if unknown.
+};
+
+// Name of the storage buffer that instrumented shaders keep their counters in.
+constexpr char INSTRUMENTATION_BUFFER_NAME[] = "ngf_counters";
+
+// Returns one past the highest descriptor set that the resources of a SPIR-V
+// module are bound to, or 0 if it doesn't declare any.
+uint32_t descriptor_set_count(const std::vector<uint32_t> &spirv_code);
+
+// Rewrites a SPIR-V module so that it counts the invocations of its entry
+// point, the executions of each of its basic blocks and the iterations of
+// each of its loops, by atomically incrementing the elements of a storage
+// buffer (an array of 32-bit unsigned integers) bound at the given set and
+// binding.
+// The new counters are appended to `counters', and the counter at position i
+// of it is kept in element i of the buffer, so that several modules
+// instrumented with the same vector can share one buffer. Source locations are
+// taken from the module's line information, if it has any.
+// Returns false if the module can't be instrumented.
+bool instrument_spirv(std::vector<uint32_t> &spirv_code,
+                      uint32_t set,
+                      uint32_t binding,
+                      std::vector<instrumentation_counter> &counters);
+
+// Returns a JSON document mapping the counters of an instrumented technique
+// to source locations.
+std::string counter_map_json(const std::string &technique,
+                             uint32_t set,
+                             uint32_t binding,
+                             const std::vector<instrumentation_counter> &counters);
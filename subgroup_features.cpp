@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "subgroup_features.h"
+
+#include "spirv.hpp"
+
+namespace {
+
+const struct {
+  spv::Capability capability;
+  subgroup_feature_bit feature;
+  const char *name;
+} SUBGROUP_CAPABILITIES[] = {
+  { spv::CapabilityGroupNonUniform, SUBGROUP_FEATURE_BASIC, "basic" },
+  { spv::CapabilityGroupNonUniformVote, SUBGROUP_FEATURE_VOTE, "vote" },
+  { spv::CapabilityGroupNonUniformArithmetic, SUBGROUP_FEATURE_ARITHMETIC,
+    "arithmetic" },
+  { spv::CapabilityGroupNonUniformBallot, SUBGROUP_FEATURE_BALLOT, "ballot" },
+  { spv::CapabilityGroupNonUniformShuffle, SUBGROUP_FEATURE_SHUFFLE,
+    "shuffle" },
+  { spv::CapabilityGroupNonUniformShuffleRelative,
+    SUBGROUP_FEATURE_SHUFFLE_RELATIVE, "shuffle_relative" },
+  { spv::CapabilityGroupNonUniformClustered, SUBGROUP_FEATURE_CLUSTERED,
+    "clustered" },
+  { spv::CapabilityGroupNonUniformQuad, SUBGROUP_FEATURE_QUAD, "quad" }
+};
+
+constexpr uint32_t ALL_SUBGROUP_FEATURES = 0xffu;
+
+}
+
+uint32_t required_subgroup_features(const std::vector<uint32_t> &spirv_code) {
+  constexpr size_t HEADER_SIZE = 5u;
+  uint32_t features = 0u;
+  // Capabilities are always declared at the very beginning of the module.
+  for (size_t pos = HEADER_SIZE; pos < spirv_code.size();) {
+    const uint32_t word_count = spirv_code[pos] >> 16u;
+    const spv::Op op = (spv::Op)(spirv_code[pos] & 0xffffu);
+    if (op != spv::OpCapability || word_count < 2u) break;
+    for (const auto &c : SUBGROUP_CAPABILITIES) {
+      if (c.capability == (spv::Capability)spirv_code[pos + 1u]) {
+        features |= c.feature;
+      }
+    }
+    pos += word_count;
+  }
+  // All of the other capabilities implicitly declare GroupNonUniform.
+  if (features != 0u) features |= SUBGROUP_FEATURE_BASIC;
+  return features;
+}
+
+uint32_t supported_subgroup_features(const target_info &target) {
+  const bool mobile = target.platform == target_platform_class::MOBILE;
+  const uint32_t version = target.version_maj * 10u + target.version_min;
+  switch (target.api) {
+  case target_api::GL:
+    // Through the GL_KHR_shader_subgroup_* extensions.
+    return version >= (mobile ? 31u : 43u) ? ALL_SUBGROUP_FEATURES : 0u;
+  case target_api::METAL:
+    // Through simd_* and quad_* functions. iOS only has quad-group functions,
+    // and Metal 2.0 on macOS only has broadcasts and shuffles.
+    if (version < 20u) {
+      return 0u;
+    } else if (mobile) {
+      return SUBGROUP_FEATURE_BASIC | SUBGROUP_FEATURE_SHUFFLE |
+             SUBGROUP_FEATURE_SHUFFLE_RELATIVE | SUBGROUP_FEATURE_QUAD;
+    } else if (version < 21u) {
+      return SUBGROUP_FEATURE_BASIC | SUBGROUP_FEATURE_SHUFFLE |
+             SUBGROUP_FEATURE_SHUFFLE_RELATIVE;
+    } else {
+      return ALL_SUBGROUP_FEATURES & ~(uint32_t)SUBGROUP_FEATURE_CLUSTERED;
+    }
+  case target_api::VULKAN:
+  case target_api::D3D12:
+  default:
+    return ALL_SUBGROUP_FEATURES;
+  }
+}
+
+std::string subgroup_feature_names(uint32_t features) {
+  std::string result;
+  for (const auto &c : SUBGROUP_CAPABILITIES) {
+    if ((features & c.feature) == 0u) continue;
+    if (!result.empty()) result += ", ";
+    result += c.name;
+  }
+  return result;
+}
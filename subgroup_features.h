@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "metadata_parser/metadata_parser.h"
+#include "target.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Subgroup (wave) operation classes. The values match VkSubgroupFeatureFlagBits.
+enum subgroup_feature_bit {
+  SUBGROUP_FEATURE_BASIC = NGF_PLMD_SUBGROUP_FEATURE_BASIC_BIT,
+  SUBGROUP_FEATURE_VOTE = NGF_PLMD_SUBGROUP_FEATURE_VOTE_BIT,
+  SUBGROUP_FEATURE_ARITHMETIC = NGF_PLMD_SUBGROUP_FEATURE_ARITHMETIC_BIT,
+  SUBGROUP_FEATURE_BALLOT = NGF_PLMD_SUBGROUP_FEATURE_BALLOT_BIT,
+  SUBGROUP_FEATURE_SHUFFLE = NGF_PLMD_SUBGROUP_FEATURE_SHUFFLE_BIT,
+  SUBGROUP_FEATURE_SHUFFLE_RELATIVE =
+      NGF_PLMD_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT,
+  SUBGROUP_FEATURE_CLUSTERED = NGF_PLMD_SUBGROUP_FEATURE_CLUSTERED_BIT,
+  SUBGROUP_FEATURE_QUAD = NGF_PLMD_SUBGROUP_FEATURE_QUAD_BIT
+};
+
+// Returns the subgroup features used by a SPIR-V module, based on the
+// capabilities it declares.
+uint32_t required_subgroup_features(const std::vector<uint32_t> &spirv_code);
+
+// Returns the subgroup features that can be expressed in the given target's
+// shading language.
+uint32_t supported_subgroup_features(const target_info &target);
+
+// Returns a comma-separated list of names of the features in the mask.
+std::string subgroup_feature_names(uint32_t features);
@@ -20,7 +20,7 @@ SOFTWARE.
 
 // Target API class.
 enum class target_api {
-  GL, METAL, VULKAN
+  GL, METAL, VULKAN, D3D12
 };
 
 // Device type that a target API runs on.
@@ -109,6 +109,15 @@ static const struct named_target_info TARGET_MAP[] = {
       target_platform_class::DESKTOP
     }
   },
+  {
+    "msl21",
+    {
+      target_api::METAL,
+      "21.msl",
+      2u, 1u,
+      target_platform_class::DESKTOP
+    }
+  },
   {
     "msl10ios",
     {
@@ -145,6 +154,15 @@ static const struct named_target_info TARGET_MAP[] = {
       target_platform_class::MOBILE
     }
   },
+  {
+    "msl21ios",
+    {
+      target_api::METAL,
+      "21ios.msl",
+      2u, 1u,
+      target_platform_class::MOBILE
+    }
+  },
   {
     "spv",
     {
@@ -153,7 +171,24 @@ static const struct named_target_info TARGET_MAP[] = {
       0u, 0u,
       target_platform_class::DONTCARE
     }
+  },
+  {
+    "dxil",
+    {
+      target_api::D3D12,
+      "dxil",
+      0u, 0u,
+      target_platform_class::DESKTOP
+    }
   }
 };
 constexpr uint32_t TARGET_COUNT = sizeof(TARGET_MAP)/sizeof(TARGET_MAP[0]);
 
+// Returns the name of a target from TARGET_MAP.
+inline const char* target_name(const target_info *target) {
+  for (const named_target_info &t : TARGET_MAP) {
+    if (&t.target == target) return t.name;
+  }
+  return "unknown";
+}
+
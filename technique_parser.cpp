@@ -22,6 +22,7 @@
 
 
 #include "technique_parser.h"
+#include "build_error.h"
 
 #include <assert.h>
 #include <ctype.h>
@@ -45,20 +46,29 @@ enum class technique_parser_state {
 #define IS_IDENT(c) (isalnum(c) || c == '_')
 #define IS_TAB_SPACE(c) (c == ' '  || c == '\t')
 
-// Reports a technique preprocessor error and exits.
-static void report_technique_parser_error(uint32_t line_num,
+// Reports a technique preprocessor error (or stores it in `error', if not
+// null) and aborts the build.
+static void report_technique_parser_error(technique_parser_error *error,
+                                          uint32_t line_num,
                                           const char *format, ...) {
+  char message[256];
   va_list varargs;
   va_start(varargs, format);
-  fprintf(stderr, "line %d: ", line_num);
-  vfprintf(stderr, format, varargs);
-  fprintf(stderr, "\n");
-  exit(1);
+  vsnprintf(message, sizeof(message), format, varargs);
+  va_end(varargs);
+  if (error != nullptr) {
+    error->line = line_num;
+    error->message = message;
+  } else {
+    fprintf(stderr, "line %d: %s\n", line_num, message);
+  }
+  abort_build();
 }
 
 void parse_techniques(const std::string &input_source,
                       std::vector<technique> &techniques,
-                      const define_container &default_defines) {
+                      const define_container &default_defines,
+                      technique_parser_error *error) {
   uint32_t last_four_chars = 0u;
   uint32_t line_num = 1u;
   const uint32_t technique_prefix = 0x2f2f543a; // `//T:'
@@ -72,8 +82,8 @@ void parse_techniques(const std::string &input_source,
     // Collapse windows line endings into '\n'.
     if (c == '\r' && (c_idx == input_source.size() - 1u ||
                       input_source[c_idx + 1u] != '\n')) {
-      fprintf(stderr, "Stray carriage return in input on line %d\n", line_num);
-      exit(1);
+      report_technique_parser_error(error, line_num,
+                                    "stray carriage return in input");
     } else if (c == '\r') {
       continue;
     }
@@ -99,7 +109,8 @@ void parse_techniques(const std::string &input_source,
         techniques.back().name.push_back(c);
       } else if (!IS_TAB_SPACE(c)) {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in technique name", c);
+            error, line_num,
+            "unexpected character [%c] in technique name", c);
       }
       break;
     case  technique_parser_state::PARSING_NAME:
@@ -109,7 +120,8 @@ void parse_techniques(const std::string &input_source,
         state = technique_parser_state::LOOKING_FOR_PARAMETER_NAME;
       } else {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in technique name", c);
+            error, line_num,
+            "unexpected character [%c] in technique name", c);
       }
       break;
     case technique_parser_state::LOOKING_FOR_PARAMETER_NAME:
@@ -121,7 +133,8 @@ void parse_techniques(const std::string &input_source,
         state = technique_parser_state::FINALIZING_TECHNIQUE;
       } else if (!IS_TAB_SPACE(c)) {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in technique param name", c);
+            error, line_num,
+            "unexpected character [%c] in technique param name", c);
       }
       break;
     case technique_parser_state::PARSING_PARAMETER_NAME:
@@ -135,12 +148,14 @@ void parse_techniques(const std::string &input_source,
           state = technique_parser_state::PARSING_ENTRYPOINT_NAME;
           entry_point_name.clear();
         } else {
-          report_technique_parser_error(line_num, "unknown parameter [%s]", 
+          report_technique_parser_error(error, line_num,
+                                        "unknown parameter [%s]",
                                         parameter_name.c_str());
         }
       } else {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in technique param name", c);
+            error, line_num,
+            "unexpected character [%c] in technique param name", c);
       }
       break;
     case technique_parser_state::PARSING_ENTRYPOINT_NAME:
@@ -148,7 +163,7 @@ void parse_techniques(const std::string &input_source,
         entry_point_name.push_back(c);
       } else if (IS_TAB_SPACE(c) || c == '\n') {
         if (entry_point_name.empty()) {
-          report_technique_parser_error(line_num,
+          report_technique_parser_error(error, line_num,
                                         "entry point name cannot be empty");
         }
         technique::entry_point ep {
@@ -159,7 +174,7 @@ void parse_techniques(const std::string &input_source,
         };
         for (const auto &prev_ep : techniques.back().entry_points) {
           if (prev_ep.kind == ep.kind) {
-            report_technique_parser_error(line_num,
+            report_technique_parser_error(error, line_num,
                                           "duplicate entry point %s:%s",
                                           parameter_name.c_str(),
                                           ep.name.c_str());
@@ -173,7 +188,8 @@ void parse_techniques(const std::string &input_source,
             : technique_parser_state::FINALIZING_TECHNIQUE;
       } else {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in entry point name", c);
+            error, line_num,
+            "unexpected character [%c] in entry point name", c);
       }
       break;
     case technique_parser_state::PARSING_NAMEVAL_NAME:
@@ -184,7 +200,8 @@ void parse_techniques(const std::string &input_source,
         nameval_value.clear();
       } else {
         report_technique_parser_error(
-            line_num, "unexpected character [%c] in definition name", c);
+            error, line_num,
+            "unexpected character [%c] in definition name", c);
       }
       break;
     case technique_parser_state::PARSING_NAMEVAL_VALUE:
@@ -207,7 +224,8 @@ void parse_techniques(const std::string &input_source,
     case technique_parser_state::FINALIZING_TECHNIQUE:
       if (!have_vertex_stage) {
         report_technique_parser_error(
-            line_num, "technique needs to define at least a vertex stage");
+            error, line_num,
+            "technique needs to define at least a vertex stage");
       }
       state = technique_parser_state::LOOKING_FOR_PREFIX;
       break;
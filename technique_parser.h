@@ -41,6 +41,16 @@ struct technique {
   std::vector<std::pair<std::string, std::string>> additional_metadata;
 };
 
+// Location and text of an error in a technique definition.
+struct technique_parser_error {
+  uint32_t line = 0u;
+  std::string message;
+};
+
+// Parses the technique definitions in the input. On errors, the build is
+// aborted; the error is printed, unless `error' is given, in which case it is
+// stored there instead.
 void parse_techniques(const std::string &input_source,
                       std::vector<technique> &techniques,
-                      const define_container &default_defines);
\ No newline at end of file
+                      const define_container &default_defines,
+                      technique_parser_error *error = nullptr);
\ No newline at end of file
@@ -0,0 +1,41 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace alpha_tested {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x01;
+}
+namespace depth_greater {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x06;
+}
+namespace early_tests {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x61;
+}
+namespace buffer_write {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int written_colors_Binding = 2;
+  static constexpr int written_colors_Set = 0;
+  static constexpr int FragmentProperties = 0x80;
+}
+namespace atomic_counter {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int counters_Binding = 3;
+  static constexpr int counters_Set = 0;
+  static constexpr int FragmentProperties = 0x80;
+}
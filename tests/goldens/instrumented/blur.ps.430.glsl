@@ -0,0 +1,56 @@
+#version 430
+
+#ifndef SPIRV_CROSS_CONSTANT_ID_0
+#define SPIRV_CROSS_CONSTANT_ID_0 1u
+#endif
+const uint kernelRadius = SPIRV_CROSS_CONSTANT_ID_0;
+const uint _48[7] = uint[](1u, 4u, 9u, 18u, 29u, 46u, 63u);
+
+layout(binding = 0, std140) uniform type_BlurData
+{
+    vec4 samples[63];
+} BlurData;
+
+layout(binding = 0, std430) buffer type_ngf_counters
+{
+    uint counters[];
+} ngf_counters;
+
+layout(binding = 0) uniform sampler2D tex_bilinearSamp;
+
+layout(location = 0) in vec2 in_var_ATTR0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    uint _80 = atomicAdd(ngf_counters.counters[0u], 1u);
+    vec4 _52;
+    uint _55;
+    _52 = vec4(0.0);
+    _55 = 0u;
+    for (;;)
+    {
+        uint _82 = atomicAdd(ngf_counters.counters[1u], 1u);
+        if (_55 < _48[kernelRadius])
+        {
+            uint _84 = atomicAdd(ngf_counters.counters[2u], 1u);
+            _52 += (texture(tex_bilinearSamp, in_var_ATTR0 + BlurData.samples[_55].xy) * BlurData.samples[_55].z);
+            _55++;
+            continue;
+        }
+        else
+        {
+            break;
+        }
+    }
+    uint _86 = atomicAdd(ngf_counters.counters[3u], 1u);
+    out_var_SV_TARGET = _52;
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 1) : 0
+(0 2) : 0
+(0 3) : 0
+(1 0) : 0
+(-1 -1) : -1
+**/
@@ -0,0 +1,32 @@
+#version 430
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+const vec4 _31[3] = vec4[](vec4(-1.0, -1.0, 0.0, 1.0), vec4(3.0, -1.0, 0.0, 1.0), vec4(-1.0, 3.0, 0.0, 1.0));
+const vec2 _35[3] = vec2[](vec2(0.0), vec2(2.0, 0.0), vec2(0.0, 2.0));
+
+layout(binding = 0, std430) buffer type_ngf_counters
+{
+    uint counters[];
+} ngf_counters;
+
+layout(location = 0) out vec2 out_var_ATTRIBUTE0;
+
+void main()
+{
+    uint _55 = atomicAdd(ngf_counters.counters[4u], 1u);
+    uint _40 = uint(gl_VertexID) % 3u;
+    gl_Position = _31[_40] * 1.0;
+    out_var_ATTRIBUTE0 = _35[_40];
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 1) : 0
+(0 2) : 0
+(0 3) : 0
+(1 0) : 0
+(-1 -1) : -1
+**/
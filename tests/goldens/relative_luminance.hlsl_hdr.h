@@ -3,16 +3,20 @@
 namespace relative_luminance {
   static constexpr int img_Binding = 0;
   static constexpr int img_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
 namespace relative_luminance_srgb_texture {
   static constexpr int img_Binding = 0;
   static constexpr int img_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
 namespace relative_luminance_srgb_framebuffer {
   static constexpr int img_Binding = 0;
   static constexpr int img_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
 namespace relative_luminance_srgb_texture_and_framebuffer {
   static constexpr int img_Binding = 0;
   static constexpr int img_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
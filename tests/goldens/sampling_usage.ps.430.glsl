@@ -0,0 +1,26 @@
+#version 430
+
+layout(binding = 0) uniform sampler2D lut_SPIRV_Cross_DummySampler;
+layout(binding = 1) uniform sampler2D albedo_bilinear;
+layout(binding = 2) uniform sampler2D ssao_bilinear;
+layout(binding = 3) uniform sampler2DShadow shadowmap_shadow_cmp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    int _54 = int(uint(textureQueryLevels(lut_SPIRV_Cross_DummySampler)) - 1u);
+    out_var_SV_TARGET = (texelFetch(lut_SPIRV_Cross_DummySampler, ivec3(int(texture(albedo_bilinear, in_var_ATTRIBUTE0).x * float(uvec2(textureSize(lut_SPIRV_Cross_DummySampler, int(0u))).x)), 0, _54).xy, _54) * dot(textureGather(ssao_bilinear, in_var_ATTRIBUTE0, 0), vec4(0.25))) * textureLod(shadowmap_shadow_cmp, vec3(in_var_ATTRIBUTE0, gl_FragCoord.z), 0.0);
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 1
+(0 2) : 2
+(0 3) : 3
+(0 4) : 4
+(0 5) : 0
+(0 6) : 1
+(-1 -1) : -1
+**/
@@ -0,0 +1,34 @@
+#version 430
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+const vec4 _36[3] = vec4[](vec4(-1.0, -1.0, 0.0, 1.0), vec4(3.0, -1.0, 0.0, 1.0), vec4(-1.0, 3.0, 0.0, 1.0));
+const vec2 _40[3] = vec2[](vec2(0.0), vec2(2.0, 0.0), vec2(0.0, 2.0));
+
+layout(binding = 0) uniform sampler2D heightmap_bilinear;
+
+layout(location = 0) out vec2 out_var_ATTRIBUTE0;
+
+void main()
+{
+    uint _45 = uint(gl_VertexID) % 3u;
+    vec4 _48 = _36[_45] * 1.0;
+    vec4 _58 = _48;
+    _58.z = _48.z + textureLod(heightmap_bilinear, _40[_45], 0.0).x;
+    gl_Position = _58;
+    out_var_ATTRIBUTE0 = _40[_45];
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 1
+(0 2) : 2
+(0 3) : 3
+(0 4) : 4
+(0 5) : 0
+(0 6) : 1
+(-1 -1) : -1
+**/
@@ -5,4 +5,5 @@ namespace simple_texture {
   static constexpr int tex_Set = 0;
   static constexpr int samp_Binding = 2;
   static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
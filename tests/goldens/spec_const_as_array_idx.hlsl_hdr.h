@@ -7,4 +7,7 @@ namespace blur {
   static constexpr int tex_Set = 0;
   static constexpr int bilinearSamp_Binding = 3;
   static constexpr int bilinearSamp_Set = 0;
+  static constexpr int BlurData_Size = 1008;
+  static constexpr int BlurData_samples_Offset = 0;
+  static constexpr int FragmentProperties = 0x40;
 }
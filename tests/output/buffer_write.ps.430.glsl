@@ -0,0 +1,25 @@
+#version 430
+
+layout(binding = 0, std430) buffer type_RWStructuredBuffer_v4float
+{
+    vec4 _m0[];
+} written_colors;
+
+layout(binding = 0) uniform sampler2D tex_samp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    vec4 _34 = texture(tex_samp, in_var_ATTRIBUTE0);
+    written_colors._m0[uint(gl_FragCoord.x)] = _34;
+    out_var_SV_TARGET = _34;
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(0 2) : 0
+(-1 -1) : -1
+**/
@@ -0,0 +1,24 @@
+#version 430
+
+layout(binding = 0, std430) buffer type_RWByteAddressBuffer
+{
+    uint _m0[];
+} counters;
+
+layout(binding = 0) uniform sampler2D tex_samp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    uint _31 = atomicAdd(counters._m0[0u], 1u);
+    out_var_SV_TARGET = texture(tex_samp, in_var_ATTRIBUTE0) * float(_31);
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(0 3) : 0
+(-1 -1) : -1
+**/
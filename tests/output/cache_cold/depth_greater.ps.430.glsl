@@ -0,0 +1,20 @@
+#version 430
+layout(depth_greater) out float gl_FragDepth;
+
+layout(binding = 0) uniform sampler2D tex_samp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    vec4 _28 = texture(tex_samp, in_var_ATTRIBUTE0);
+    out_var_SV_TARGET = _28;
+    gl_FragDepth = gl_FragCoord.z + _28.w;
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(-1 -1) : -1
+**/
@@ -0,0 +1,30 @@
+#version 430
+
+layout(binding = 0, std140) uniform type_FrameParams
+{
+    vec4 tint;
+    float scale;
+} FrameParams;
+
+layout(binding = 0, std430) readonly buffer type_StructuredBuffer_v4float
+{
+    vec4 _m0[];
+} palette;
+
+layout(binding = 0) uniform sampler2D albedo_bilinear;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    out_var_SV_TARGET = (texture(albedo_bilinear, in_var_ATTRIBUTE0) * FrameParams.tint) * palette._m0[0u];
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(0 2) : 0
+(1 0) : 0
+(-1 -1) : -1
+**/
@@ -0,0 +1,9 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace wave_intrinsics {
+  static constexpr int tex_Binding = 0;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 1;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
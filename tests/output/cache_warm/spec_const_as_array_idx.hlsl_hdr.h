@@ -0,0 +1,13 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace blur {
+  static constexpr int BlurData_Binding = 1;
+  static constexpr int BlurData_Set = 0;
+  static constexpr int tex_Binding = 2;
+  static constexpr int tex_Set = 0;
+  static constexpr int bilinearSamp_Binding = 3;
+  static constexpr int bilinearSamp_Set = 0;
+  static constexpr int BlurData_Size = 1008;
+  static constexpr int BlurData_samples_Offset = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
@@ -0,0 +1,33 @@
+#version 430
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+layout(binding = 0, std140) uniform type_MaterialParams
+{
+    float opacity;
+    vec4 base_color;
+    vec3 emissive;
+    float roughness;
+    vec2 uv_scale;
+    layout(row_major) mat4 uv_transform;
+    float weights[3];
+    float metallic;
+} MaterialParams;
+
+layout(location = 0) in vec4 in_var_ATTR0;
+layout(location = 1) in vec2 in_var_ATTR1;
+layout(location = 0) out vec2 out_var_ATTR0;
+
+void main()
+{
+    gl_Position = in_var_ATTR0;
+    out_var_ATTR0 = (vec4(in_var_ATTR1 * MaterialParams.uv_scale, 0.0, 1.0) * MaterialParams.uv_transform).xy;
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(-1 -1) : -1
+**/
@@ -0,0 +1,3 @@
+//T: broken vs:VSMain ps:PSMain
+float4 VSMain() : SV_Position { return 0; }
+float4 PSMain() : SV_Target { return undefined_thing; }
@@ -0,0 +1,29 @@
+#version 430
+#ifdef GL_ARB_shader_draw_parameters
+#extension GL_ARB_shader_draw_parameters : enable
+#endif
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+#ifdef GL_ARB_shader_draw_parameters
+#define SPIRV_Cross_BaseInstance gl_BaseInstanceARB
+#else
+uniform int SPIRV_Cross_BaseInstance;
+#endif
+#ifdef GL_ARB_shader_draw_parameters
+#define SPIRV_Cross_BaseVertex gl_BaseVertexARB
+#else
+uniform int SPIRV_Cross_BaseVertex;
+#endif
+
+void main()
+{
+    gl_Position = vec4(float(uint(gl_VertexID) - uint(SPIRV_Cross_BaseVertex)), float(uint((gl_InstanceID + SPIRV_Cross_BaseInstance)) - uint(SPIRV_Cross_BaseInstance)), 0.0, 1.0);
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(-1 -1) : -1
+**/
@@ -0,0 +1,8 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace fullscreen_triangle_crlf {
+  static constexpr int FragmentProperties = 0x40;
+}
+namespace fullscreen_triangle_crlf_vertexonly {
+  static constexpr int FragmentProperties = 0x00;
+}
@@ -0,0 +1,22 @@
+#version 430
+
+layout(binding = 0) uniform sampler2D tex_samp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    vec4 _28 = texture(tex_samp, in_var_ATTRIBUTE0);
+    if ((_28.w - 0.5) < 0.0)
+    {
+        discard;
+    }
+    out_var_SV_TARGET = _28;
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(-1 -1) : -1
+**/
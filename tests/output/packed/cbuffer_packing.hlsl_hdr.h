@@ -0,0 +1,16 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace cbuffer_packing {
+  static constexpr int MaterialParams_Binding = 0;
+  static constexpr int MaterialParams_Set = 0;
+  static constexpr int MaterialParams_Size = 160;
+  static constexpr int MaterialParams_uv_transform_Offset = 0;
+  static constexpr int MaterialParams_weights_Offset = 64;
+  static constexpr int MaterialParams_base_color_Offset = 112;
+  static constexpr int MaterialParams_emissive_Offset = 128;
+  static constexpr int MaterialParams_opacity_Offset = 140;
+  static constexpr int MaterialParams_uv_scale_Offset = 144;
+  static constexpr int MaterialParams_roughness_Offset = 152;
+  static constexpr int MaterialParams_metallic_Offset = 156;
+  static constexpr int FragmentProperties = 0x40;
+}
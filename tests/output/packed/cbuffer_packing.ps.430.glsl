@@ -0,0 +1,26 @@
+#version 430
+
+layout(binding = 0, std140) uniform type_MaterialParams
+{
+    layout(row_major) mat4 uv_transform;
+    float weights[3];
+    vec4 base_color;
+    vec3 emissive;
+    float opacity;
+    vec2 uv_scale;
+    float roughness;
+    float metallic;
+} MaterialParams;
+
+layout(location = 0) in vec2 in_var_ATTR0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    out_var_SV_TARGET = vec4((MaterialParams.base_color.xyz * ((MaterialParams.weights[0] + (MaterialParams.weights[1] * MaterialParams.roughness)) + (MaterialParams.weights[2] * MaterialParams.metallic))) + MaterialParams.emissive, MaterialParams.opacity);
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(-1 -1) : -1
+**/
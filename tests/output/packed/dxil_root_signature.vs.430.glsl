@@ -0,0 +1,32 @@
+#version 430
+
+out gl_PerVertex
+{
+    vec4 gl_Position;
+};
+
+const vec4 _35[3] = vec4[](vec4(-1.0, -1.0, 0.0, 1.0), vec4(3.0, -1.0, 0.0, 1.0), vec4(-1.0, 3.0, 0.0, 1.0));
+const vec2 _39[3] = vec2[](vec2(0.0), vec2(2.0, 0.0), vec2(0.0, 2.0));
+
+layout(binding = 0, std140) uniform type_FrameParams
+{
+    vec4 tint;
+    float scale;
+} FrameParams;
+
+layout(location = 0) out vec2 out_var_ATTRIBUTE0;
+
+void main()
+{
+    uint _46 = uint(gl_VertexID) % 3u;
+    gl_Position = _35[_46] * FrameParams.scale;
+    out_var_ATTRIBUTE0 = _39[_46];
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(0 2) : 0
+(1 0) : 0
+(-1 -1) : -1
+**/
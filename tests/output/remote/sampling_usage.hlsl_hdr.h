@@ -0,0 +1,19 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace sampling_usage {
+  static constexpr int albedo_Binding = 0;
+  static constexpr int albedo_Set = 0;
+  static constexpr int heightmap_Binding = 1;
+  static constexpr int heightmap_Set = 0;
+  static constexpr int ssao_Binding = 2;
+  static constexpr int ssao_Set = 0;
+  static constexpr int lut_Binding = 3;
+  static constexpr int lut_Set = 0;
+  static constexpr int shadowmap_Binding = 4;
+  static constexpr int shadowmap_Set = 0;
+  static constexpr int bilinear_Binding = 5;
+  static constexpr int bilinear_Set = 0;
+  static constexpr int shadow_cmp_Binding = 6;
+  static constexpr int shadow_cmp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
@@ -0,0 +1,21 @@
+#version 430
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#extension GL_KHR_shader_subgroup_ballot : require
+#extension GL_KHR_shader_subgroup_quad : require
+
+layout(binding = 0) uniform sampler2D tex_samp;
+
+layout(location = 0) in vec2 in_var_ATTRIBUTE0;
+layout(location = 0) out vec4 out_var_SV_TARGET;
+
+void main()
+{
+    vec4 _31 = texture(tex_samp, in_var_ATTRIBUTE0);
+    out_var_SV_TARGET = vec4(subgroupAdd(_31.x), uintBitsToFloat(subgroupBroadcastFirst(floatBitsToUint(_31.y))), float(uint(bitCount(subgroupBallot(_31.z > 0.5).x))), subgroupQuadSwapHorizontal(_31.w));
+}
+
+/**NGF_NATIVE_BINDING_MAP
+(0 0) : 0
+(0 1) : 0
+(-1 -1) : -1
+**/
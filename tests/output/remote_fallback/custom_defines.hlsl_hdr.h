@@ -0,0 +1,16 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace simple_texture_def1 {
+  static constexpr int tex1_Binding = 1;
+  static constexpr int tex1_Set = 0;
+  static constexpr int samp_Binding = 2;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
+namespace simple_texture_def2 {
+  static constexpr int tex2_Binding = 1;
+  static constexpr int tex2_Set = 0;
+  static constexpr int samp_Binding = 2;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
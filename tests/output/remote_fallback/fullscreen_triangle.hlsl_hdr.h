@@ -0,0 +1,5 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace fullscreen_triangle {
+  static constexpr int FragmentProperties = 0x40;
+}
@@ -0,0 +1,9 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace simple_texture {
+  static constexpr int tex_Binding = 1;
+  static constexpr int tex_Set = 0;
+  static constexpr int samp_Binding = 2;
+  static constexpr int samp_Set = 0;
+  static constexpr int FragmentProperties = 0x40;
+}
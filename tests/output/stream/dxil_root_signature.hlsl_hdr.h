@@ -0,0 +1,16 @@
+/*auto-generated, do not edit*/
+#pragma once
+namespace dxil_root_signature {
+  static constexpr int FrameParams_Binding = 0;
+  static constexpr int FrameParams_Set = 0;
+  static constexpr int albedo_Binding = 1;
+  static constexpr int albedo_Set = 0;
+  static constexpr int bilinear_Binding = 2;
+  static constexpr int bilinear_Set = 0;
+  static constexpr int palette_Binding = 0;
+  static constexpr int palette_Set = 1;
+  static constexpr int FrameParams_Size = 20;
+  static constexpr int FrameParams_tint_Offset = 0;
+  static constexpr int FrameParams_scale_Offset = 16;
+  static constexpr int FragmentProperties = 0x40;
+}
@@ -0,0 +1,10 @@
+//T: dead-texture vs:VSMain ps:PSMain
+#include "/root/repo/tests/source_hlsl/inc/triangle.hlsl"
+Texture2D tex : register(t0, space0);
+Texture2D dead_tex : register(t2, space0);
+SamplerState samp : register(s1, space0);
+Triangle_PSInput VSMain(uint vid : SV_VertexID) { return Triangle(vid, 1.0); }
+float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {
+  float4 unused = dead_tex.Sample(samp, ps_in.texcoord);
+  return tex.Sample(samp, ps_in.texcoord);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+//T: cbuffer_packing ps:PSMain vs:VSMain
+
+cbuffer MaterialParams : register(b0) {
+  float opacity;
+  float4 base_color;
+  float3 emissive;
+  float roughness;
+  float2 uv_scale;
+  float4x4 uv_transform;
+  float weights[3];
+  float metallic;
+};
+
+struct VSOutput {
+  float4 position : SV_POSITION;
+  float2 uv : ATTR0;
+};
+
+VSOutput VSMain(float4 position : ATTR0, float2 uv : ATTR1) {
+  VSOutput output;
+  output.position = position;
+  output.uv = mul(uv_transform, float4(uv * uv_scale, 0.0, 1.0)).xy;
+  return output;
+}
+
+float4 PSMain(VSOutput input) : SV_TARGET {
+  const float w = weights[0] + weights[1] * roughness + weights[2] * metallic;
+  return float4(base_color.rgb * w + emissive, opacity);
+}
@@ -0,0 +1,22 @@
+//T: draw_parameters vs:VSMain ps:PSMain
+
+// Base vertex and base instance require Metal 1.1, while the test cases are
+// compiled for Metal 1.0. The runner compiles this file separately for
+// targets that support them.
+
+struct VSInput {
+  uint vid : SV_VertexID;
+  uint iid : SV_InstanceID;
+  [[vk::builtin("BaseVertex")]] uint base_vertex : BASE_VERTEX;
+  [[vk::builtin("BaseInstance")]] uint base_instance : BASE_INSTANCE;
+};
+
+float4 VSMain(VSInput vs_in) : SV_POSITION {
+  const uint vertex_in_draw = vs_in.vid - vs_in.base_vertex;
+  const uint instance_in_draw = vs_in.iid - vs_in.base_instance;
+  return float4(float(vertex_in_draw), float(instance_in_draw), 0.0, 1.0);
+}
+
+float4 PSMain() : SV_TARGET {
+  return float4(1.0, 0.0, 0.0, 1.0);
+}
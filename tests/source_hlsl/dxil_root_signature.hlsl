@@ -0,0 +1,22 @@
+// T: dxil_root_signature vs:VSMain ps:PSMain
+
+#include "inc/triangle.hlsl"
+
+// Resources are declared with explicit registers and spaces, so that the
+// DXIL registers match the SPIR-V bindings.
+cbuffer FrameParams : register(b0, space0) {
+  float4 tint;
+  float scale;
+};
+
+Texture2D albedo : register(t1, space0);
+StructuredBuffer<float4> palette : register(t0, space1);
+SamplerState bilinear : register(s2, space0);
+
+Triangle_PSInput VSMain(uint vid : SV_VertexID) {
+  return Triangle(vid, scale);
+}
+
+float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {
+  return albedo.Sample(bilinear, ps_in.texcoord) * tint * palette[0];
+}
@@ -0,0 +1,53 @@
+//T: alpha_tested vs:VSMain ps:AlphaTestedPS
+//T: depth_greater vs:VSMain ps:DepthGreaterPS
+//T: early_tests vs:VSMain ps:EarlyTestsPS
+//T: buffer_write vs:VSMain ps:BufferWritePS
+//T: atomic_counter vs:VSMain ps:AtomicCounterPS
+
+#include "inc/triangle.hlsl"
+
+[[vk::binding(0, 0)]] uniform Texture2D tex;
+[[vk::binding(1, 0)]] uniform sampler samp;
+[[vk::binding(2, 0)]] RWStructuredBuffer<float4> written_colors;
+[[vk::binding(3, 0)]] RWByteAddressBuffer counters;
+
+Triangle_PSInput VSMain(uint vid : SV_VertexID) {
+  return Triangle(vid, 1.0);
+}
+
+float4 AlphaTestedPS(Triangle_PSInput ps_in) : SV_TARGET {
+  const float4 color = tex.Sample(samp, ps_in.texcoord);
+  clip(color.a - 0.5);
+  return color;
+}
+
+struct DepthGreater_PSOutput {
+  float4 color : SV_TARGET;
+  float depth : SV_DepthGreaterEqual;
+};
+
+DepthGreater_PSOutput DepthGreaterPS(Triangle_PSInput ps_in) {
+  DepthGreater_PSOutput ps_out;
+  ps_out.color = tex.Sample(samp, ps_in.texcoord);
+  ps_out.depth = ps_in.position.z + ps_out.color.a;
+  return ps_out;
+}
+
+[earlydepthstencil]
+float4 EarlyTestsPS(Triangle_PSInput ps_in) : SV_TARGET {
+  const float4 color = tex.Sample(samp, ps_in.texcoord);
+  if (color.a < 0.5) discard;
+  return color;
+}
+
+float4 BufferWritePS(Triangle_PSInput ps_in) : SV_TARGET {
+  const float4 color = tex.Sample(samp, ps_in.texcoord);
+  written_colors[uint(ps_in.position.x)] = color;
+  return color;
+}
+
+float4 AtomicCounterPS(Triangle_PSInput ps_in) : SV_TARGET {
+  uint previous;
+  counters.InterlockedAdd(0, 1, previous);
+  return tex.Sample(samp, ps_in.texcoord) * float(previous);
+}
@@ -0,0 +1,28 @@
+//T: sampling_usage vs:VSMain ps:PSMain
+
+#include "inc/triangle.hlsl"
+
+[[vk::binding(0, 0)]] uniform Texture2D albedo;
+[[vk::binding(1, 0)]] uniform Texture2D heightmap;
+[[vk::binding(2, 0)]] uniform Texture2D ssao;
+[[vk::binding(3, 0)]] uniform Texture2D lut;
+[[vk::binding(4, 0)]] uniform Texture2D shadowmap;
+[[vk::binding(5, 0)]] uniform sampler bilinear;
+[[vk::binding(6, 0)]] uniform SamplerComparisonState shadow_cmp;
+
+Triangle_PSInput VSMain(uint vid : SV_VertexID) {
+  Triangle_PSInput ps_in = Triangle(vid, 1.0);
+  ps_in.position.z += heightmap.SampleLevel(bilinear, ps_in.texcoord, 0.0).r;
+  return ps_in;
+}
+
+float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {
+  uint width, height, levels;
+  lut.GetDimensions(0, width, height, levels);
+  const float4 color = albedo.Sample(bilinear, ps_in.texcoord);
+  const float4 occlusion = ssao.Gather(bilinear, ps_in.texcoord);
+  const float4 grade = lut.Load(int3(int(color.r * width), 0, levels - 1));
+  const float shadow =
+      shadowmap.SampleCmpLevelZero(shadow_cmp, ps_in.texcoord, ps_in.position.z);
+  return grade * dot(occlusion, 0.25) * shadow;
+}
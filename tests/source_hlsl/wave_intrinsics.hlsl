@@ -0,0 +1,23 @@
+//T: wave_intrinsics vs:VSMain ps:PSMain
+// test-targets: gl430 gles310 msl21
+
+// Wave intrinsics can't be expressed in Metal 1.0, which the test cases are
+// compiled for by default (see wave_intrinsics_msl10_FAIL.hlsl).
+
+#include "inc/triangle.hlsl"
+
+Texture2D tex : register(t0, space0);
+SamplerState samp : register(s1, space0);
+
+Triangle_PSInput VSMain(uint vid : SV_VertexID) {
+  return Triangle(vid, 1.0);
+}
+
+float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {
+  const float4 color = tex.Sample(samp, ps_in.texcoord);
+  const float sum = WaveActiveSum(color.r);
+  const uint first = WaveReadLaneFirst(asuint(color.g));
+  const uint4 ballot = WaveActiveBallot(color.b > 0.5);
+  const float across = QuadReadAcrossX(color.a);
+  return float4(sum, asfloat(first), countbits(ballot.x), across);
+}
@@ -0,0 +1,14 @@
+//T: wave_intrinsics_msl10 vs:VSMain ps:PSMain
+
+// Metal 1.0 can't express wave intrinsics, so this fails for the msl10
+// target that the test cases are compiled for.
+
+#include "inc/triangle.hlsl"
+
+Triangle_PSInput VSMain(uint vid : SV_VertexID) {
+  return Triangle(vid, 1.0);
+}
+
+float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {
+  return WaveActiveSum(ps_in.texcoord.x);
+}
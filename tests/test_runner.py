@@ -1,4 +1,92 @@
-import os, sys, shutil, pathlib, logging, subprocess, filecmp, json, platform
+import os, sys, shutil, pathlib, logging, subprocess, filecmp, json, platform, signal, socket, struct, time, hashlib, queue, threading
+
+# Test cases are compiled for msl10 and gl430 unless they list their own targets
+# in a "// test-targets:" line.
+def test_targets(input_file):
+  for line in input_file.read_text().splitlines():
+    if line.startswith("// test-targets:"):
+      return line.split(":", 1)[1].split()
+  return ["msl10", "gl430"]
+
+def compiler_cmdline(compiler_binary, input_file, out_dir, extra_args = []):
+  targets = [arg for target in test_targets(input_file) for arg in ("-t", target)]
+  return [str(compiler_binary), str(input_file)] + targets + ["-O", str(out_dir), "-h", str(input_file.name) + "_hdr.h"] + extra_args + ["--", "-O3", "-Wno-ignored-attributes", "-fspv-target-env=vulkan1.1"]
+
+def get_free_port():
+  with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+    s.bind(("127.0.0.1", 0))
+    return s.getsockname()[1]
+
+# Collects the lines written by a process in the background, so that tests can
+# wait for a particular line without blocking forever.
+class line_reader:
+  def __init__(self, stream):
+    self.lines = queue.Queue()
+    threading.Thread(target = lambda: [self.lines.put(line) for line in stream], daemon = True).start()
+
+  # Returns the next line starting with the given prefix, or None if there is
+  # no such line within the timeout.
+  def wait_for(self, prefix, timeout = 60):
+    deadline = time.monotonic() + timeout
+    while True:
+      try:
+        line = self.lines.get(timeout = max(deadline - time.monotonic(), 0))
+      except queue.Empty:
+        return None
+      if line.startswith(prefix):
+        return line
+
+def compare_outputs(LOG, reference_dir, output_dir, ignored_suffixes):
+  ok = True
+  for reference in reference_dir.glob('*'):
+    if reference.is_dir() or reference.suffix in ignored_suffixes:
+      continue
+    try:
+      if not filecmp.cmp(str(output_dir / reference.name), str(reference), shallow = False):
+        LOG.critical("Output mismatch in " + output_dir.name + ": " + reference.name)
+        ok = False
+    except FileNotFoundError:
+      LOG.critical("File not found in " + output_dir.name + ": " + reference.name)
+      ok = False
+  return ok
+
+def run_all_test_cases(compiler_binary, source_hlsl, out_dir, extra_args):
+  out_dir.mkdir(parents=True)
+  for input_file in source_hlsl.glob("*.hlsl"):
+    run_result = subprocess.run(
+        compiler_cmdline(compiler_binary, input_file, out_dir, extra_args),
+        stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+    (out_dir / (input_file.stem + '.stdout')).write_bytes(run_result.stdout)
+    (out_dir / (input_file.stem + '.stderr')).write_bytes(run_result.stderr)
+
+def read_output_stream(stream, out_dir):
+  offset = 0
+  while offset < len(stream):
+    (frame_size,) = struct.unpack('>I', stream[offset:offset + 4])
+    frame = stream[offset + 4:offset + 4 + frame_size]
+    offset += 4 + frame_size
+    if frame_size == 0:
+      return offset == len(stream)
+    (kind, name_size) = struct.unpack('>II', frame[0:8])
+    name = frame[8:8 + name_size].decode('utf-8')
+    (data_size,) = struct.unpack('>I', frame[8 + name_size:12 + name_size])
+    (out_dir / name).write_bytes(frame[12 + name_size:12 + name_size + data_size])
+  return False
+
+def run_all_test_cases_streamed(LOG, compiler_binary, source_hlsl, out_dir):
+  out_dir.mkdir(parents=True)
+  ok = True
+  for input_file in source_hlsl.glob("*.hlsl"):
+    if input_file.stem.endswith("_FAIL"):
+      continue
+    cmdline = compiler_cmdline(compiler_binary, input_file, out_dir, ["--emit-stream"])
+    cmdline[1] = "-"
+    run_result = subprocess.run(cmdline, input = input_file.read_bytes(), cwd = str(source_hlsl),
+                                stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+    if run_result.returncode != 0 or not read_output_stream(run_result.stdout, out_dir):
+      LOG.critical("Malformed output stream for " + input_file.name)
+      ok = False
+  return ok
 
 def main(argv):
   logging.basicConfig(format='%(asctime)-15s %(message)s')
@@ -26,6 +114,10 @@ def main(argv):
   if not jsonizer_binary.is_file():
     LOG.critical("missing jsonizer binary")
     sys.exit(1)
+  listener_binary = cwd / '..' / 'samples' / ('hot_reload_listener' + exe_ext)
+  if not listener_binary.is_file():
+    LOG.critical("missing hot reload listener binary")
+    sys.exit(1)
 
   LOG.info("Cleaning up old output")
   out_dir = cwd / 'output'
@@ -40,7 +132,7 @@ def main(argv):
     should_fail = test_case_name.endswith("_FAIL")
     try:
       run_result = subprocess.run(
-          [str(compiler_binary), str(input_file) , "-t", "msl10", "-t", "gl430", "-O", str(out_dir), "-h", str(input_file.name) + "_hdr.h", "--", "-O3", "-Wno-ignored-attributes"],
+          compiler_cmdline(compiler_binary, input_file, out_dir),
           stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60, universal_newlines = True)
       if not should_fail and run_result.returncode != 0:
         failed_run_results[test_case_name] = "Process exited with nonzero exit code"
@@ -82,6 +174,8 @@ def main(argv):
   filecmp.clear_cache()
   error = False
   for golden in goldens.glob('*'):
+    if golden.is_dir():
+      continue
     try:
       if not filecmp.cmp(str(out_dir / (golden.name)), str(golden), shallow = False):
         LOG.critical("File mismatch: " + golden.name)
@@ -89,6 +183,610 @@ def main(argv):
     except FileNotFoundError:
       LOG.critical("File not found in output: " + golden.name)
       error = True
+
+  LOG.info("Running test cases through a local worker")
+  worker_address = "127.0.0.1:" + str(get_free_port())
+  worker = subprocess.Popen([str(compiler_binary), "--worker", worker_address], stderr = subprocess.DEVNULL)
+  try:
+    time.sleep(0.5)
+    # The worker should drop a connection that announces an oversized frame
+    # and keep serving others.
+    with socket.create_connection(("127.0.0.1", int(worker_address.split(':')[1])), timeout = 10) as s:
+      s.sendall(struct.pack('>I', 0xffffffff))
+      if s.recv(1) != b'' or worker.poll() is not None:
+        LOG.critical("Worker didn't drop a connection with an oversized frame")
+        error = True
+    remote_out_dir = out_dir / 'remote'
+    run_all_test_cases(compiler_binary, source_hlsl, remote_out_dir, ["-w", worker_address, "-w", worker_address])
+    # A worker that accepts connections but never responds should be given
+    # up on, leaving its jobs to the working one.
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as hung_worker:
+      hung_worker.bind(("127.0.0.1", 0))
+      hung_worker.listen()
+      hung_worker_address = "127.0.0.1:" + str(hung_worker.getsockname()[1])
+      hung_out_dir = out_dir / 'remote_hung'
+      run_all_test_cases(compiler_binary, source_hlsl, hung_out_dir,
+                         ["-w", hung_worker_address, "-w", worker_address, "--compile-timeout", "1000"])
+  finally:
+    worker.kill()
+  error = not compare_outputs(LOG, out_dir, remote_out_dir, ['.json']) or error
+  error = not compare_outputs(LOG, out_dir, hung_out_dir, ['.json', '.stderr']) or error
+
+  LOG.info("Falling back to local compilation without workers")
+  local_fallback_out_dir = out_dir / 'remote_fallback'
+  run_all_test_cases(compiler_binary, source_hlsl, local_fallback_out_dir, ["-w", worker_address])
+  error = not compare_outputs(LOG, out_dir, local_fallback_out_dir, ['.json', '.stderr']) or error
+
+  LOG.info("Running test cases against a local cache server")
+  cache_url = "http://127.0.0.1:" + str(get_free_port()) + "/cache"
+  cache_server = subprocess.Popen([sys.executable, str(cwd / '..' / 'samples' / 'cache_server.py'),
+                                   cache_url.split(':')[2].split('/')[0], str(out_dir / 'cache_storage')])
+  try:
+    time.sleep(0.5)
+    cold_out_dir = out_dir / 'cache_cold'
+    warm_out_dir = out_dir / 'cache_warm'
+    run_all_test_cases(compiler_binary, source_hlsl, cold_out_dir, ["--cache-url", cache_url])
+    run_all_test_cases(compiler_binary, source_hlsl, warm_out_dir, ["--cache-url", cache_url])
+  finally:
+    cache_server.kill()
+  error = not compare_outputs(LOG, out_dir, cold_out_dir, ['.json', '.stdout']) or error
+  error = not compare_outputs(LOG, out_dir, warm_out_dir, ['.json', '.stdout', '.stderr']) or error
+  for stdout_file in warm_out_dir.glob('*.stdout'):
+    stats = stdout_file.read_text()
+    if stats and not " 0 misses" in stats:
+      LOG.critical("Expected only cache hits: " + stdout_file.name)
+      error = True
+
+  LOG.info("Rejecting truncated responses from the cache server")
+  # The server promises more than it sends, so its artifacts must neither be
+  # used nor saved to the local cache.
+  truncating_server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+  truncating_server.bind(("127.0.0.1", 0))
+  truncating_server.listen()
+  truncated_body = b'truncated!'
+  def serve_truncated():
+    while True:
+      try:
+        conn, _ = truncating_server.accept()
+      except OSError:
+        return
+      with conn:
+        request = b''
+        while b'\r\n\r\n' not in request:
+          data = conn.recv(65536)
+          if not data: break
+          request += data
+        conn.sendall(b'HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\n' + truncated_body)
+  threading.Thread(target = serve_truncated, daemon = True).start()
+  truncated_out_dir = out_dir / 'cache_truncated'
+  truncated_cache_dir = out_dir / 'cache_truncated_storage'
+  truncated_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'), "-t", "gl430",
+                                     "-O", str(truncated_out_dir), "--cache-dir", str(truncated_cache_dir),
+                                     "--cache-url", "http://127.0.0.1:" + str(truncating_server.getsockname()[1]) + "/cache"],
+                                    stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  truncating_server.close()
+  if truncated_result.returncode != 0 or \
+     any(f.read_bytes() == truncated_body for f in truncated_cache_dir.glob('*/*')):
+    LOG.critical("Truncated response from the cache server was accepted")
+    error = True
+  for truncated_file in truncated_out_dir.glob('*.glsl'):
+    if truncated_file.read_bytes() != (out_dir / truncated_file.name).read_bytes():
+      LOG.critical("Output built after a truncated cache response doesn't match: " + truncated_file.name)
+      error = True
+  # SPIR-V blobs that aren't made of whole words are corrupt, and must be
+  # rebuilt rather than used.
+  for cached_file in truncated_cache_dir.glob('*/*'):
+    cached = cached_file.read_bytes()
+    if cached[0:4] == b'\x03\x02\x23\x07':
+      cached_file.write_bytes(cached[:-1])
+  corrupt_out_dir = out_dir / 'cache_corrupt'
+  corrupt_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'), "-t", "gl430",
+                                   "-O", str(corrupt_out_dir), "--cache-dir", str(truncated_cache_dir)],
+                                  stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  if corrupt_result.returncode != 0:
+    LOG.critical("Corrupt SPIR-V in the local cache wasn't rebuilt")
+    error = True
+  for corrupt_file in corrupt_out_dir.glob('*.glsl'):
+    if corrupt_file.read_bytes() != (out_dir / corrupt_file.name).read_bytes():
+      LOG.critical("Output built after finding corrupt SPIR-V in the cache doesn't match: " + corrupt_file.name)
+      error = True
+
+  LOG.info("Running test cases through stdin and stdout")
+  stream_out_dir = out_dir / 'stream'
+  error = not run_all_test_cases_streamed(LOG, compiler_binary, source_hlsl, stream_out_dir) or error
+  error = not compare_outputs(LOG, out_dir, stream_out_dir, ['.json', '.stdout', '.stderr']) or error
+
+  LOG.info("Aliasing identical outputs")
+  alias_out_dir = out_dir / 'alias'
+  alias_out_dir.mkdir(parents=True)
+  alias_input = source_hlsl / 'fullscreen_triangle.hlsl'
+  subprocess.run([str(compiler_binary), str(alias_input), "-t", "msl10", "-t", "msl11", "-t", "msl10ios",
+                  "-O", str(alias_out_dir), "--alias-outputs"], cwd = str(source_hlsl),
+                 stdout = subprocess.PIPE, timeout = 60)
+  alias_json = subprocess.run([str(jsonizer_binary), str(alias_out_dir / 'fullscreen_triangle.pipeline')],
+                              stdout = subprocess.PIPE).stdout
+  aliases = json.loads(alias_json)["aliases"]
+  if len(aliases) != 4:
+    LOG.critical("Expected 4 aliases, got " + str(aliases))
+    error = True
+  for alias, target in aliases.items():
+    if not filecmp.cmp(str(alias_out_dir / alias), str(out_dir / target), shallow = False):
+      LOG.critical("Aliased output mismatch: " + alias)
+      error = True
+
+  LOG.info("Writing outputs to the object store")
+  objects_out_dir = out_dir / 'objects'
+  run_all_test_cases(compiler_binary, source_hlsl, objects_out_dir, ["--object-store"])
+  for metadata_file in objects_out_dir.glob('*.pipeline'):
+    metadata_json = subprocess.run([str(jsonizer_binary), str(metadata_file)], stdout = subprocess.PIPE).stdout
+    for object_ref in json.loads(metadata_json)["objects"]:
+      object_file = objects_out_dir / 'objects' / object_ref["hash"]
+      if not filecmp.cmp(str(object_file), str(out_dir / object_ref["name"]), shallow = False):
+        LOG.critical("Object store mismatch: " + object_ref["name"])
+        error = True
+
+  LOG.info("Packing uniform buffers")
+  packed_out_dir = out_dir / 'packed'
+  run_all_test_cases(compiler_binary, source_hlsl, packed_out_dir, ["--pack-cbuffers"])
+  packed_sizes = {}
+  for metadata_file in packed_out_dir.glob('*.pipeline'):
+    metadata_json = subprocess.run([str(jsonizer_binary), str(metadata_file)], stdout = subprocess.PIPE).stdout
+    unpacked_json = json.loads((out_dir / (metadata_file.stem + '.json')).read_text())
+    unpacked_sizes = { b["name"] : b["size"] for b in unpacked_json["uniform_buffer_layouts"] }
+    for buffer in json.loads(metadata_json)["uniform_buffer_layouts"]:
+      packed_sizes[metadata_file.stem + '.' + buffer["name"]] = buffer["size"]
+      end = 0
+      for member in buffer["members"]:
+        if member["offset"] < end:
+          LOG.critical("Overlapping members in packed buffer " + buffer["name"])
+          error = True
+        end = member["offset"] + member["size"]
+      if buffer["size"] > unpacked_sizes[buffer["name"]]:
+        LOG.critical("Packing made buffer " + buffer["name"] + " larger")
+        error = True
+  if packed_sizes.get("cbuffer_packing.MaterialParams") != 160:
+    LOG.critical("Unexpected packed size of MaterialParams: " + str(packed_sizes.get("cbuffer_packing.MaterialParams")))
+    error = True
+
+  LOG.info("Compiling to DXIL")
+  dxil_out_dir = out_dir / 'dxil'
+  dxil_input = source_hlsl / 'dxil_root_signature.hlsl'
+  subprocess.run([str(compiler_binary), str(dxil_input), "-t", "dxil", "-O", str(dxil_out_dir)],
+                 stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  for stage in ["vs", "ps"]:
+    dxil_file = dxil_out_dir / ('dxil_root_signature.' + stage + '.dxil')
+    dxil = dxil_file.read_bytes() if dxil_file.is_file() else b''
+    if dxil[0:4] != b'DXBC' or struct.unpack('<I', dxil[24:28])[0] != len(dxil):
+      LOG.critical("Malformed DXIL container: " + dxil_file.name)
+      error = True
+  metadata_json = subprocess.run([str(jsonizer_binary), str(dxil_out_dir / 'dxil_root_signature.pipeline')], stdout = subprocess.PIPE).stdout
+  tables = [(t["register_space"], t["is_sampler_table"], [(r["range_type"], r["shader_register"]) for r in t["ranges"]])
+            for t in json.loads(metadata_json)["root_signature"]]
+  if tables != [(0, 0, [(2, 0), (0, 1)]), (0, 1, [(3, 2)]), (1, 0, [(0, 0)])]:
+    LOG.critical("Unexpected root signature: " + str(tables))
+    error = True
+  # Values of SPIR-V specific options must not reach the dxil compiler.
+  if subprocess.run([str(compiler_binary), str(dxil_input), "-t", "dxil", "-t", "spv", "-O", str(out_dir / 'dxil_spirv_options'), "--", "-fvk-bind-globals", "5", "1"],
+                    stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60).returncode != 0:
+    LOG.critical("Compiling to DXIL failed with SPIR-V specific options")
+    error = True
+  # Resources without registers don't match the root signature, and the
+  # technique must fail without writing any of its shaders.
+  mismatched_out_dir = out_dir / 'dxil_mismatched'
+  if subprocess.run([str(compiler_binary), str(source_hlsl / 'simple_texture.hlsl'), "-t", "dxil", "-O", str(mismatched_out_dir)],
+                    stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60).returncode == 0 or \
+     (mismatched_out_dir.is_dir() and any(mismatched_out_dir.iterdir())):
+    LOG.critical("Mismatched DXIL registers weren't rejected before writing outputs")
+    error = True
+  if subprocess.run([str(compiler_binary), str(source_hlsl / 'cbuffer_packing.hlsl'), "-t", "dxil", "--pack-cbuffers", "-O", str(out_dir / 'dxil_packed')],
+                    stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60).returncode == 0:
+    LOG.critical("--pack-cbuffers wasn't rejected for the dxil target")
+    error = True
+
+  LOG.info("Checking wave intrinsics")
+  if "subgroupAdd" not in (out_dir / 'wave_intrinsics.ps.430.glsl').read_text() or \
+     "simd_sum" not in (out_dir / 'wave_intrinsics.ps.21.msl').read_text():
+    LOG.critical("Wave intrinsics weren't translated")
+    error = True
+  metadata_json = subprocess.run([str(jsonizer_binary), str(out_dir / 'wave_intrinsics.pipeline')], stdout = subprocess.PIPE).stdout
+  subgroup_features = json.loads(metadata_json)["subgroup_features"]
+  # basic | arithmetic | ballot | quad, used from the fragment stage.
+  if subgroup_features != { "features": 0x8d, "stage_vis": 2 }:
+    LOG.critical("Unexpected subgroup features: " + str(subgroup_features))
+    error = True
+  # SPIR-V targets Vulkan 1.0 unless told otherwise, which has no wave operations.
+  wave_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'wave_intrinsics.hlsl'),
+                                "-t", "gl430", "-O", str(out_dir / 'wave_vulkan10')],
+                               stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  if wave_result.returncode == 0 or b"-fspv-target-env" not in wave_result.stderr:
+    LOG.critical("Wave intrinsics compiled without raising the target environment")
+    error = True
+
+  LOG.info("Compiling draw parameters")
+  dp_out_dir = out_dir / 'draw_parameters'
+  dp_cmdline = [str(compiler_binary), str(source_hlsl / 'draw_parameters_FAIL.hlsl'),
+                "-t", "gl430", "-t", "msl11", "-t", "msl21ios", "-t", "spv", "-O", str(dp_out_dir)]
+  if subprocess.run(dp_cmdline, stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60).returncode == 0:
+    LOG.critical("Draw parameters were accepted for iOS without --ios-base-vertex")
+    error = True
+  dp_result = subprocess.run(dp_cmdline + ["--ios-base-vertex"],
+                             stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  if dp_result.returncode != 0:
+    LOG.critical("Failed to compile draw parameters: " + dp_result.stderr.decode('utf-8'))
+    error = True
+  else:
+    if "gl_BaseVertexARB" not in (dp_out_dir / 'draw_parameters.vs.430.glsl').read_text() or \
+       "[[base_vertex]]" not in (dp_out_dir / 'draw_parameters.vs.21ios.msl').read_text():
+      LOG.critical("Draw parameters weren't translated")
+      error = True
+    metadata_json = subprocess.run([str(jsonizer_binary), str(dp_out_dir / 'draw_parameters.pipeline')], stdout = subprocess.PIPE).stdout
+    draw_parameters = json.loads(metadata_json)["draw_parameters"]
+    # base vertex | base instance.
+    if draw_parameters != 0x3:
+      LOG.critical("Unexpected draw parameters: " + str(draw_parameters))
+      error = True
+
+  LOG.info("Compiling for GLES 3.0")
+  gles_out_dir = out_dir / 'gles300'
+  subprocess.run([str(compiler_binary), str(source_hlsl / 'spec_const_as_array_idx.hlsl'),
+                  "-t", "gles300", "-O", str(gles_out_dir)], stdout = subprocess.PIPE, timeout = 60)
+  metadata_json = subprocess.run([str(jsonizer_binary), str(gles_out_dir / 'blur.pipeline')], stdout = subprocess.PIPE).stdout
+  binding_fixups = json.loads(metadata_json)["binding_fixups"]
+  if binding_fixups != [ { "type": 0, "native_binding": 0, "name": "type_BlurData" },
+                         { "type": 5, "native_binding": 0, "name": "tex_bilinearSamp" } ]:
+    LOG.critical("Unexpected binding fixups: " + str(binding_fixups))
+    error = True
+
+  LOG.info("Pruning techniques with a usage profile")
+  profile_out_dir = out_dir / 'usage_profile'
+  profile_out_dir.mkdir()
+  profile_path = profile_out_dir / 'profile.txt'
+  profile_path.write_text("# recorded usage\n"
+                          "relative-luminance INPUT_NEEDS_GAMMA_CORRECTION=1\n"
+                          "relative-luminance-srgb-texture OUTPUT_NEEDS_GAMMA_CORRECTION=1\n"
+                          "relative-luminance-srgb-framebuffer INPUT_NEEDS_GAMMA_CORRECTION=0\n")
+  profile_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'), "-t", "spv",
+                                   "-O", str(profile_out_dir), "--usage-profile", str(profile_path),
+                                   "--always-build", "relative-luminance-srgb-texture-and-*"],
+                                  stdout = subprocess.PIPE, timeout = 60, universal_newlines = True)
+  built_techniques = sorted(p.stem for p in profile_out_dir.glob('*.pipeline'))
+  if built_techniques != ["relative-luminance", "relative-luminance-srgb-texture",
+                          "relative-luminance-srgb-texture-and-framebuffer"]:
+    LOG.critical("Unexpected techniques built with a usage profile: " + str(built_techniques))
+    error = True
+  if "built 3 of 4 techniques" not in profile_result.stdout or \
+     "profile.txt:4: relative-luminance-srgb-framebuffer" not in profile_result.stdout:
+    LOG.critical("Unexpected usage profile report:\n" + profile_result.stdout)
+    error = True
+
+  LOG.info("Checking for errors")
+  check_out_dir = out_dir / 'check'
+  check_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'),
+                                 "-O", str(check_out_dir), "--check"],
+                                stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                universal_newlines = True)
+  if check_result.returncode != 0 or check_result.stdout != "" or check_out_dir.exists():
+    LOG.critical("Unexpected result of checking a valid file: " + check_result.stdout + check_result.stderr)
+    error = True
+  check_input = out_dir / 'check_errors.hlsl'
+  check_input.write_text("//T: broken vs:VSMain ps:PSMain\n"
+                         "float4 VSMain() : SV_Position { return 0; }\n"
+                         "float4 PSMain() : SV_Target { return undefined_thing; }\n")
+  check_result = subprocess.run([str(compiler_binary), str(check_input), "--check"],
+                                stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                universal_newlines = True)
+  check_diagnostics = [json.loads(line) for line in check_result.stdout.splitlines()]
+  if check_result.returncode == 0 or len(check_diagnostics) != 1 or \
+     (check_diagnostics[0]["line"], check_diagnostics[0]["column"], check_diagnostics[0]["severity"]) != (3, 38, "error") or \
+     "undefined_thing" not in check_diagnostics[0]["message"]:
+    LOG.critical("Unexpected diagnostics: " + check_result.stdout)
+    error = True
+  check_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'invalid_param_FAIL.hlsl'), "--check"],
+                                stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                universal_newlines = True)
+  check_diagnostics = [json.loads(line) for line in check_result.stdout.splitlines()]
+  if check_result.returncode == 0 or len(check_diagnostics) != 1 or check_diagnostics[0]["line"] != 3:
+    LOG.critical("Unexpected technique diagnostics: " + check_result.stdout)
+    error = True
+
+  LOG.info("Reflecting without generating code")
+  reflect_out_dir = out_dir / 'reflect_only'
+  run_all_test_cases(compiler_binary, source_hlsl, reflect_out_dir, ["--reflect-only"])
+  for reflect_file in reflect_out_dir.iterdir():
+    if reflect_file.suffix in ['.pipeline', '.h']:
+      if reflect_file.read_bytes() != (out_dir / reflect_file.name).read_bytes():
+        LOG.critical("Reflect-only output doesn't match a regular build: " + reflect_file.name)
+        error = True
+    elif reflect_file.suffix not in ['.stdout', '.stderr']:
+      LOG.critical("Reflect-only mode generated code: " + reflect_file.name)
+      error = True
+  reflect_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'),
+                                   "--reflect-only", "-O", str(reflect_out_dir / 'no_targets')],
+                                  stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60)
+  if reflect_result.returncode != 0 or len(list((reflect_out_dir / 'no_targets').glob('*.pipeline'))) != 4:
+    LOG.critical("Reflecting without targets failed: " + reflect_result.stderr.decode())
+    error = True
+
+  LOG.info("Compiling in tiers")
+  tiered_out_dir = out_dir / 'tiered'
+  tiered_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'), "-t", "gl430",
+                                  "-t", "msl10", "-O", str(tiered_out_dir), "--tiered"],
+                                 stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                 universal_newlines = True)
+  if tiered_result.returncode != 0 or "Unoptimized build finished" not in tiered_result.stdout:
+    LOG.critical("Tiered build failed: " + tiered_result.stderr)
+    error = True
+  elif "differs between the unoptimized and optimized builds" in tiered_result.stdout:
+    LOG.critical("Unexpected pipeline metadata change between tiers: " + tiered_result.stdout)
+    error = True
+  else:
+    # The optimized outputs replace the unoptimized ones, and match a regular build.
+    for tiered_file in tiered_out_dir.glob('*.pipeline'):
+      metadata_json = subprocess.run([str(jsonizer_binary), str(tiered_file)], stdout = subprocess.PIPE).stdout
+      if json.loads(metadata_json)["compile_tier"] != 0:
+        LOG.critical("Unoptimized output wasn't replaced: " + tiered_file.name)
+        error = True
+    if list(tiered_out_dir.glob('*.tmp')):
+      LOG.critical("Tiered build left temporary files behind")
+      error = True
+    for tiered_file in list(tiered_out_dir.glob('*.glsl')) + list(tiered_out_dir.glob('*.msl')):
+      if tiered_file.read_bytes() != (out_dir / tiered_file.name).read_bytes():
+        LOG.critical("Optimized output doesn't match a regular build: " + tiered_file.name)
+        error = True
+
+  # A texture that is only sampled by dead code is still part of the
+  # unoptimized layout.
+  dead_texture_input = tiered_out_dir / 'dead_texture.hlsl'
+  dead_texture_input.write_text('\n'.join([
+    '//T: dead-texture vs:VSMain ps:PSMain',
+    '#include "' + (source_hlsl / 'inc' / 'triangle.hlsl').as_posix() + '"',
+    'Texture2D tex : register(t0, space0);',
+    'Texture2D dead_tex : register(t2, space0);',
+    'SamplerState samp : register(s1, space0);',
+    'Triangle_PSInput VSMain(uint vid : SV_VertexID) { return Triangle(vid, 1.0); }',
+    'float4 PSMain(Triangle_PSInput ps_in) : SV_TARGET {',
+    '  float4 unused = dead_tex.Sample(samp, ps_in.texcoord);',
+    '  return tex.Sample(samp, ps_in.texcoord);',
+    '}']))
+  dead_texture_result = subprocess.run([str(compiler_binary), str(dead_texture_input), "-t", "gl430",
+                                        "-O", str(tiered_out_dir), "--tiered"],
+                                       stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                       universal_newlines = True)
+  if "technique dead-texture differs between" not in dead_texture_result.stdout:
+    LOG.critical("Pipeline metadata change between tiers wasn't reported: " + dead_texture_result.stdout + dead_texture_result.stderr)
+    error = True
+
+  LOG.info("Rebuilding in watch mode")
+  watch_out_dir = out_dir / 'watch'
+  watch_out_dir.mkdir()
+  watch_input = watch_out_dir / 'relative_luminance.hlsl'
+  watch_source = (source_hlsl / 'relative_luminance.hlsl').read_text()
+  watch_input.write_text(watch_source)
+  watch_output = watch_out_dir / 'relative-luminance.ps.430.glsl'
+  watcher = subprocess.Popen([str(compiler_binary), str(watch_input), "-t", "gl430", "-O", str(watch_out_dir), "--watch"],
+                             stdout = subprocess.PIPE, stderr = subprocess.DEVNULL, universal_newlines = True)
+  try:
+    status = line_reader(watcher.stdout)
+    if status.wait_for("Watching") is None:
+      LOG.critical("Watch mode didn't finish the initial build")
+      error = True
+    else:
+      # An edit saved before the build has started waiting for changes must
+      # not be missed.
+      watch_input.write_text(watch_source.replace("0.2126", "0.2125"))
+      if status.wait_for("Watching", timeout = 10) is None or "0.2125" not in watch_output.read_text():
+        LOG.critical("Watch mode missed an edit saved right after a build")
+        error = True
+  finally:
+    watcher.kill()
+
+  LOG.info("Publishing rebuilt techniques to a hot reload listener")
+  hot_reload_out_dir = out_dir / 'hot_reload'
+  hot_reload_out_dir.mkdir()
+  hot_reload_input = hot_reload_out_dir / 'relative_luminance.hlsl'
+  shutil.copy(str(source_hlsl / 'relative_luminance.hlsl'), str(hot_reload_input))
+  publish_port = str(get_free_port())
+  publisher = subprocess.Popen([str(compiler_binary), str(hot_reload_input), "-t", "gl430", "-O", str(hot_reload_out_dir),
+                                "--watch", "--publish", "127.0.0.1:" + publish_port],
+                               stdout = subprocess.PIPE, stderr = subprocess.DEVNULL, universal_newlines = True)
+  listener = None
+  try:
+    if line_reader(publisher.stdout).wait_for("Watching") is None:
+      LOG.critical("Watch mode didn't finish the initial build")
+      error = True
+    else:
+      listener = subprocess.Popen([str(listener_binary), "127.0.0.1", publish_port],
+                                  stdout = subprocess.PIPE, stderr = subprocess.DEVNULL, universal_newlines = True)
+      updates = line_reader(listener.stdout)
+      # New subscribers first receive every technique built so far.
+      if any(updates.wait_for("technique ") is None for _ in range(4)):
+        LOG.critical("Hot reload listener wasn't brought up to date")
+        error = True
+      else:
+        time.sleep(1)
+        hot_reload_input.write_text(hot_reload_input.read_text().replace("0.2126", "0.2125"))
+        technique_line = updates.wait_for("technique relative-luminance-srgb-texture-and-framebuffer")
+        file_line = updates.wait_for("  relative-luminance-srgb-texture-and-framebuffer.ps.430.glsl")
+        if technique_line is None or file_line is None:
+          LOG.critical("Hot reload listener didn't receive the rebuilt technique")
+          error = True
+        else:
+          published_file = hot_reload_out_dir / file_line.split()[0]
+          if "0.2125" not in published_file.read_text() or \
+             file_line.split()[3] != hashlib.sha256(published_file.read_bytes()).hexdigest():
+            LOG.critical("Hot reload listener received a stale technique: " + file_line)
+            error = True
+  finally:
+    publisher.kill()
+    if listener is not None:
+      listener.kill()
+
+  LOG.info("Delivering hot reload updates sent before disconnecting")
+  # A publisher that goes away right after sending its updates: the listener
+  # must still receive all of them before noticing the disconnect.
+  with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as closing_publisher:
+    closing_publisher.bind(("127.0.0.1", 0))
+    closing_publisher.listen()
+    listener = subprocess.Popen([str(listener_binary), "127.0.0.1", str(closing_publisher.getsockname()[1])],
+                                stdout = subprocess.PIPE, stderr = subprocess.PIPE, universal_newlines = True)
+    conn, _ = closing_publisher.accept()
+    def wire_string(data):
+      return struct.pack('>I', len(data)) + data
+    metadata = (goldens / 'relative-luminance.pipeline').read_bytes()
+    with conn:
+      for name in [b'first', b'second', b'third']:
+        message = struct.pack('>I', 1) + wire_string(name) + struct.pack('>I', 0) + \
+                  wire_string(hashlib.sha256(metadata).hexdigest().encode()) + wire_string(metadata)
+        conn.sendall(wire_string(message))
+  try:
+    listener_stdout, _ = listener.communicate(timeout = 30)
+  except subprocess.TimeoutExpired:
+    listener.kill()
+    listener_stdout, _ = listener.communicate()
+  if [line for line in listener_stdout.splitlines() if line.startswith("technique ")] != \
+     ["technique first", "technique second", "technique third"]:
+    LOG.critical("Hot reload listener lost updates sent before the publisher disconnected: " + listener_stdout)
+    error = True
+
+  LOG.info("Instrumenting shaders")
+  # Run from the tests folder, so that the counter map refers to the source by a relative path.
+  instrumented_out_dir = out_dir / 'instrumented'
+  instrumented_result = subprocess.run(
+      compiler_cmdline(compiler_binary, pathlib.Path('source_hlsl') / 'spec_const_as_array_idx.hlsl',
+                       instrumented_out_dir, ["--instrument"]),
+      cwd = str(cwd), stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60, universal_newlines = True)
+  if instrumented_result.returncode != 0:
+    LOG.critical("Instrumenting shaders failed: " + instrumented_result.stderr)
+    error = True
+  else:
+    metadata_json = subprocess.run([str(jsonizer_binary), str(instrumented_out_dir / 'blur.pipeline')],
+                                   stdout = subprocess.PIPE).stdout
+    (instrumented_out_dir / 'blur.json').write_bytes(metadata_json)
+    counter_map = json.loads((instrumented_out_dir / 'blur.counters.json').read_text())
+    if json.loads(metadata_json)["instrumentation"]["ncounters"] != len(counter_map["counters"]):
+      LOG.critical("Instrumentation metadata doesn't match the counter map")
+      error = True
+    error = not compare_outputs(LOG, goldens / 'instrumented', instrumented_out_dir, []) or error
+
+  if platform.system() != 'Windows':
+    LOG.info("Compiling in worker processes")
+    processes_out_dir = out_dir / 'processes'
+    processes_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'),
+                                       "-t", "gl430", "-t", "msl10", "-O", str(processes_out_dir),
+                                       "--processes", "3"],
+                                      stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                      universal_newlines = True)
+    if processes_result.returncode != 0:
+      LOG.critical("Compiling in worker processes failed: " + processes_result.stderr)
+      error = True
+    else:
+      for processes_file in list(processes_out_dir.glob('*.glsl')) + list(processes_out_dir.glob('*.msl')):
+        if processes_file.read_bytes() != (out_dir / processes_file.name).read_bytes():
+          LOG.critical("Output compiled in worker processes doesn't match: " + processes_file.name)
+          error = True
+
+    LOG.info("Recovering from a stuck worker process")
+    # The input is only written once the single worker process has been
+    # stopped, so its first job times out, and has to be retried on the
+    # worker that replaces it.
+    recovery_out_dir = out_dir / 'processes_recovery'
+    recovery_proc = subprocess.Popen([str(compiler_binary), "-", "-t", "gl430", "-O", str(recovery_out_dir),
+                                      "--processes", "1", "--compile-timeout", "1000"],
+                                     stdin = subprocess.PIPE, stdout = subprocess.PIPE, stderr = subprocess.PIPE,
+                                     universal_newlines = True)
+    worker_pids = []
+    deadline = time.time() + 30
+    while not worker_pids and time.time() < deadline:
+      worker_pids = subprocess.run(["pgrep", "-P", str(recovery_proc.pid)], stdout = subprocess.PIPE,
+                                   universal_newlines = True).stdout.split()
+      time.sleep(0.01)
+    for worker_pid in worker_pids:
+      os.kill(int(worker_pid), signal.SIGSTOP)
+    try:
+      recovery_stdout, recovery_stderr = recovery_proc.communicate((source_hlsl / 'relative_luminance.hlsl').read_text(), timeout = 60)
+    except subprocess.TimeoutExpired:
+      recovery_proc.kill()
+      recovery_stdout, recovery_stderr = recovery_proc.communicate()
+    if len(worker_pids) != 1 or recovery_proc.returncode != 0 or "retrying the job" not in recovery_stderr:
+      LOG.critical("Compile job wasn't retried after its worker process got stuck: " + recovery_stderr)
+      error = True
+    else:
+      for recovery_file in recovery_out_dir.glob('*.glsl'):
+        if recovery_file.read_bytes() != (out_dir / recovery_file.name).read_bytes():
+          LOG.critical("Output compiled after restarting a worker process doesn't match: " + recovery_file.name)
+          error = True
+
+  LOG.info("Fuzzing the metadata loader")
+  fuzzer_binary = cwd / '..' / 'samples' / ('fuzz_metadata' + exe_ext)
+  fuzz_result = subprocess.run([str(fuzzer_binary)] + sorted(str(p) for p in goldens.glob('*.pipeline')),
+                               stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 300)
+  if fuzz_result.returncode != 0:
+    LOG.critical("Metadata loader fuzzing failed with code " + str(fuzz_result.returncode) + ":\n" +
+                 fuzz_result.stderr.decode())
+    error = True
+
+  LOG.info("Batch loading metadata")
+  batch_loader_binary = cwd / '..' / 'samples' / ('batch_load_metadata' + exe_ext)
+  golden_pipelines = sorted(str(p) for p in goldens.glob('*.pipeline'))
+  for mode in [[], ["--threads"]]:
+    batch_result = subprocess.run([str(batch_loader_binary)] + mode + golden_pipelines,
+                                  stdout = subprocess.PIPE, timeout = 60, universal_newlines = True)
+    nloaded = sum(1 for line in batch_result.stdout.splitlines() if line.endswith(")") and ": ok (" in line)
+    if batch_result.returncode != 0 or nloaded != len(golden_pipelines):
+      LOG.critical("Batch loading failed:\n" + batch_result.stdout)
+      error = True
+
+  LOG.info("Running the metadata loader benchmark")
+  bench_binary = cwd / '..' / 'samples' / ('bench_metadata' + exe_ext)
+  bench_out_dir = out_dir / 'bench'
+  bench_out_dir.mkdir()
+  bench_result = subprocess.run([str(bench_binary), "--iterations", "10", "--output", str(bench_out_dir / 'bench.json'),
+                                 "--write-files", str(bench_out_dir)], stderr = subprocess.PIPE, timeout = 120)
+  if bench_result.returncode != 0:
+    LOG.critical("Benchmark failed: " + bench_result.stderr.decode())
+    error = True
+  else:
+    bench_shapes = [shape["name"] for shape in json.loads((bench_out_dir / 'bench.json').read_text())["shapes"]]
+    for shape in bench_shapes:
+      if subprocess.run([str(jsonizer_binary), str(bench_out_dir / (shape + '.pipeline'))],
+                        stdout = subprocess.DEVNULL).returncode != 0:
+        LOG.critical("Generated benchmark input " + shape + " doesn't load")
+        error = True
+
+  LOG.info("Collecting memory statistics")
+  mem_stats_file = out_dir / 'mem_stats.json'
+  subprocess.run([str(compiler_binary), str(alias_input), "-t", "msl12", "-t", "spv",
+                  "-O", str(out_dir / 'mem_stats'), "--mem-stats", str(mem_stats_file)],
+                 cwd = str(source_hlsl), stdout = subprocess.PIPE, timeout = 60)
+  mem_stats = json.loads(mem_stats_file.read_text())
+  for phase in ["parse", "dxc", "reflection", "cross_compile", "write"]:
+    if mem_stats["phases"][phase]["allocations"] == 0:
+      LOG.critical("No allocations counted for phase " + phase)
+      error = True
+  if mem_stats["peak_rss_bytes"] == 0:
+    LOG.critical("Peak RSS not reported")
+    error = True
+
+  LOG.info("Collecting performance counters")
+  perf_out_dir = out_dir / 'perf_counters'
+  perf_out_dir.mkdir()
+  perf_modes = [[]] if platform.system() == 'Windows' else [[], ["--processes", "2"]]
+  for mode in perf_modes:
+    perf_result = subprocess.run([str(compiler_binary), str(source_hlsl / 'relative_luminance.hlsl'), "-t", "gl430",
+                                  "-O", str(perf_out_dir), "--perf-counters"] + mode,
+                                 stdout = subprocess.PIPE, stderr = subprocess.PIPE, timeout = 60,
+                                 universal_newlines = True)
+    # The counters may not be available on the machine running the tests.
+    if perf_result.returncode != 0 or \
+       ("Performance counters:" not in perf_result.stdout and
+        "--perf-counters is ignored" not in perf_result.stdout):
+      LOG.critical("Performance counters weren't reported: " + perf_result.stdout + perf_result.stderr)
+      error = True
+    elif "Performance counters:" in perf_result.stdout and \
+         (" total " not in perf_result.stdout or
+          (mode != []) != ("preprocessing only" in perf_result.stdout)):
+      LOG.critical("Unexpected performance counter report: " + perf_result.stdout)
+      error = True
   if error:
     sys.exit(1)
   LOG.info("Done!")
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "usage_profile.h"
+
+#include "file_utils.h"
+
+#include <algorithm>
+#include <sstream>
+
+bool load_usage_profile(const char *path, usage_profile &profile,
+                        std::string &error) {
+  std::string contents;
+  if (!try_read_file(path, contents)) {
+    error = std::string("Failed to open usage profile ") + path;
+    return false;
+  }
+  profile.path = path;
+  profile.entries.clear();
+  std::istringstream lines(contents);
+  std::string line;
+  for (uint32_t line_num = 1u; std::getline(lines, line); ++line_num) {
+    const size_t comment = line.find('#');
+    if (comment != std::string::npos) line.resize(comment);
+    std::istringstream words(line);
+    usage_profile_entry entry { {}, {}, line_num };
+    if (!(words >> entry.technique_name)) continue; // Empty line.
+    std::string define;
+    while (words >> define) {
+      const size_t eq = define.find('=');
+      if (eq == 0u) {
+        error = std::string(path) + ":" + std::to_string(line_num) +
+                ": expected a define name before `='";
+        return false;
+      }
+      if (eq == std::string::npos) {
+        entry.defines.emplace_back(define, std::string());
+      } else {
+        entry.defines.emplace_back(define.substr(0u, eq),
+                                   define.substr(eq + 1u));
+      }
+    }
+    profile.entries.emplace_back(std::move(entry));
+  }
+  return true;
+}
+
+namespace {
+
+// Returns the value a technique gives to a define. Later definitions
+// override earlier ones, as they do when passed to the compiler.
+const std::string* find_define(const define_container &defines,
+                               const std::string &name) {
+  const auto it = std::find_if(defines.rbegin(), defines.rend(),
+                               [&name](const auto &d) {
+                                 return d.first == name;
+                               });
+  return it == defines.rend() ? nullptr : &it->second;
+}
+
+bool refers_to(const usage_profile_entry &entry, const technique &tech) {
+  if (entry.technique_name != tech.name) return false;
+  for (const auto &d : entry.defines) {
+    const std::string *value = find_define(tech.defines, d.first);
+    if (value == nullptr || *value != d.second) return false;
+  }
+  return true;
+}
+
+bool always_built(const usage_profile &profile, const std::string &name) {
+  for (const std::string &pattern : profile.always_build) {
+    const bool is_prefix = !pattern.empty() && pattern.back() == '*';
+    const size_t prefix_size = pattern.size() - 1u;
+    if (is_prefix ? name.compare(0u, prefix_size, pattern, 0u,
+                                 prefix_size) == 0
+                  : name == pattern) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+usage_pruning_result prune_techniques(const usage_profile &profile,
+                                      std::vector<technique> &techniques) {
+  usage_pruning_result result;
+  std::vector<bool> entry_used(profile.entries.size(), false);
+  std::vector<technique> kept;
+  for (technique &tech : techniques) {
+    bool referenced = false;
+    for (size_t e = 0u; e < profile.entries.size(); ++e) {
+      if (refers_to(profile.entries[e], tech)) {
+        entry_used[e] = true;
+        referenced = true;
+      }
+    }
+    if (referenced || always_built(profile, tech.name)) {
+      kept.emplace_back(std::move(tech));
+    } else {
+      result.pruned_techniques.push_back(tech.name);
+    }
+  }
+  for (size_t e = 0u; e < profile.entries.size(); ++e) {
+    if (!entry_used[e]) result.unmatched_entries.push_back(&profile.entries[e]);
+  }
+  techniques = std::move(kept);
+  result.nkept = techniques.size();
+  return result;
+}
+
+void print_usage_pruning_report(FILE *f, const usage_profile &profile,
+                                const usage_pruning_result &result) {
+  fprintf(f, "Usage profile: built %zu of %zu techniques\n", result.nkept,
+          result.nkept + result.pruned_techniques.size());
+  if (!result.pruned_techniques.empty()) {
+    fprintf(f, "Techniques not referenced by the usage profile:\n");
+    for (const std::string &name : result.pruned_techniques) {
+      fprintf(f, "  %s\n", name.c_str());
+    }
+  }
+  if (!result.unmatched_entries.empty()) {
+    fprintf(f, "Usage profile entries that don't refer to any technique:\n");
+    for (const usage_profile_entry *e : result.unmatched_entries) {
+      fprintf(f, "  %s:%u: %s", profile.path.c_str(), e->line,
+              e->technique_name.c_str());
+      for (const auto &d : e->defines) {
+        fprintf(f, " %s=%s", d.first.c_str(), d.second.c_str());
+      }
+      fprintf(f, "\n");
+    }
+  }
+}
@@ -0,0 +1,76 @@
+/**
+ * Copyright (c) 2020 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "shader_defines.h"
+#include "technique_parser.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// A combination of a technique and define values that the runtime reported
+// as requested.
+struct usage_profile_entry {
+  std::string technique_name;
+  define_container defines;
+  uint32_t line;
+};
+
+// Which techniques need to be built. A technique is built if an entry of the
+// profile refers to it, or if its name is on the always-build list.
+struct usage_profile {
+  std::string path;
+  std::vector<usage_profile_entry> entries;
+  // Technique names that are built regardless of the profile. A name ending
+  // with `*' matches all techniques starting with the part before it.
+  std::vector<std::string> always_build;
+
+  bool enabled() const { return !path.empty(); }
+};
+
+// Reads a usage profile. Each line holds a technique name, optionally
+// followed by whitespace-separated `NAME=VALUE' define values; `#' starts a
+// comment. Returns false and sets `error' if the file can't be read or is
+// malformed.
+bool load_usage_profile(const char *path, usage_profile &profile,
+                        std::string &error);
+
+// Outcome of pruning techniques with a usage profile.
+struct usage_pruning_result {
+  std::vector<std::string> pruned_techniques;
+  std::vector<const usage_profile_entry*> unmatched_entries;
+  size_t nkept = 0u;
+};
+
+// Removes the techniques that the profile doesn't refer to. An entry refers
+// to a technique if the names are equal and every define value listed by the
+// entry is what the technique defines.
+usage_pruning_result prune_techniques(const usage_profile &profile,
+                                      std::vector<technique> &techniques);
+
+// Prints the techniques that were left out of the build, and the profile
+// entries that don't refer to any technique.
+void print_usage_pruning_report(FILE *f, const usage_profile &profile,
+                                const usage_pruning_result &result);